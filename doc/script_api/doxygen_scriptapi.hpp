@@ -98,6 +98,20 @@ namespace Annwvyn
 		///ScriptFunction: restore the gravity vector
 		void AnnRestoreGravity();
 
+		///ScriptFunction: enable or disable the script profiler. It records the calls to update() and to the event hooks of every script
+		/// \param state True to enable the profiler
+		void AnnScriptProfilerEnable(bool state);
+
+		///ScriptFunction: forget everything recorded by the script profiler
+		void AnnScriptProfilerReset();
+
+		///ScriptFunction: write the script profiler records as CSV (script, owner, hook, calls, total, average and max time in milliseconds)
+		/// \param path Path of the file to write
+		bool AnnScriptProfilerDump(std::string path);
+
+		///ScriptFunction: log the script hooks where the most time was spent
+		void AnnScriptProfilerReport();
+
 		///ScriptFunction: Jump the level manager to another level
 		/// \param id The ID number of the level
 		void AnnJumpLevel(level_id id);
@@ -270,6 +284,9 @@ namespace Annwvyn
 
 			///Play a sound
 			void playSound(std::string name, bool loop = true);
+
+			///Get the time in seconds since the last update of this object. Can be more than one frame if the update LOD is enabled
+			double getUpdateDeltaTime();
 		};
 
 		///Collision between 2 game objects
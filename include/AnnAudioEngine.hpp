@@ -15,10 +15,18 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <array>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
 
 //OpenAl
 #include <al.h>
 #include <alc.h>
+#include <alext.h>
 
 //libsndfile
 #include <sndfile.h>
@@ -33,7 +41,8 @@ namespace Annwvyn
 	class AnnEngine;
 	class AnnAudioEngine;
 
-	///Represent an audio source in the engine
+	///Represent an audio source in the engine. The source only holds an OpenAL source (a "voice") while it is one of the most audible sounds.
+	///Other playing sources are virtual : they keep their playback position, but make no sound
 	class AnnDllExport AnnAudioSource
 	{
 	public:
@@ -47,41 +56,227 @@ namespace Annwvyn
 		void setPositon(AnnVect3 position);
 		///Set the volume at the given gain (between 0 & 1)
 		/// \param gain value between 0 and 1
-		void setVolume(float gain) const;
+		void setVolume(float gain);
 		///Put the audio read position at the origin
-		void rewind() const;
+		void rewind();
 		///Play the sound
-		void play() const;
+		void play();
 		///Pause the sound
-		void pause() const;
+		void pause();
 		///Stop playing the sound
-		void stop() const;
+		void stop();
 		///Change the sound buffer this source plays
 		void changeSound(std::string name);
 
 		///If looping is activated, the sound will replay when finished
-		void setLooping(bool looping = true) const;
+		void setLooping(bool looping = true);
 		///If true, the sound position will use (and update) the player's current position as origin
 		void setPositionRelToPlayer(bool relToPlayer = true);
 
+		///Set how important this sound is when choosing which sounds get a voice. 1 by default, the audibility of the sound is multiplied by it
+		void setPriority(float priority);
+		///Get the priority of the sound
+		float getPriority() const;
+
+		///Return true if the sound is playing, even if it's virtual
+		bool isPlaying() const;
+		///Return true if the sound is playing without an OpenAL source
+		bool isVirtual() const;
+
 	private:
 		friend class AnnAudioEngine;
+
+		///Playback state
+		enum class State { Stopped, Playing, Paused };
+
 		///Name of the buffer (filename)
 		std::string bufferName;
-		///OpenAL source object
-		ALuint source;
+		///True if this source holds a reference to the bufferName buffer in the cache
+		bool holdsBuffer;
+		///Engine that created this source. Set to nullptr when the engine shuts down
+		AnnAudioEngine* engine;
+		///OpenAL buffer played
+		ALuint buffer;
+		///Length of the buffer in seconds
+		float duration;
+		///OpenAL source object from the voice pool. 0 when virtual
+		ALuint voice;
+		///Index of the voice in the pool
+		size_t voiceIndex;
+		///First command batch that reflects the last play/stop of this source. Older feedback from the audio thread is ignored
+		uint64_t voiceSyncBatch;
 		///Position of this source
 		AnnVect3 pos;
 		///Relative to player, or not
 		bool posRelToPlayer;
+		///Gain of the sound
+		float gain;
+		///Looping state
+		bool looping;
+		///Audibility multiplier
+		float priority;
+		///Playback state
+		State state;
+		///Playback position in seconds, advanced by the engine while virtual
+		float playbackOffset;
+		///Audibility computed during the last voice assignment
+		float audibility;
+		///Index in the engine source registry
+		size_t registryIndex;
 	};
 
 	using AnnAudioSourcePtr = std::shared_ptr<AnnAudioSource>;
 
+	///Audio source that plays long files (music...) without decoding them in memory. A thread keeps a few OpenAL buffers decoded ahead of playback
+	class AnnDllExport AnnAudioStream
+	{
+	public:
+		///Number of buffers queued on the source
+		static constexpr size_t bufferCount { 4 };
+
+		///Duration of audio decoded in each buffer
+		static constexpr unsigned bufferMilliseconds { 100 };
+
+		///You have to call AnnAudioEngine::createStream() to get an AnnAudioStream object
+		AnnAudioStream();
+
+		///Stop the streaming thread and free the OpenAL objects
+		~AnnAudioStream();
+
+		AnnAudioStream(const AnnAudioStream&) = delete;
+		AnnAudioStream& operator=(const AnnAudioStream&) = delete;
+
+		///Start playing a file from the start. Stop what was playing before.
+		/// \param filename Name of the audio file
+		/// \param loop If true, restart the file when it ends
+		void play(const std::string& filename, bool loop = false);
+
+		///Play a file right after the current one ends, even if it loops, with no gap if both have the same number of channels and sample-rate. Replace the file queued before
+		/// \param filename Name of the audio file
+		/// \param loop If true, the new file will loop once it plays
+		void queueNext(const std::string& filename, bool loop = false);
+
+		///Stop playing and forget the queued file
+		void stop();
+
+		///Set the volume at the given gain (between 0 & 1)
+		void setVolume(float gain) const;
+
+		///Return true if the stream has something to play
+		bool isPlaying() const;
+
+		///Stop the streaming thread and free the OpenAL objects. Done by the audio engine before closing the OpenAL context
+		void shutdown();
+
+	private:
+		///Body of the streaming thread
+		void streamThreadLoop();
+
+		///Decode the next chunk of audio in the buffer, going to the next file or looping as needed. Return false if there's nothing to put in it
+		bool fill(ALuint buffer);
+
+		///Fill and queue all the buffers, then play
+		void prime();
+
+		///Unqueue all the buffers from the stopped source
+		void clearQueue() const;
+
+		///Load the file and open a decoder on it. nullptr if it's not a usable audio file
+		static std::unique_ptr<AnnAudioFileDecoder> openDecoder(const std::string& filename);
+
+		///OpenAL source object
+		ALuint source;
+
+		///Buffers cycled through the source queue
+		std::array<ALuint, bufferCount> buffers;
+
+		///File being played, and file that will be played after
+		std::unique_ptr<AnnAudioFileDecoder> current, next;
+
+		///Loop state of the current and next file
+		bool loopCurrent, loopNext;
+
+		///Decoded samples waiting to be uploaded. Never bigger than a buffer
+		std::vector<int16_t> chunk;
+
+		///The streaming thread
+		std::thread streamThread;
+
+		///Protect everything above from the streaming thread
+		mutable std::mutex streamMutex;
+
+		///Wake up the streaming thread
+		std::condition_variable wakeUp;
+
+		///The streaming thread runs while this is true
+		bool running;
+
+		///True if there's something to play
+		bool playing;
+	};
+
+	using AnnAudioStreamPtr = std::shared_ptr<AnnAudioStream>;
+
+	///Progress of an asynchronous preload of sound files. Updated on the main thread
+	class AnnDllExport AnnAudioPreloadProgress
+	{
+	public:
+		///Construct a progress report for this number of files
+		AnnAudioPreloadProgress(size_t fileCount);
+
+		///Number of files in this preload
+		size_t getFileCount() const;
+
+		///Number of files successfully loaded so far
+		size_t getLoadedCount() const;
+
+		///Number of files that could not be loaded
+		size_t getFailedCount() const;
+
+		///Return true when every file has been handled
+		bool isFinished() const;
+
+		///Get the progress between 0 and 1
+		float getProgress() const;
+
+	private:
+		friend class AnnAudioEngine;
+
+		///Counters
+		size_t fileCount, loadedCount, failedCount;
+	};
+
+	using AnnAudioPreloadProgressPtr = std::shared_ptr<AnnAudioPreloadProgress>;
+
+	///Statistics of the sound buffer cache
+	struct AnnAudioBufferCacheStats
+	{
+		///Number of loadBuffer() calls that found the buffer already loaded
+		size_t hits;
+		///Number of loadBuffer() calls that had to decode the file
+		size_t misses;
+		///Number of buffers freed to stay under the budget
+		size_t evictions;
+		///Number of buffers in the cache
+		size_t bufferCount;
+		///Bytes of PCM data held by the buffers in the cache
+		size_t residentBytes;
+		///Maximum number of bytes the cache tries to hold. 0 means no limit
+		size_t budget;
+	};
+
 	///Class that handle the OpenAL audio.
 	class AnnDllExport AnnAudioEngine : public AnnSubSystem
 	{
 	public:
+		///Called on the main thread when an asynchronously loaded buffer is ready. The buffer is 0 if the file couldn't be loaded
+		using BufferReadyCallback = std::function<void(const std::string& filename, ALuint buffer)>;
+
+		///Public static parameter : render audio in memory on an ALC_SOFT_loopback device instead of opening a sound card, to run without audio hardware.
+		///Please set it before AnnInit or creating an AnnEngine object
+		/// \param sampleRate Sample-rate of the rendered 16bit stereo audio. 0 opens a sound card again
+		static void setLoopbackRendering(unsigned sampleRate = 48000);
+
 		///class constructor
 		AnnAudioEngine();
 
@@ -109,21 +304,50 @@ namespace Annwvyn
 		/// \copydoc loadBuffer()
 		void preLoadBuffer(const std::string& filename);
 
+		///Load sound files into buffers without stalling the game. Files are read and decoded in parallel by the TaskManager workers,
+		///only the upload of the samples to OpenAL is done on the main thread.
+		/// \param filenames Names of the files you want to load
+		/// \param onReady Called on the main thread for each file, when it's loaded or failed to load. Called right away for files already loaded
+		///loadBuffer() on a file that is still being decoded finishes that work instead of reading the file again
+		AnnAudioPreloadProgressPtr preLoadBuffersAsync(const std::vector<std::string>& filenames, BufferReadyCallback onReady = nullptr);
+
+		///Load a sound file into a buffer without stalling the game
+		/// \copydetails preLoadBuffersAsync()
+		AnnAudioPreloadProgressPtr preLoadBufferAsync(const std::string& filename, BufferReadyCallback onReady = nullptr);
+
 		///Return "false" if buffer not loaded. Return buffer index if buffer is loaded.
 		ALuint isBufferLoader(const std::string& filename);
 
-		///Unload a buffer from the engine. The buffer is identified by the sound file it represent
+		///Unload a buffer from the engine. The buffer is identified by the sound file it represent. If audio sources still use it, it is unloaded when the last one stops using it
 		/// \param filename Path of the file you want to load
 		void unloadBuffer(const std::string& filename);
 
+		///Set how many bytes of decoded audio buffers are kept around. When over the budget, the least recently used buffers no source is using are unloaded.
+		/// \param bytes Size of the budget, 0 (the default) means no limit
+		void setBufferCacheBudget(size_t bytes);
+
+		///Get the budget of the buffer cache in bytes. 0 means no limit
+		size_t getBufferCacheBudget() const;
+
+		///Get hits, misses, and memory usage of the buffer cache
+		AnnAudioBufferCacheStats getBufferCacheStats() const;
+
 		///play background music. you can specify the volume of the music (0.0f to 1.0f)
 		/// \param filename name of the audio file to use as background music
 		/// \param volume Float number between 0 and 1, Loudness of the sound. At 0.5f by default
 		void playBGM(const std::string& filename, float volume = 0.5f);
 
+		///Play this file when the current background music reaches its end, instead of looping it, with no gap.
+		/// \param filename name of the audio file to use as background music
+		/// \param loop if true, the new music will loop
+		void queueBGM(const std::string& filename, bool loop = true);
+
 		///stop the current background music from playing
 		void stopBGM() const;
 
+		///Create a streaming audio source, for sounds too long to be fully decoded in memory
+		AnnAudioStreamPtr createStream();
+
 		///Get the last error message that occurred in-engine
 		std::string getLastError() const;
 
@@ -139,14 +363,69 @@ namespace Annwvyn
 		///Write last error text to the log
 		void logError() const;
 
+		///Set the maximum number of OpenAL sources used by audio sources. The most audible sounds get them, others are virtual.
+		///Background music and other streams are not counted
+		void setVoiceLimit(size_t voices);
+
+		///Get the maximum number of OpenAL sources used by audio sources
+		size_t getVoiceLimit() const;
+
+		///Set the audibility under which a playing sound is virtualized even if there is a free voice. Audibility is gain * priority / distance
+		void setAudibilityThreshold(float threshold);
+
+		///Get the audibility under which a playing sound is virtualized
+		float getAudibilityThreshold() const;
+
+		///Get the number of sounds currently playing with an OpenAL source
+		size_t getRealVoiceCount() const;
+
+		///Get the number of sounds currently playing without an OpenAL source
+		size_t getVirtualVoiceCount() const;
+
+		///Return true if the audio is rendered in memory instead of played
+		bool isLoopback() const;
+
+		///Get the sample-rate of the loopback rendering. 0 if not rendering in memory
+		unsigned getLoopbackSampleRate() const;
+
+		///Apply all pending changes and render this number of frames right away. Only in loopback mode. Blocks until the samples are rendered
+		void renderLoopback(size_t frameCount);
+
+		///Take the 16bit stereo samples rendered so far. Only the last seconds are kept if nobody takes them
+		std::vector<int16_t> takeLoopbackSamples();
+
+		///Get the number of frames rendered since the start in loopback mode
+		size_t getRenderedFrameCount() const;
+
+		///Get the time spent mixing the loopback audio, in milliseconds
+		double getLoopbackRenderTime() const;
+
 	private:
+		///An OpenAL buffer in the cache
+		struct BufferCacheEntry
+		{
+			///OpenAL buffer
+			ALuint buffer;
+			///Size of the PCM data
+			size_t bytes;
+			///Number of sources using this buffer
+			size_t references;
+			///Value of useCounter when last used
+			uint64_t lastUse;
+			///unloadBuffer() was called while sources were using it. Unloaded when the last one releases it
+			bool unloadWhenReleased;
+		};
+
+		///Map between audio filenames and OpenAL buffer
+		std::unordered_map<std::string, BufferCacheEntry> buffers;
+
 		///For the engine: update the listener position to match the player's head
 		/// \param pos The position of the player
 		void updateListenerPos(AnnVect3 pos);
 
 		///For the engine : update the listener orientation to match the player's head
 		/// \param orient The orientation of the player
-		static void updateListenerOrient(AnnQuaternion orient);
+		void updateListenerOrient(AnnQuaternion orient);
 
 		///For engine : update listener Orientation
 		friend class AnnEngine;
@@ -154,9 +433,163 @@ namespace Annwvyn
 		///Update the subsystem : set the listener position
 		void update() override;
 
+		///Advance the playback of virtual sounds, and give the voices to the most audible sounds
+		void updateVoices(AnnVect3 listenerPosition, float deltaTime);
+
+		///Get a voice for this source and start playing it where it is. Return false if the voice limit is reached
+		bool acquireVoice(AnnAudioSource& source);
+
+		///Put the voice of this source back in the pool, keeping the playback position
+		void releaseVoice(AnnAudioSource& source);
+
+		///Queue the position of the voice of this source
+		void applyVoicePosition(const AnnAudioSource& source, AnnVect3 listenerPosition);
+
+		///Get the duration of a buffer in seconds
+		static float getBufferDuration(ALuint buffer);
+
+		///A change of OpenAL state recorded during the frame, applied by the audio thread
+		struct AudioCommand
+		{
+			///What to change
+			enum class Type { AddVoice,
+							  ListenerPosition,
+							  ListenerOrientation,
+							  Position,
+							  Gain,
+							  Looping,
+							  Buffer,
+							  Offset,
+							  Play,
+							  Pause,
+							  Stop,
+							  Rewind,
+							  DeleteBuffer,
+							  Render };
+
+			///What to change
+			Type type;
+			///Voice or buffer this applies to
+			ALuint object;
+			///Integer parameter
+			ALint value;
+			///Float parameters
+			std::array<float, 6> values;
+		};
+
+		///State of a voice read back by the audio thread after a batch
+		struct VoiceFeedback
+		{
+			///AL_SOURCE_STATE
+			ALint state;
+			///AL_SEC_OFFSET
+			float offset;
+		};
+
+		///Record a command for the audio thread
+		void queueCommand(const AudioCommand& command);
+
+		///Give the commands of this frame to the audio thread
+		void submitCommands();
+
+		///Body of the audio thread
+		void audioThreadLoop();
+
+		///Run a command. Called by the audio thread
+		void applyCommand(const AudioCommand& command, std::vector<ALuint>& voices);
+
+		///Apply the remaining commands and stop the audio thread
+		void stopAudioThread();
+
 		///Detect playback devices from the device enumeration string
 		void detectPlaybackDevices(const char* list);
 
+		///Open the sound card and create the context
+		bool openPlaybackDevice();
+
+		///Open a loopback device and create the context
+		bool openLoopbackDevice();
+
+		///Destroy the context and close the device, if they are open. Also leave the loopback mode
+		void closeDevice();
+
+		///Mix audio into the loopback sample buffer. Called by the audio thread
+		void renderLoopbackSamples(size_t frameCount);
+
+		///Get the audio file resource, loading it if needed. Waits for a worker that is reading it. Return a null pointer if it can't be loaded
+		AnnAudioFilePtr getAudioFile(const std::string& filename) const;
+
+		///PCM samples decoded from a file, ready to be given to OpenAL
+		struct DecodedAudio
+		{
+			///Interleaved signed 16bit samples
+			std::vector<int16_t> samples;
+			///Cooked file the samples are read from instead of the vector. Keep the file data loaded until uploaded
+			AnnAudioFilePtr cookedFile;
+			///Header of the cooked file
+			const AnnCookedAudioHeader* cooked { nullptr };
+			///OpenAL format. 0 if the file couldn't be decoded
+			ALenum format { 0 };
+			///Sample-rate in Hz
+			ALsizei sampleRate { 0 };
+			///Error or warning to log
+			std::string message;
+
+			///Get the samples to upload
+			const int16_t* getSamples() const { return cooked ? cooked->getSamples() : samples.data(); }
+			///Get the number of samples to upload
+			size_t getSampleCount() const { return cooked ? cooked->getSampleCount() : samples.size(); }
+		};
+
+		///Decode a whole file. Cooked files are not copied, the samples are used from the file data. Doesn't call OpenAL, can run on any thread
+		static DecodedAudio decode(const AnnAudioFilePtr& file);
+
+		///Create an OpenAL buffer from the decoded audio and register it for that filename. Return the existing buffer if there's one
+		ALuint uploadBuffer(const std::string& filename, const DecodedAudio& audio);
+
+		///A file being read and decoded by preLoadBuffersAsync()
+		struct PendingDecode
+		{
+			///Called when the buffer is ready, or failed to load
+			std::vector<BufferReadyCallback> callbacks;
+			///The decoded file. Written by the thread preparing the file
+			DecodedAudio audio;
+			///True if the file is read and decoded by a worker, false if it's done on the main thread
+			bool onWorker { false };
+			///Set when audio is written, and the file isn't used anymore
+			std::promise<void> done;
+			///Future of done
+			std::shared_future<void> decoded;
+		};
+
+		///Upload an asynchronously decoded file, and tell everyone that was waiting for it. Does nothing if that decode is already finished
+		void finishAsyncLoad(const std::string& filename, const std::shared_ptr<PendingDecode>& pending);
+
+		///Unload the file data of an audio file resource once it has been decoded, if no stream is reading it
+		void releaseAudioFile(const std::string& filename) const;
+
+		///Get the buffer for a source, loading it if needed, and count the source as a user
+		ALuint acquireBuffer(const std::string& filename);
+
+		///A source doesn't use that buffer anymore
+		void releaseBuffer(const std::string& filename);
+
+		///Unload least recently used buffers nobody uses until the cache is under budget
+		/// \param keep Name of a buffer that is never unloaded, because a caller is about to use it
+		void enforceBufferBudget(const std::string& keep = {});
+
+		///Delete the buffer of a cache entry and forget it
+		void eraseBuffer(std::unordered_map<std::string, BufferCacheEntry>::iterator entry);
+
+		///Sources count their buffer uses
+		friend class AnnAudioSource;
+
+		///Files being decoded, by name. Those on a worker are waited for at shutdown as they use the audio file manager
+		std::unordered_map<std::string, std::shared_ptr<PendingDecode>> pendingBuffers;
+
+		///Streams get their files from the engine
+		friend class AnnAudioStream;
+
 		///The last error this class has generated
 		std::string lastError;
 		///AL alDevice
@@ -164,18 +597,85 @@ namespace Annwvyn
 		///AL Context
 		ALCcontext* alContext;
 
-		///Audio buffer for background music
-		ALuint bgmBuffer;
-		///Audio source for background music
-		ALuint bgmSource;
+		///Stream playing the background music
+		AnnAudioStreamPtr bgmStream;
 
-		///Map between audio filenames and OpenAL buffer
-		std::unordered_map<std::string, ALuint> buffers;
+		///Streams created by the engine, to shut them down before the context
+		std::vector<std::weak_ptr<AnnAudioStream>> audioStreams;
+
+		///Incremented each time a buffer is used, to find the least recently used one
+		uint64_t useCounter;
+
+		///Buffer cache budget in bytes. 0 is no limit
+		size_t bufferCacheBudget;
+
+		///Cache statistics
+		size_t residentBytes, cacheHits, cacheMisses, cacheEvictions;
 
 		///Prevent some operation if set to true
 		bool locked;
-		///List of the audio sources object present in the audio engine
-		std::list<AnnAudioSourcePtr> audioSources;
+		///Audio sources present in the audio engine. Each source knows its index, removal swaps it with the last one
+		std::vector<AnnAudioSourcePtr> audioSources;
+
+		///OpenAL sources created for the pool
+		std::vector<ALuint> voicePool;
+		///Index in the pool of the voices not given to any audio source
+		std::vector<size_t> freeVoices;
+		///Maximum number of voices
+		size_t voiceLimit;
+		///Audibility under which sounds are virtualized
+		float audibilityThreshold;
+		///Playing sources, sorted by audibility each frame
+		std::vector<AnnAudioSource*> voiceCandidates;
+		///Listener position at the last update
+		AnnVect3 listenerPosition;
+
+		///Commands recorded during this frame
+		std::vector<AudioCommand> pendingCommands;
+		///Commands given to the audio thread
+		std::vector<AudioCommand> submittedCommands;
+		///Number of batches submitted, and number of batches applied by the audio thread
+		uint64_t submittedBatch, appliedBatch;
+		///Protect submittedCommands and the batch counters
+		std::mutex commandMutex;
+		///Wake up the audio thread
+		std::condition_variable commandReady;
+
+		///State of every voice of the pool after the last applied batch
+		std::vector<VoiceFeedback> voiceFeedback;
+		///Batch the feedback comes from
+		uint64_t feedbackBatch;
+		///Protect voiceFeedback and feedbackBatch
+		std::mutex feedbackMutex;
+		///Copy of the feedback used during updateVoices()
+		std::vector<VoiceFeedback> frameFeedback;
+
+		///Thread that talks to OpenAL for the audio sources and the listener
+		std::thread audioThread;
+		///The audio thread runs while this is true
+		bool audioThreadRunning;
+
+		///AL_SOFT_deferred_updates entry points. nullptr if the extension isn't there
+		LPALDEFERUPDATESSOFT alDeferUpdates;
+		///AL_SOFT_deferred_updates entry points. nullptr if the extension isn't there
+		LPALPROCESSUPDATESSOFT alProcessUpdates;
+
+		///Sample-rate of the loopback device. 0 to use a sound card
+		static unsigned loopbackSampleRate;
+		///Seconds of loopback audio kept when nobody takes it
+		static constexpr unsigned loopbackCapacitySeconds { 10 };
+		///ALC_SOFT_loopback render function. nullptr when playing on a sound card
+		LPALCRENDERSAMPLESSOFT alcRenderSamples;
+		///Fraction of a frame not rendered yet
+		double loopbackFrameCarry;
+		///Rendered 16bit stereo samples
+		std::vector<int16_t> loopbackSamples;
+		///Loopback statistics
+		size_t renderedFrames;
+		///Loopback statistics
+		double renderTime;
+		///Protect the loopback samples and statistics
+		mutable std::mutex loopbackMutex;
 
 		///List of audio device names
 		std::vector<std::string> detectedDevices;
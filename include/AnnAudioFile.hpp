@@ -2,31 +2,49 @@
 
 #include "systemMacro.h"
 #include "AnnTypes.h"
+#include "AnnMappedFile.hpp"
+#include "AnnCookedAudio.hpp"
 
 #include <OgreSharedPtr.h>
 #include <OgreResourceManager.h>
 #include <vector>
 #include <algorithm>
+#include <string>
+#include <cstdint>
+
+#include <sndfile.h>
 
 namespace Annwvyn
 {
 	///Ogre resource that contain the data from a binary file for the audio engine importing
 	class AnnDllExport AnnAudioFile : public Ogre::Resource
 	{
-		///Where the data is actually stored, as bytes.
+		///Where the data is actually stored, as bytes, when it cannot be mapped from disk.
 		std::vector<byte> data;
 
+		///Direct view on the file when it is loose on disk. Nothing is copied, the OS pages it in
+		AnnMappedFile mapping;
+
 		///Read bytes from a data stream and stick them inside the "data" re-sizable array
 		void readFromStream(Ogre::DataStreamPtr& stream);
 
+		///Map the file if it comes from a "FileSystem" archive. Return false if it has to be read from a stream
+		bool mapFromFileSystem();
+
 		///Utility class that perform a static_cast<AnnAudioFile*> on the pointer you give it.
 		inline static AnnAudioFile* cast(void* audioFileRawPtr);
 
 	protected:
-		///Actually load the data
+		///Actually read the data. Can run on a worker
+		void prepareImpl() override;
+
+		///Clear the data read by prepareImpl()
+		void unprepareImpl() override;
+
+		///Nothing to do, the data is read by prepareImpl()
 		void loadImpl() override;
 
-		///Clear the data vector
+		///Clear the data vector and release the mapping
 		void unloadImpl() override;
 
 		///Return the size of the data vector
@@ -49,6 +67,9 @@ namespace Annwvyn
 		///Return the size
 		size_t getSize() const override;
 
+		///Get the header of the file if it is cooked PCM audio, nullptr for any other format
+		const AnnCookedAudioHeader* getCookedHeader() const;
+
 		//Virtual IO interface
 
 		///Structure that will contain function pointers to all the functions defined below
@@ -81,6 +102,70 @@ namespace Annwvyn
 
 	using AnnAudioFilePtr = Ogre::SharedPtr<AnnAudioFile>;
 
+	///Decode an AnnAudioFile with libsndfile. Each decoder has it's own read cursor, so the same file can be decoded by multiple threads at once
+	class AnnDllExport AnnAudioFileDecoder
+	{
+	public:
+		///Open the file. Check isOpen() to know if libsndfile recognized the data. Cooked PCM files are read directly
+		AnnAudioFileDecoder(AnnAudioFilePtr audioFile);
+
+		///Close the libsndfile handle
+		~AnnAudioFileDecoder();
+
+		AnnAudioFileDecoder(const AnnAudioFileDecoder&) = delete;
+		AnnAudioFileDecoder& operator=(const AnnAudioFileDecoder&) = delete;
+
+		///Return true if libsndfile could open the file, or if it's cooked PCM
+		bool isOpen() const;
+
+		///Get the number of channels
+		int getChannels() const;
+
+		///Get the playback sample-rate in Hz
+		int getSampleRate() const;
+
+		///Get the number of frames (one sample per channel) in the file
+		sf_count_t getFrameCount() const;
+
+		///Read up to frameCount frames of interleaved signed 16bit samples. Samples out of range are clipped. Return the number of frames read
+		sf_count_t readFrames(int16_t* output, sf_count_t frameCount);
+
+		///Put the decoder back at the start of the file
+		bool rewind();
+
+		///Get the last libsndfile error message
+		std::string getError() const;
+
+		///Get the file being decoded
+		const AnnAudioFilePtr& getFile() const;
+
+	private:
+		///Virtual I/O callbacks working on the decoder's own cursor
+		static sf_count_t vioGetFileLen(void* decoder);
+		static sf_count_t vioSeek(sf_count_t offset, int whence, void* decoder);
+		static sf_count_t vioRead(void* ptr, sf_count_t count, void* decoder);
+		static sf_count_t vioWrite(const void*, sf_count_t, void*);
+		static sf_count_t vioTell(void* decoder);
+
+		///Function pointers to the callbacks above
+		static SF_VIRTUAL_IO vio;
+
+		///The file. Keep a reference so it can't be unloaded while decoding
+		AnnAudioFilePtr file;
+
+		///Read cursor in the file data
+		sf_count_t offset;
+
+		///Information about the opened file
+		SF_INFO info;
+
+		///Header of a cooked file. The offset above is then counted in frames
+		const AnnCookedAudioHeader* cooked;
+
+		///libsndfile handle
+		SNDFILE* handle;
+	};
+
 	///Audio file ResourceManager
 	class AnnAudioFileManager : public Ogre::ResourceManager, public Ogre::Singleton<AnnAudioFileManager>
 	{
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <systemMacro.h>
+#include <AnnDataLevel.hpp>
+#include <AnnMappedFile.hpp>
+#include <AnnCompiledLevelFormat.hpp>
+
+namespace Annwvyn
+{
+	///Level object loaded from a compiled level file (.annlvl), made by the AnnLevelCompiler tool from a JSON level.
+	///The file is memory mapped and read in place, without any parsing. Use AnnJsonLevel to author levels.
+	class AnnDllExport AnnCompiledLevel : public AnnDataLevel
+	{
+	public:
+		///Construct a level from a compiled level file. Throw if the file is missing or invalid
+		AnnCompiledLevel(std::string path, bool preload = true);
+		///Dtor
+		virtual ~AnnCompiledLevel();
+
+	protected:
+		///Get the number of game objects of the file
+		size_t getObjectCount() const override;
+		///Read a game object of the file
+		ObjectDescription getObject(size_t index) const override;
+		///Create the lights and place the player
+		void finishContent() override;
+
+	private:
+		///Get a string of the file
+		std::string getString(uint32_t index) const;
+		///Get the name of the resource group of a resource location
+		std::string getGroup(const AnnCompiledLevelResource& resource) const;
+
+		///Mapping of the level file
+		AnnMappedFile file;
+		///Header in the mapping
+		const AnnCompiledLevelHeader* header;
+	};
+}
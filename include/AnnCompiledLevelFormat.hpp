@@ -0,0 +1,229 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace Annwvyn
+{
+	///Reference to a string of a compiled level : offset and length in the string data. Strings are interned, each one is stored once
+	struct AnnCompiledLevelString
+	{
+		///Offset in the string data
+		uint32_t offset;
+		///Length of the string (not null terminated)
+		uint32_t length;
+	};
+
+	///Resource location declared by a compiled level. Members are string indices
+	struct AnnCompiledLevelResource
+	{
+		///Resource group. Empty means the default group
+		uint32_t group;
+		///Path to the location
+		uint32_t path;
+		///Archive type ("Zip"...)
+		uint32_t type;
+	};
+
+	///Game object of a compiled level
+	struct AnnCompiledLevelObject
+	{
+		///Physics shapes, same values as phyShapeType
+		enum Shape : uint8_t { StaticShape = 1,
+							   ConvexShape,
+							   BoxShape,
+							   CylinderShape,
+							   CapsuleShape,
+							   SphereShape };
+
+		///String index of the name
+		uint32_t name;
+		///String index of the mesh
+		uint32_t mesh;
+		///Position
+		float position[3];
+		///Orientation (x, y, z, w)
+		float orientation[4];
+		///Scale
+		float scale[3];
+		///Mass of the body
+		float mass;
+		///1 if a rigid body is created
+		uint8_t hasPhysics;
+		///A Shape value
+		uint8_t shape;
+		///1 if the body collides with the player
+		uint8_t playerCollide;
+		///Always 0
+		uint8_t reserved;
+		///Index of the first script in the script table
+		uint32_t firstScript;
+		///Number of scripts
+		uint32_t scriptCount;
+	};
+
+	///Light of a compiled level
+	struct AnnCompiledLevelLight
+	{
+		///Light types
+		enum Type : uint8_t { Point,
+							  Directional,
+							  Spotlight };
+
+		///String index of the name
+		uint32_t name;
+		///A Type value
+		uint8_t type;
+		///1 if position is set
+		uint8_t hasPosition;
+		///1 if direction is set
+		uint8_t hasDirection;
+		///Always 0
+		uint8_t reserved;
+		///Power of the light
+		float power;
+		///Position
+		float position[3];
+		///Direction
+		float direction[3];
+	};
+
+	///Header of a compiled level file (.annlvl), made from a JSON level by the AnnLevelCompiler tool and read by AnnCompiledLevel. Little endian.
+	///The tables follow, at the offsets given here. Tables are 8 bytes aligned
+	struct AnnCompiledLevelHeader
+	{
+		///Identify the file format
+		static constexpr std::array<char, 4> expectedMagic { { 'A', 'L', 'V', 'L' } };
+		///Current version of the format
+		static constexpr uint16_t currentVersion { 1 };
+		///File extension of compiled levels
+		static constexpr const char* extension { ".annlvl" };
+
+		///Must be expectedMagic
+		std::array<char, 4> magic;
+		///Must be currentVersion
+		uint16_t version;
+		///Always 0
+		uint16_t reserved;
+		///String index of the name of the level
+		uint32_t name;
+		///Number of strings
+		uint32_t stringCount;
+		///Number of resource locations
+		uint32_t resourceCount;
+		///Number of game objects
+		uint32_t objectCount;
+		///Number of lights
+		uint32_t lightCount;
+		///Number of script references
+		uint32_t scriptCount;
+		///Start position of the player
+		float playerPosition[3];
+		///Start orientation of the player (x, y, z, w)
+		float playerOrientation[4];
+		///Always 0
+		uint32_t padding;
+		///Offset of the AnnCompiledLevelString table
+		uint64_t stringsOffset;
+		///Offset of the string data
+		uint64_t stringDataOffset;
+		///Size of the string data
+		uint64_t stringDataSize;
+		///Offset of the AnnCompiledLevelResource table
+		uint64_t resourcesOffset;
+		///Offset of the AnnCompiledLevelObject table
+		uint64_t objectsOffset;
+		///Offset of the AnnCompiledLevelLight table
+		uint64_t lightsOffset;
+		///Offset of the script table (string indices)
+		uint64_t scriptsOffset;
+
+		///Get a table of the file
+		template <class T>
+		const T* getTable(uint64_t offset) const
+		{
+			return reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + offset);
+		}
+
+		///Get a string of the file
+		std::string_view getString(uint32_t index) const
+		{
+			const auto& string = getTable<AnnCompiledLevelString>(stringsOffset)[index];
+			return { getTable<char>(stringDataOffset) + string.offset, string.length };
+		}
+
+		///Get the resource locations
+		const AnnCompiledLevelResource* getResources() const { return getTable<AnnCompiledLevelResource>(resourcesOffset); }
+
+		///Get the game objects
+		const AnnCompiledLevelObject* getObjects() const { return getTable<AnnCompiledLevelObject>(objectsOffset); }
+
+		///Get the lights
+		const AnnCompiledLevelLight* getLights() const { return getTable<AnnCompiledLevelLight>(lightsOffset); }
+
+		///Get the script table
+		const uint32_t* getScripts() const { return getTable<uint32_t>(scriptsOffset); }
+
+		///Round an offset up to the table alignment
+		static uint64_t align(uint64_t offset)
+		{
+			return (offset + 7) / 8 * 8;
+		}
+
+		///Get the header at the start of that data, or nullptr if it isn't a valid compiled level. Every offset and index is checked, so the level can be read without any other check
+		static const AnnCompiledLevelHeader* find(const void* data, size_t size)
+		{
+			if(!data || size < sizeof(AnnCompiledLevelHeader)) return nullptr;
+			const auto header = static_cast<const AnnCompiledLevelHeader*>(data);
+			if(header->magic != expectedMagic || header->version != currentVersion) return nullptr;
+
+			const auto fits = [size](uint64_t offset, uint64_t count, uint64_t elementSize) {
+				return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+			};
+			if(!fits(header->stringsOffset, header->stringCount, sizeof(AnnCompiledLevelString))
+			   || !fits(header->stringDataOffset, header->stringDataSize, 1)
+			   || !fits(header->resourcesOffset, header->resourceCount, sizeof(AnnCompiledLevelResource))
+			   || !fits(header->objectsOffset, header->objectCount, sizeof(AnnCompiledLevelObject))
+			   || !fits(header->lightsOffset, header->lightCount, sizeof(AnnCompiledLevelLight))
+			   || !fits(header->scriptsOffset, header->scriptCount, sizeof(uint32_t)))
+				return nullptr;
+
+			const auto strings = header->getTable<AnnCompiledLevelString>(header->stringsOffset);
+			for(uint32_t i { 0 }; i < header->stringCount; ++i)
+				if(strings[i].offset > header->stringDataSize || strings[i].length > header->stringDataSize - strings[i].offset) return nullptr;
+
+			const auto isString = [header](uint32_t index) { return index < header->stringCount; };
+			if(!isString(header->name)) return nullptr;
+
+			for(uint32_t i { 0 }; i < header->resourceCount; ++i)
+			{
+				const auto& resource = header->getResources()[i];
+				if(!isString(resource.group) || !isString(resource.path) || !isString(resource.type)) return nullptr;
+			}
+
+			for(uint32_t i { 0 }; i < header->objectCount; ++i)
+			{
+				const auto& object = header->getObjects()[i];
+				if(!isString(object.name) || !isString(object.mesh)) return nullptr;
+				if(object.hasPhysics && (object.shape < AnnCompiledLevelObject::StaticShape || object.shape > AnnCompiledLevelObject::SphereShape)) return nullptr;
+				if(object.firstScript > header->scriptCount || object.scriptCount > header->scriptCount - object.firstScript) return nullptr;
+			}
+
+			for(uint32_t i { 0 }; i < header->lightCount; ++i)
+			{
+				const auto& light = header->getLights()[i];
+				if(!isString(light.name) || light.type > AnnCompiledLevelLight::Spotlight) return nullptr;
+			}
+
+			for(uint32_t i { 0 }; i < header->scriptCount; ++i)
+				if(!isString(header->getScripts()[i])) return nullptr;
+
+			return header;
+		}
+	};
+
+	static_assert(sizeof(AnnCompiledLevelObject) == 64, "Compiled level objects are read directly from files, they must not have padding");
+	static_assert(sizeof(AnnCompiledLevelLight) == 36, "Compiled level lights are read directly from files, they must not have padding");
+	static_assert(sizeof(AnnCompiledLevelHeader) == 120, "Compiled level header is read directly from files, it must not have padding");
+}
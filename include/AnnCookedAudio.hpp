@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+namespace Annwvyn
+{
+	///Header of a cooked audio file (.annpcm) : interleaved signed 16bit PCM samples ready to be given to OpenAL, written right after this header.
+	///Files are little endian. They are made by the AnnAudioCooker tool
+	struct AnnCookedAudioHeader
+	{
+		///Identify the file format
+		static constexpr std::array<char, 4> expectedMagic { { 'A', 'P', 'C', 'M' } };
+		///Current version of the format
+		static constexpr uint16_t currentVersion { 1 };
+		///File extension of cooked audio files
+		static constexpr const char* extension { ".annpcm" };
+
+		///Must be expectedMagic
+		std::array<char, 4> magic;
+		///Must be currentVersion
+		uint16_t version;
+		///1 or 2
+		uint16_t channels;
+		///Sample-rate in Hz
+		uint32_t sampleRate;
+		///Always 0
+		uint32_t reserved;
+		///Number of frames (one sample per channel)
+		uint64_t frameCount;
+
+		///Build a header for this audio
+		static AnnCookedAudioHeader make(uint16_t channels, uint32_t sampleRate, uint64_t frameCount)
+		{
+			return { expectedMagic, currentVersion, channels, sampleRate, 0, frameCount };
+		}
+
+		///Return true if this header describes a cooked file that fits in that many bytes
+		bool isValid(size_t fileSize) const
+		{
+			return magic == expectedMagic
+				&& version == currentVersion
+				&& (channels == 1 || channels == 2)
+				&& sampleRate > 0
+				&& fileSize >= sizeof(AnnCookedAudioHeader)
+				//Divide instead of multiplying the frame count, a crafted one would overflow
+				&& frameCount <= (fileSize - sizeof(AnnCookedAudioHeader)) / (channels * sizeof(int16_t));
+		}
+
+		///Get the header at the start of that data, or nullptr if it isn't a valid cooked audio file
+		static const AnnCookedAudioHeader* find(const void* data, size_t size)
+		{
+			if(!data || size < sizeof(AnnCookedAudioHeader)) return nullptr;
+			const auto header = static_cast<const AnnCookedAudioHeader*>(data);
+			return header->isValid(size) ? header : nullptr;
+		}
+
+		///Get the samples that follow this header
+		const int16_t* getSamples() const
+		{
+			return reinterpret_cast<const int16_t*>(this + 1);
+		}
+
+		///Get the number of samples that follow this header
+		size_t getSampleCount() const
+		{
+			return size_t(frameCount * channels);
+		}
+
+		///Write a cooked audio file in that stream
+		static bool write(std::ostream& output, uint16_t channels, uint32_t sampleRate, const std::vector<int16_t>& samples)
+		{
+			const auto header = make(channels, sampleRate, samples.size() / channels);
+			output.write(reinterpret_cast<const char*>(&header), sizeof header);
+			output.write(reinterpret_cast<const char*>(samples.data()), std::streamsize(header.getSampleCount() * sizeof(int16_t)));
+			return bool(output);
+		}
+	};
+
+	static_assert(sizeof(AnnCookedAudioHeader) == 24, "Cooked audio header is read directly from files, it must not have padding");
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <systemMacro.h>
+#include <AnnLevel.hpp>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class btCollisionShape;
+
+namespace Annwvyn
+{
+	///Base of the levels whose content is described by data (AnnJsonLevel, AnnCompiledLevel).
+	///The level only describes its game objects, this class creates them incrementally and preloads them
+	class AnnDllExport AnnDataLevel : LEVEL
+	{
+	public:
+		///Game object as described by the level data
+		struct ObjectDescription
+		{
+			///Name of the object
+			std::string name;
+			///Mesh of the object
+			std::string mesh;
+			///Position
+			AnnVect3 position;
+			///Orientation
+			AnnQuaternion orientation;
+			///Scale
+			AnnVect3 scale;
+			///If true, a rigid body is created. Unless the mass is negative
+			bool hasPhysics;
+			///Mass of the body
+			float mass;
+			///Shape of the body
+			phyShapeType shape;
+			///If true the body collides with the player
+			bool colideWithPlayer;
+			///Scripts attached to the object
+			std::vector<std::string> scripts;
+		};
+
+		///Construct the level
+		AnnDataLevel();
+		///Dtor
+		virtual ~AnnDataLevel();
+		///Create the whole content of the level at once
+		void load() override;
+		///Start creating the content of the level incrementally. The meshes of the level are read by the worker threads in parallel
+		void beginLoad() override;
+		///Create the next game object of the level, its shape is built by a worker. It stays hidden and out of the physics until finishLoad(). Once every object exist, wait for the shapes. Never blocks on the workers, return Waiting instead
+		LoadProgress loadStep() override;
+		///Add the rigid bodies to the world, attach the scripts and show the game objects, then create the lights and place the player with finishContent()
+		void finishLoad() override;
+		///Remove the game objects created so far, and the shapes built for them
+		void abandonLoad() override;
+		///Load the resource groups of the level, and prepare the meshes of its game objects, in the background
+		void preload() override;
+		///Return true once the resource groups and meshes are ready
+		bool isPreloaded() const override;
+		///Run logic, actually empty here
+		void runLogic() override;
+
+	protected:
+		///Get the number of game objects of the level
+		virtual size_t getObjectCount() const = 0;
+		///Get the description of a game object of the level
+		virtual ObjectDescription getObject(size_t index) const = 0;
+		///Create the lights and place the player. Called by finishLoad()
+		virtual void finishContent() = 0;
+
+		///Declare a resource group used by the level, loaded by preload()
+		void addResourceGroup(const std::string& group);
+
+	private:
+		///Game object created by loadStep(), waiting for finishLoad() to get its body and scripts
+		struct PendingObject
+		{
+			///The hidden object
+			std::shared_ptr<AnnGameObject> object;
+			///If true, the object gets a rigid body
+			bool hasBody;
+			///Mass of the body
+			float mass;
+			///If true the body collides with the player
+			bool colideWithPlayer;
+			///Shape being built by a worker
+			std::future<btCollisionShape*> shape;
+			///Scripts to attach
+			std::vector<std::string> scripts;
+		};
+
+		///Do the next piece of loading. If wait is false and that needs work the workers haven't finished, return Waiting without doing anything
+		LoadProgress step(bool wait);
+
+		///Forget the objects of a load that never finished. Their shapes are owned by nobody, they are deleted
+		void discardPendingObjects();
+
+		///Number of game objects already created by loadStep()
+		size_t loadedContent;
+		///Meshes being read by the workers, by name
+		std::unordered_map<std::string, std::shared_future<void>> meshPreparations;
+		///Preparation of the mesh of each game object
+		std::vector<std::shared_future<void>> objectMeshes;
+		///Objects created by loadStep(), in level order
+		std::vector<PendingObject> pendingObjects;
+		///Number of pending objects whose shape is built
+		size_t readyObjects;
+		///Resource groups declared by the level
+		std::vector<std::string> resourceGroups;
+		///Background work started by preload()
+		std::vector<std::shared_future<void>> preloads;
+	};
+}
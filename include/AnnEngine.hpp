@@ -38,6 +38,7 @@
 #include "AnnStringUtility.hpp"
 #include "AnnPlayerBody.hpp"
 #include "AnnDynamicLibraryHolder.hpp"
+#include "AnnTaskManager.hpp"
 
 //Get the deprecated warnings
 #pragma warning(default : 4996)
@@ -186,6 +187,9 @@ namespace Annwvyn
 		///Get the string utility
 		AnnStringUtilityPtr getStringUtility() const;
 
+		///Get the task manager
+		AnnTaskManagerPtr getTaskManager() const;
+
 		///Init the static/standing physics model
 		void initPlayerStandingPhysics() const;
 
@@ -239,6 +243,9 @@ namespace Annwvyn
 		///Get pointer to a subsystem by name
 		AnnSubSystemPtr getSubSystemByName(const std::string& name);
 
+		///Get pointer to a subsystem by the interned ID of it's name
+		AnnSubSystemPtr getSubSystemByName(AnnStringID nameID);
+
 		///Know if subsystem is user defined
 		static bool isUserSubSystem(AnnSubSystemPtr subsystem);
 
@@ -273,6 +280,8 @@ namespace Annwvyn
 		AnnStringUtilityPtr stringUtility;
 		///VR renderer
 		AnnOgreVRRendererPtr renderer;
+		///Worker threads and main thread work queue. Declared before the other subsystems so it is destroyed after them
+		AnnTaskManagerPtr taskManager;
 		///The onScreenConsole object
 		AnnConsolePtr onScreenConsole;
 		///ResourceManager
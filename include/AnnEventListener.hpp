@@ -40,6 +40,8 @@ namespace Annwvyn
 		virtual void CollisionEvent(AnnCollisionEvent e) {}
 		///Event from detected player collisions
 		virtual void PlayerCollisionEvent(AnnPlayerCollisionEvent e) {}
+		///Event from a resource group loaded in the background
+		virtual void ResourceLoadEvent(AnnResourceLoadEvent e) {}
 		///Events from code outside of Annwvyn itself
 		virtual void EventFromUserSubsystem(AnnUserSpaceEvent& e, AnnUserSpaceEventLauncher* origin) {}
 		///This method is called at each frame. Useful for updating player's movement command for example
@@ -108,6 +108,7 @@ namespace Annwvyn
 		friend class AnnEngine;
 		friend class AnnPhysicsEngine;
 		friend class AnnUserSpaceEventLauncher;
+		friend class AnnResourceManager;
 
 		///Send the given event to the listeners
 		void userSpaceDispatchEvent(AnnUserSpaceEventPtr e, AnnUserSpaceEventLauncher* sender);
@@ -139,6 +140,10 @@ namespace Annwvyn
 		void detectedCollision(void* a, void* b, AnnVect3 worldPosition, AnnVect3 normalOnB);
 		///Hook for the physics engine to signal player collision
 		void playerCollision(void* object);
+		///Process resource loading progress
+		void processResourceLoadEvents();
+		///Hook for the resource manager to signal the progress of a group loaded in the background
+		void resourceLoadProgress(const std::string& group, size_t loaded, size_t total);
 
 		///Buffer of keyboard events
 		std::vector<AnnKeyEvent> keyEventBuffer;
@@ -185,6 +190,9 @@ namespace Annwvyn
 		std::vector<AnnGameObject*> playerCollisionBuffer;
 		//----------------------- COLLISION MANAGEMENT
 
+		///Last progress of each group loaded this frame
+		std::vector<AnnResourceLoadEvent> resourceLoadEventBuffer;
+
 		///The text inputer object itself
 		std::unique_ptr<AnnTextInputer> textInputer;
 		///Default event listener
@@ -18,7 +18,8 @@ namespace Annwvyn
 		TRIGGER_CONTACT,
 		HAND_CONTROLLER,
 		COLLISION,
-		PLAYER_COLLISION
+		PLAYER_COLLISION,
+		RESOURCE_LOADING
 	};
 	///An input event
 	class AnnDllExport AnnEvent
@@ -38,6 +39,8 @@ namespace Annwvyn
 	{
 		///Keyboard event constructor
 		AnnKeyEvent();
+		///Matches the event hooks of the script classes with a blank event
+		friend class AnnScriptManager;
 
 	public:
 		///Get the key involved in that event
@@ -405,6 +408,30 @@ namespace Annwvyn
 		AnnGameObject* col;
 	};
 
+	///Progress of a resource group loaded in the background
+	class AnnDllExport AnnResourceLoadEvent : public AnnEvent
+	{
+	public:
+		///Event constructor
+		AnnResourceLoadEvent(const std::string& group, size_t loaded, size_t total);
+		///Get the name of the resource group
+		const std::string& getGroup() const;
+		///Get the number of resources of the group already loaded
+		size_t getLoadedCount() const;
+		///Get the number of resources to load in the group
+		size_t getTotalCount() const;
+		///Get the progress of the loading, between 0 and 1
+		float getProgress() const;
+		///Return true if the whole group is loaded
+		bool isFinished() const;
+
+	private:
+		///Name of the group
+		std::string group;
+		///Resource counts
+		size_t loaded, total;
+	};
+
 	///Trigger in/out event
 	class AnnDllExport AnnTriggerEvent : public AnnEvent
 	{
@@ -8,6 +8,7 @@
 #include "systemMacro.h"
 #include <string>
 #include <map>
+#include <set>
 #include <algorithm>
 #include <vector>
 #include <fstream>
@@ -15,6 +16,13 @@
 #include <list>
 #include <limits>
 #include <memory>
+#include <variant>
+#include <cstdint>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #ifdef WIN32
 #include <Windows.h>
@@ -34,15 +42,137 @@ namespace Annwvyn
 {
 	class AnnSaveFileData;
 
-	///Handle opening, writing and closing files
+	///On disk format of save files
+	enum class AnnSaveFileFormat {
+		///Versioned binary file with typed values. Default
+		Binary,
+		///Plain text "key=value" lines, for debugging
+		Text
+	};
+
+	///Value stored in a save file
+	using AnnSaveValue = std::variant<std::string, int, float, AnnVect3, AnnQuaternion>;
+
+	///Handle opening, writing and closing files. Files are replaced atomically : they are written to a temporary file, flushed to the disk, then renamed
 	class AnnDllExport AnnFileWriter
 	{
 	public:
-		///Construct file writer object
+		///Construct file writer object. Start the background writing thread
 		AnnFileWriter();
 
-		///Write the fileData to disc in the appropriate directory
-		static void write(std::shared_ptr<AnnSaveFileData> dataToWrite);
+		///Write what's left to write, and stop the background writing thread
+		~AnnFileWriter();
+
+		AnnFileWriter(const AnnFileWriter&) = delete;
+		AnnFileWriter& operator=(const AnnFileWriter&) = delete;
+
+		///Write the fileData to disc in the appropriate directory, in the format set on the filesystem manager. A background write of the same file that isn't done yet is replaced by this one
+		void write(std::shared_ptr<AnnSaveFileData> dataToWrite);
+
+		///Only append the keys that changed since the last save to a journal next to the file. When the journal gets bigger than the compaction threshold,
+		///the whole file is written again with an empty journal. The first journaled save of a file in a session is always a full write.
+		///Return false if the file couldn't be written
+		bool writeJournaled(std::shared_ptr<AnnSaveFileData> dataToWrite);
+
+		///Set the size of the journal (in bytes) over which the file is written again in full. 64KiB by default
+		void setJournalCompactionThreshold(size_t bytes);
+
+		///Get the size of the journal over which the file is written again in full
+		size_t getJournalCompactionThreshold() const;
+
+		///Take a snapshot of the fileData now, and write it on the background thread. If the same file is saved again before it is written, only the last snapshot is written,
+		///no later than the coalescing delay after the first one.
+		///Return a future that becomes true once the file is on disk, or false if it couldn't be written. Coalesced saves share the same future
+		std::shared_future<bool> writeAsync(std::shared_ptr<AnnSaveFileData> dataToWrite);
+
+		///Return true if this file has a background write that isn't done
+		bool isWriting(const std::string& filename) const;
+
+		///Return true if there's any background write that isn't done
+		bool hasPendingWrites() const;
+
+		///Write everything now and wait for it
+		void waitForPendingWrites();
+
+		///Set for how long a background save waits for newer saves of the same file, counted from the first one. 250 milliseconds by default
+		void setCoalesceDelay(std::chrono::milliseconds delay);
+
+		///Get for how long a background save waits for a newer save of the same file
+		std::chrono::milliseconds getCoalesceDelay() const;
+
+		///Serialize the data in the binary save format
+		static std::string toBinary(const AnnSaveFileData& data);
+
+		///Serialize the data in the text save format. Vectors and quaternions are written as one key per component
+		static std::string toText(const AnnSaveFileData& data);
+
+		///Magic number at the start of binary save files
+		static constexpr uint32_t binaryMagic { 0x56534E41 }; //"ANSV"
+		///Version of the binary save format
+		static constexpr uint16_t binaryVersion { 1 };
+
+		///Magic number at the start of journal files
+		static constexpr uint32_t journalMagic { 0x4C4A4E41 }; //"ANJL"
+		///Version of the journal format
+		static constexpr uint16_t journalVersion { 1 };
+
+	private:
+		///Write and flush a file, or append to it
+		static bool writeToDisk(const std::string& path, const std::string& content, bool append);
+
+		///Serialize the data in the format set on the filesystem manager
+		static std::string serialize(const AnnSaveFileData& data);
+
+		///Write the content in a temporary file next to the path, flush it to the disk, and rename it to the path
+		static bool writeAtomically(const std::string& path, const std::string& content);
+
+		///Body of the writing thread
+		void writerThreadLoop();
+
+		///A snapshot waiting to be written
+		struct PendingWrite
+		{
+			///Name of the file
+			std::string filename;
+			///Serialized content
+			std::string content;
+			///When the first snapshot was taken
+			std::chrono::steady_clock::time_point requestTime;
+			///Fulfilled once written
+			std::promise<bool> done;
+			///Given to everybody who asked for this write
+			std::shared_future<bool> future;
+		};
+
+		///Writes waiting for the thread, by path
+		std::map<std::string, PendingWrite> pendingWrites;
+
+		///Size of the journals known to go with the file written next to them, by path of the file
+		std::map<std::string, size_t> openJournals;
+
+		///Journal compaction threshold
+		size_t journalCompactionThreshold;
+
+		///Filename being written by the thread
+		std::string writingFilename;
+
+		///Coalescing delay
+		std::chrono::milliseconds coalesceDelay;
+
+		///Ignore the coalescing delay until everything is written
+		bool flushing;
+
+		///The thread runs while this is true
+		bool running;
+
+		///Protect everything above
+		mutable std::mutex writerMutex;
+
+		///Wake up the writer thread, or the threads waiting for it
+		std::condition_variable writerCondition;
+
+		///Background writing thread
+		std::thread writerThread;
 	};
 	using AnnFileWriterPtr = std::shared_ptr<AnnFileWriter>;
 
@@ -53,8 +183,17 @@ namespace Annwvyn
 		///Construct file reader object
 		AnnFileReader();
 
-		///read the asked file and return a new AnnSaveFileData*
+		///read the asked file and return a new AnnSaveFileData*. Binary and text files are both recognized
 		std::shared_ptr<AnnSaveFileData> read(std::string filename) const;
+
+		///Fill the data object from the content of a binary save file. Return false if the content is invalid
+		static bool fromBinary(const std::string& content, AnnSaveFileData& data);
+
+		///Fill the data object from the content of a text save file
+		static void fromText(const std::string& content, AnnSaveFileData& data);
+
+		///Apply the journal next to this path, if it was written for that snapshot content
+		static void replayJournal(const std::string& path, const std::string& snapshot, AnnSaveFileData& data);
 	};
 	using AnnFileReaderPtr = std::shared_ptr<AnnFileReader>;
 
@@ -95,7 +234,16 @@ namespace Annwvyn
 		///Get the FileWriter object
 		AnnFileWriterPtr getFileWriter() const;
 
+		///Set the format the FileWriter uses. Both formats can always be read
+		void setSaveFileFormat(AnnSaveFileFormat format);
+
+		///Get the format the FileWriter uses
+		AnnSaveFileFormat getSaveFileFormat() const;
+
 	private:
+		///Format used to write files
+		AnnSaveFileFormat saveFileFormat;
+
 		///Name of the save directory
 		std::string saveDirectoryName;
 
@@ -131,8 +279,19 @@ namespace Annwvyn
 		///Get the name of this file
 		std::string getFilename() const;
 
-		///Get the value of this key. Return empty if key doesn't exist
-		std::string getValue(std::string key);
+		///Get the value of this key as text. Return empty if key doesn't exist. Components of vectors and quaternions are at key.x, key.y, key.z, key.w
+		std::string getValue(std::string key) const;
+
+		///Return true if there's a value at this key
+		bool hasValue(const std::string& key) const;
+		///Get the value at this key as an integer. Return the fallback if there is none
+		int getInt(const std::string& key, int fallback = 0) const;
+		///Get the value at this key as a floating point. Return the fallback if there is none
+		float getFloat(const std::string& key, float fallback = 0) const;
+		///Get the vector at this key. Return an invalid vector if there is none
+		AnnVect3 getVect3(const std::string& key) const;
+		///Get the quaternion at this key. Return an invalid quaternion if there is none
+		AnnQuaternion getQuaternion(const std::string& key) const;
 
 		///Set the value for this key (string)
 		void setValue(std::string key, std::string value);
@@ -142,16 +301,16 @@ namespace Annwvyn
 		void setValue(std::string key, int value);
 		///Set the value for this key (floating point)
 		void setValue(std::string key, float value);
-		///Set the value for this key (vector as 3 floating point at key.x, key.y, key.z)
+		///Set the value for this key (vector. Text files store it at key.x, key.y, key.z)
 		void setValue(std::string key, AnnVect3 vector);
-		///Set the value for this key (quaternion as 4 floating point at key.w, key.x, key.y, key.z)
+		///Set the value for this key (quaternion. Text files store it at key.w, key.x, key.y, key.z)
 		void setValue(std::string key, AnnQuaternion quaternion);
 
 		///Remove the key and it's value from the stored data
 		void clearValue(std::string key);
-		///Vectors are stored under 3 keys because they are 3 floats
+		///Remove a vector, and the 3 keys it had in text files
 		void clearVectorValue(std::string key);
-		///Quaternions are stored under 4 keys because they are 4 floats
+		///Remove a quaternion, and the 4 keys it had in text files
 		void clearQuaternionValue(std::string key);
 
 		///Return true if keys were manipulated but changes weren't wrote to disk yet
@@ -165,8 +324,20 @@ namespace Annwvyn
 		///Name of the file
 		std::string fileName;
 
+		///Get the value at this key, or nullptr
+		const AnnSaveValue* find(const std::string& key) const;
+
+		///Get a float from a value, or from the text it holds
+		static bool toFloat(const AnnSaveValue& value, float& output);
+
+		///Get the text form of a value. Empty for vectors and quaternions
+		static std::string toText(const AnnSaveValue& value);
+
 		///Stored data
-		std::map<std::string, std::string> storedTextData;
+		std::map<std::string, AnnSaveValue> storedData;
+
+		///Keys set or cleared since the last save, for the journal
+		std::set<std::string> journalKeys;
 
 		///If true, the content of this object should be wrote to disk when possible
 		bool changed;
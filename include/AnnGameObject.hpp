@@ -13,6 +13,7 @@
 //Annwvyn
 #include "AnnTypes.h"
 #include "AnnAbstractMovable.hpp"
+#include "AnnStringUtility.hpp"
 #pragma warning(default : 4996)
 
 namespace Annwvyn
@@ -163,6 +164,10 @@ namespace Annwvyn
 		/// \praam hasPlayerCollision if set to true (by default) object can colide with the player body representation
 		void setupPhysics(float mass = 0, phyShapeType type = staticShape, bool hasPlayerCollision = true);
 
+		///advanced : set up physics with a shape that has already been built (see AnnPhysicsEngine::_getGameObjectShapeAsync). The object owns the shape.
+		///Throw like setupPhysics() if a parent or a child already has a body, the shape is deleted then
+		void _setupPhysics(float mass, btCollisionShape* shape, bool hasPlayerCollision = true);
+
 		///Make the object visible
 		void setVisible() const;
 
@@ -172,6 +177,12 @@ namespace Annwvyn
 		///Return the name of the object
 		std::string getName() const;
 
+		///Return the interned ID of the name of the object
+		AnnStringID getNameID() const;
+
+		///Time in seconds covered by the current update() call. Longer than the frame time if the update LOD of the GameObjectManager skipped some frames for this object
+		double getUpdateDeltaTime() const;
+
 		///Attach a script to this object
 		/// \param scriptName name of a script
 		void attachScript(const std::string& scriptName);
@@ -249,6 +260,21 @@ namespace Annwvyn
 		///Name of the object
 		std::string name;
 
+		///Interned ID of the name
+		AnnStringID nameID;
+
+		///Book keeping of the update LOD, done by the GameObjectManager
+		struct UpdateLodState
+		{
+			///Time not yet given to the animation
+			double animationTime { 0 };
+			///Time since the last update() and script update
+			double scriptTime { 0 };
+		} updateLod;
+
+		///Time covered by the current update
+		double updateDeltaTime;
+
 		///RigidBodyState of this object
 		BtOgre::RigidBodyState* state;
 
@@ -8,6 +8,9 @@
 #include <OgreMesh2.h>
 
 #include <memory>
+#include <future>
+#include <functional>
+#include <vector>
 
 #include <Ogre_glTF.hpp>
 
@@ -20,6 +23,19 @@ namespace Annwvyn
 	class AnnDllExport AnnGameObjectManager : public AnnSubSystem
 	{
 	public:
+		///How often objects in a range of distance from the head are updated. An interval of 1 is every frame, N is once every N frames
+		struct UpdateLodTier
+		{
+			///Objects closer than this distance (in meters) from the head use this tier
+			float maxDistance;
+			///Frames between skeletal animation updates. Skipped time is accumulated
+			unsigned animationInterval;
+			///Frames between calls to update() and to the attached scripts
+			unsigned scriptInterval;
+			///Frames between updates of the 3D sound position
+			unsigned soundInterval;
+		};
+
 		AnnGameObjectManager();
 
 		///Update from the game engine
@@ -34,10 +50,36 @@ namespace Annwvyn
 		std::shared_ptr<AnnGameObject> createGameObject(const std::string& mesh, std::string identifier = "",
 														std::shared_ptr<AnnGameObject> object = std::make_shared<AnnGameObject>()); //object factory
 
+		///Callback called on the main thread when an asynchronously created object is ready
+		using GameObjectReadyCallback = std::function<void(std::shared_ptr<AnnGameObject>)>;
+
+		///Create a game object without stalling the frame. File reading and parsing is done on a worker thread, the Ogre Item and SceneNode are created later on the main thread within the TaskManager budget.
+		/// \param mesh Name of an mesh loaded to the Ogre ResourceGroupManager
+		/// \param identifier Name of the object. Generated if empty
+		/// \param object An instance of an empty AnnGameObject. Useful for creating object of inherited class
+		/// \param onReady Called on the main thread with the created object. Use it to setup physics, attach scripts...
+		/// \return Future holding the object once created. Errors during loading are rethrown by get()
+		std::shared_future<std::shared_ptr<AnnGameObject>> createGameObjectAsync(const std::string& mesh, std::string identifier = "",
+																				 std::shared_ptr<AnnGameObject> object = std::make_shared<AnnGameObject>(),
+																				 GameObjectReadyCallback onReady = nullptr);
+
+		///Get a mesh ready for createGameObject() without stalling the frame. The file is read on a worker thread, the v2 mesh is imported later on the main thread within the TaskManager budget.
+		///Creating a game object from that mesh afterwards only creates the Item and the SceneNode. glTF files are ready right away, they are loaded at creation
+		/// \return Future that becomes ready with the mesh. Errors during loading are rethrown by get()
+		std::shared_future<void> preloadMesh(const std::string& mesh);
+
+		///Read and decode a mesh file on a worker thread, without the v2 import. The future only depends on the workers, so the main thread can wait for it.
+		///createGameObject() on that mesh then only does the v2 import and creates the Item and the SceneNode
+		std::shared_future<void> prepareMesh(const std::string& mesh);
+
 		///Remove object from the manager. Object will be destroyed when no more references are in scope
 		/// \param object the object to remove
 		void removeGameObject(std::shared_ptr<AnnGameObject> object);
 
+		///Remove many objects from the manager in one pass. Their rigid bodies are removed from the physics in one batch
+		/// \param objects the objects to remove
+		void removeGameObjects(const AnnGameObjectList& objects);
+
 		///Search for an AnnGameObject that holds this node, returns it if found. Return nullptr if not found.
 		std::shared_ptr<AnnGameObject> getFromNode(Ogre::SceneNode* node);
 
@@ -45,6 +87,9 @@ namespace Annwvyn
 		/// \param light shared pointer to the light
 		void removeLightObject(std::shared_ptr<AnnLightObject> light);
 
+		///Remove many lights from the scene in one pass
+		void removeLightObjects(const AnnLightList& lights);
+
 		///Add a light source to the scene. return a pointer to the new light
 		std::shared_ptr<AnnLightObject> createLightObject(std::string identifier = "");
 
@@ -54,21 +99,48 @@ namespace Annwvyn
 		///Remove the object from the engine
 		void removeTriggerObject(std::shared_ptr<AnnTriggerObject> trigger);
 
+		///Remove many triggers from the engine in one pass
+		void removeTriggerObjects(const AnnTriggerObjectList& triggers);
+
 		///Get the AnnGameObject the player is looking at
 		std::shared_ptr<AnnGameObject> playerLookingAt(unsigned short limit = 5); //physics
 
 		///Get an AnnGameObject for the required string; return nullptr if object cannot be found
-		std::shared_ptr<AnnGameObject> getGameObject(std::string gameObjectName);
+		std::shared_ptr<AnnGameObject> getGameObject(const std::string& gameObjectName);
+
+		///Get an AnnGameObject from the interned ID of it's name; return nullptr if object cannot be found
+		std::shared_ptr<AnnGameObject> getGameObject(AnnStringID gameObjectID);
 
 		///Get an AnnLightObject from it's name; return nullptr if object not found
-		std::shared_ptr<AnnLightObject> getLightObject(std::string lightObjectName);
+		std::shared_ptr<AnnLightObject> getLightObject(const std::string& lightObjectName);
+
+		///Get an AnnLightObject from the interned ID of it's name; return nullptr if object not found
+		std::shared_ptr<AnnLightObject> getLightObject(AnnStringID lightObjectID);
 
 		///Get an AnnTriggerObject from it's name; return nullptr if object not found
-		std::shared_ptr<AnnTriggerObject> getTriggerObject(std::string triggerObjectName);
+		std::shared_ptr<AnnTriggerObject> getTriggerObject(const std::string& triggerObjectName);
+
+		///Get an AnnTriggerObject from the interned ID of it's name; return nullptr if object not found
+		std::shared_ptr<AnnTriggerObject> getTriggerObject(AnnStringID triggerObjectID);
 
 		///Set the options to pass while converting Ogre V1 meshes to Ogre V2 meshes
 		void setImportParameter(bool halfPosition, bool halfTextureCoord, bool qTangents);
 
+		///Enable or disable the update LOD. When disabled (the default) every object is fully updated each frame
+		void setUpdateLodEnabled(bool state);
+
+		///Return true if the update LOD is enabled
+		bool isUpdateLodEnabled() const;
+
+		///Set the update LOD tiers. They will be sorted by distance. Objects further than the last tier use the last tier
+		void setUpdateLodTiers(std::vector<UpdateLodTier> tiers);
+
+		///Get the update LOD tiers
+		const std::vector<UpdateLodTier>& getUpdateLodTiers() const;
+
+		///Set by how many tiers an object that was outside the view in the last frame is pushed back
+		void setUpdateLodInvisiblePenalty(size_t tiers);
+
 	private:
 		friend class AnnEngine;
 
@@ -79,20 +151,44 @@ namespace Annwvyn
 		///Dynamic container for Game objects present in engine
 		AnnGameObjectList Objects;
 
-		///objects mapped to ID strings
-		std::unordered_map<std::string, std::shared_ptr<AnnGameObject>> identifiedObjects;
+		///objects mapped to interned ID strings
+		std::unordered_map<AnnStringID, std::shared_ptr<AnnGameObject>> identifiedObjects;
 
-		///lights mapped to ID strings
-		std::unordered_map<std::string, std::shared_ptr<AnnLightObject>> identifiedLights;
+		///lights mapped to interned ID strings
+		std::unordered_map<AnnStringID, std::shared_ptr<AnnLightObject>> identifiedLights;
 
-		///triggers identified to ID string
-		std::unordered_map<std::string, std::shared_ptr<AnnTriggerObject>> identifiedTriggerObjects;
+		///triggers identified to interned ID string
+		std::unordered_map<AnnStringID, std::shared_ptr<AnnTriggerObject>> identifiedTriggerObjects;
 
 		uID autoID;
 		uID nextID();
 
+		///Get the v1 mesh resource, declared but not loaded
+		static Ogre::v1::MeshPtr declareV1Mesh(const std::string& meshName);
+
+		///Create the Item for the given mesh file. .mesh files are converted to v2, .glb are loaded through Ogre_glTF
+		Ogre::Item* createItemFromMesh(const std::string& meshName);
+
+		///Put the item in the scene, give the object it's sound source and name, and register it
+		std::shared_ptr<AnnGameObject> registerGameObject(Ogre::Item* item, const std::string& meshName, std::string identifier, std::shared_ptr<AnnGameObject> obj);
+
 		bool halfPos, halfTexCoord, qTan;
 
+		///Get the tier an object should be updated with this frame
+		const UpdateLodTier& getUpdateLodTier(const AnnGameObject& object, const AnnVect3& headPosition) const;
+
+		///Return true if something running every interval frames has to run now for this object
+		bool isUpdateLodFrame(unsigned interval, const AnnGameObject& object) const;
+
+		///Update LOD state
+		bool updateLodEnabled;
+		///Tiers sorted by distance
+		std::vector<UpdateLodTier> updateLodTiers;
+		///Tiers added to objects outside of the view
+		size_t updateLodInvisiblePenalty;
+		///Frames since the creation of the manager
+		uID frameCounter;
+
 		Ogre_glTF::glTFLoaderInterface* glTFLoader = nullptr;
 	};
 
@@ -34,4 +34,6 @@ namespace Annwvyn
 	AnnDllExport AnnConsolePtr AnnGetOnScreenConsole();
 	///Get the string utility object
 	AnnDllExport AnnStringUtilityPtr AnnGetStringUtility();
+	///Get the task manager
+	AnnDllExport AnnTaskManagerPtr AnnGetTaskManager();
 }
@@ -1,13 +1,13 @@
 #pragma once
 
 #include <systemMacro.h>
-#include <AnnLevel.hpp>
+#include <AnnDataLevel.hpp>
 #include <memory>
 
 namespace Annwvyn
 {
 	///Level object loaded from a JSON file
-	class AnnDllExport AnnJsonLevel : LEVEL
+	class AnnDllExport AnnJsonLevel : public AnnDataLevel
 	{
 		///Pimpl struct
 		struct AnnJson;
@@ -21,10 +21,14 @@ namespace Annwvyn
 		AnnJsonLevel(bool, std::string jsonCode, bool preload = true);
 		///Dtor
 		virtual ~AnnJsonLevel();
-		///Load method. This goes through the loaded JSON and create the object for you
-		void load() override;
-		///Run logic, actually empty here
-		void runLogic() override;
+
+	protected:
+		///Get the number of game objects in the "content" array
+		size_t getObjectCount() const override;
+		///Read a game object of the "content" array
+		ObjectDescription getObject(size_t index) const override;
+		///Create the lights and place the player
+		void finishContent() override;
 
 	private:
 		///Pimpl
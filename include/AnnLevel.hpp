@@ -41,6 +41,36 @@ namespace Annwvyn
 		///Run logic code from the level
 		virtual void runLogic() = 0;
 
+		///Start getting the resources of the level ready in the background, while another level is running. By default there's nothing to preload
+		virtual void preload();
+
+		///Return true when everything started by preload() is ready
+		virtual bool isPreloaded() const;
+
+		///Incremental loading : called once by the level manager before the first loadStep()
+		virtual void beginLoad();
+
+		///Result of a step of incremental loading
+		enum class LoadProgress
+		{
+			///Some work was done, the next step can be done right away
+			Progress,
+			///Nothing was done, the step waits for the workers. Try again next frame
+			Waiting,
+			///There's nothing left to do
+			Done
+		};
+
+		///Incremental loading : do the next piece of work of loading the level, in the background of the level still running.
+		///By default there is no incremental work, the whole load() is done by finishLoad()
+		virtual LoadProgress loadStep();
+
+		///Incremental loading : called once the previous level is unloaded, when this one becomes current. Place the player here. By default call load()
+		virtual void finishLoad();
+
+		///Incremental loading : called instead of finishLoad() when the level manager gives up loading this level. Remove what was created so far, without touching the scene parameters, the music or the gravity of the level still running
+		virtual void abandonLoad();
+
 		///Get the list of objects
 		AnnGameObjectList& getContent();
 
@@ -65,6 +95,9 @@ namespace Annwvyn
 		///List of movable on the level
 		std::vector<std::shared_ptr<AnnAbstractMovable>> levelMovable;
 
+		///Remove the objects, lights and triggers of the level
+		void removeContent();
+
 		///Add a light object to the level
 		std::shared_ptr<AnnLightObject> addLightObject(std::string id = "");
 
@@ -47,6 +47,32 @@ namespace Annwvyn
 			return level;
 		}
 
+		///Start getting a level ready in the background while the current one runs, so switching to it later only has to put its content in the scene.
+		///The level is added to the manager if it wasn't
+		void preloadLevel(AnnLevelPtr level);
+
+		///Start getting an index referenced level ready in the background while the current one runs
+		void preloadLevel(AnnLevelID levelId);
+
+		///Set if switching level loads the next one incrementally. The current level keeps running while the next one is loaded a step at a time, within the loading budget of each frame.
+		///The current level is unloaded and the player placed only once the next one is fully loaded. Switching to the current level unloads it before loading it again
+		void setIncrementalLoading(bool state);
+
+		///Return true if levels are loaded incrementally
+		bool isIncrementalLoading() const;
+
+		///Set how many milliseconds of level loading can be done per frame. At least one loading step is done each frame
+		void setLoadingBudget(double milliseconds);
+
+		///Get the milliseconds per frame given to level loading
+		double getLoadingBudget() const;
+
+		///Return true if a level is being loaded incrementally
+		bool isLoading() const;
+
+		///Get the level being loaded incrementally, if any
+		AnnLevelPtr getLoadingLevel() const;
+
 		///Jump to the first level that was loaded into the engine
 		void switchToFirstLoadedLevel();
 
@@ -78,6 +104,12 @@ namespace Annwvyn
 		void removeFromCurrentLevel(AnnGameObjectPtr obj) const;
 
 	private:
+		///Start loading a level incrementally
+		void startLoading(AnnLevelPtr level);
+
+		///Do the loading steps of this frame, and switch to the level when it's loaded
+		void continueLoading();
+
 		///List of levels
 		std::vector<AnnLevelPtr> loadedLevels;
 
@@ -89,6 +121,15 @@ namespace Annwvyn
 
 		///Level to switchToLevel to at next update
 		AnnLevelID jumpTo;
+
+		///Level being loaded incrementally
+		AnnLevelPtr loading;
+
+		///If true, levels are loaded incrementally
+		bool incrementalLoading;
+
+		///Time budget for loading steps, in milliseconds
+		double loadingBudget;
 	};
 
 	using AnnLevelManagerPtr = std::shared_ptr<AnnLevelManager>;
@@ -8,6 +8,7 @@
 #include "systemMacro.h"
 
 #include "AnnAbstractMovable.hpp"
+#include "AnnStringUtility.hpp"
 #include "AnnTypes.h"
 
 #include <OgreLight.h>
@@ -71,12 +72,16 @@ namespace Annwvyn
 		///Get the name of this light
 		std::string getName() const;
 
+		///Get the interned ID of the name of this light
+		AnnStringID getNameID() const;
+
 	private:
 		friend class AnnEngine;
 		friend class AnnGameObjectManager;
 		Ogre::Light* light;
 		Ogre::SceneNode* node;
 		const std::string name;
+		AnnStringID nameID;
 	};
 
 	using AnnLightObjectPtr = std::shared_ptr<AnnLightObject>;
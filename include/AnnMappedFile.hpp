@@ -0,0 +1,65 @@
+#pragma once
+
+#include "systemMacro.h"
+#include "AnnTypes.h"
+
+#include <string>
+
+namespace Annwvyn
+{
+	///Read-only memory mapping of a whole file. The OS pages the content in on demand, nothing is copied. The mapping is released on destruction
+	class AnnDllExport AnnMappedFile
+	{
+	public:
+		///Construct an empty mapping
+		AnnMappedFile();
+
+		///Map the file at this path. Check isOpen() to know if it worked
+		explicit AnnMappedFile(const std::string& path);
+
+		///Unmap the file
+		~AnnMappedFile();
+
+		///Deleted copy operation
+		AnnMappedFile(const AnnMappedFile&) = delete;
+		///Deleted copy operation
+		AnnMappedFile& operator=(const AnnMappedFile&) = delete;
+
+		///Move constructor
+		AnnMappedFile(AnnMappedFile&& other) noexcept;
+		///Move assignment
+		AnnMappedFile& operator=(AnnMappedFile&& other) noexcept;
+
+		///Map the file at this path, unmap the previous one. Return false if the file can't be mapped (missing, empty...)
+		bool open(const std::string& path);
+
+		///Unmap the file
+		void close();
+
+		///Return true if a file is mapped
+		bool isOpen() const;
+
+		///Get a pointer to the content of the file
+		const byte* getData() const;
+
+		///Get the size of the file in bytes
+		size_t getSize() const;
+
+	private:
+		///Steal the mapping of another object
+		void moveFrom(AnnMappedFile& other);
+
+		///Start of the view
+		const byte* data;
+
+		///Size of the view
+		size_t size;
+
+#ifdef _WIN32
+		///File handle
+		void* fileHandle;
+		///File mapping object handle
+		void* mappingHandle;
+#endif
+	};
+}
@@ -275,6 +275,9 @@ namespace Annwvyn
 		///Return true if the HLMS templates are loaded into Ogre
 		bool isHlmsLibLoaded() const;
 
+		///Return true if the sphere is inside the view frustum of one of the cameras, as they were placed for the last rendered frame
+		bool isInViewFrustum(const Ogre::Sphere& bound) const;
+
 		///Return (if found) the name o the audio device you can use in the audio engine from a Windows only "GUID" for a sound card
 		static std::string getAudioDeviceNameFromGUID(GUID guid);
 
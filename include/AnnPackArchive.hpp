@@ -0,0 +1,97 @@
+#pragma once
+
+#include "systemMacro.h"
+#include "AnnMappedFile.hpp"
+#include "AnnPackFormat.hpp"
+
+#include <OgreArchive.h>
+#include <OgreArchiveFactory.h>
+
+namespace Annwvyn
+{
+	///Ogre archive reading Annwvyn resource packs (.annpak). The pack is memory mapped, files are found with a binary search in its hashed index.
+	///Uncompressed files are opened as views on the mapping, without any copy. They stay valid as long as the archive is loaded.
+	class AnnDllExport AnnPackArchive : public Ogre::Archive
+	{
+	public:
+		///Create the archive. Nothing is read before load()
+		AnnPackArchive(const Ogre::String& name, const Ogre::String& archiveType);
+
+		///Unload the archive
+		~AnnPackArchive();
+
+		///Names in packs are case sensitive
+		bool isCaseSensitive() const override;
+
+		///Map the pack and check its index. Throw if it isn't a valid pack
+		void load() override;
+
+		///Unmap the pack
+		void unload() override;
+
+		///Open a file of the pack. Return a null stream if the file is not in the pack
+		Ogre::DataStreamPtr open(const Ogre::String& filename, bool readOnly = true) override;
+
+		///List the files of the pack
+		Ogre::StringVectorPtr list(bool recursive = true, bool dirs = false) override;
+
+		///List the files of the pack, with their sizes
+		Ogre::FileInfoListPtr listFileInfo(bool recursive = true, bool dirs = false) override;
+
+		///Find the files of the pack matching a pattern
+		Ogre::StringVectorPtr find(const Ogre::String& pattern, bool recursive = true, bool dirs = false) override;
+
+		///Find the files of the pack matching a pattern, with their sizes
+		Ogre::FileInfoListPtr findFileInfo(const Ogre::String& pattern, bool recursive = true, bool dirs = false) override;
+
+		///Return true if the file is in the pack
+		bool exists(const Ogre::String& filename) override;
+
+		///Files of a pack have the modification time of the pack
+		time_t getModifiedTime(const Ogre::String& filename) override;
+
+		///Name of this archive type, to use with Ogre's resource locations
+		static constexpr const char* type { "AnnPack" };
+
+	private:
+		///Binary search of a name in the index
+		const AnnPackEntry* findEntry(const Ogre::String& filename) const;
+
+		///Get the file information of an entry
+		Ogre::FileInfo getFileInfo(const AnnPackEntry& entry) const;
+
+		///Get the content of the pack matching a pattern (or everything if pattern is empty)
+		Ogre::FileInfoListPtr getMatchingFileInfo(const Ogre::String& pattern, bool recursive, bool dirs) const;
+
+		///Mapping of the whole pack
+		AnnMappedFile pack;
+
+		///Header in the mapping
+		const AnnPackHeader* header;
+
+		///Index in the mapping
+		const AnnPackEntry* entries;
+
+		///Name table in the mapping
+		const char* names;
+
+		///Modification time of the pack file
+		time_t modifiedTime;
+	};
+
+	///Factory registered to Ogre's ArchiveManager to create AnnPackArchive
+	class AnnDllExport AnnPackArchiveFactory : public Ogre::ArchiveFactory
+	{
+	public:
+		///Return "AnnPack"
+		const Ogre::String& getType() const override;
+
+		using Ogre::ArchiveFactory::createInstance;
+
+		///Create a pack archive. Packs are read only
+		Ogre::Archive* createInstance(const Ogre::String& name, bool readOnly) override;
+
+		///Destroy a pack archive
+		void destroyInstance(Ogre::Archive* archive) override;
+	};
+}
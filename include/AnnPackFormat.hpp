@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace Annwvyn
+{
+	///Entry of the index of a resource pack. Entries are sorted by (nameHash, name) so a file is found with a binary search
+	struct AnnPackEntry
+	{
+		///How the data of an entry is stored
+		enum Compression : uint8_t { None,
+									 LZ4 };
+
+		///FNV-1a hash of the name
+		uint64_t nameHash;
+		///Offset of the data from the start of the pack. Always a multiple of AnnPackHeader::entryAlignment
+		uint64_t offset;
+		///Size of the file
+		uint64_t size;
+		///Size of the data in the pack. Same as size if the entry is not compressed
+		uint64_t storedSize;
+		///Offset of the name in the name table
+		uint32_t nameOffset;
+		///Length of the name (not null terminated)
+		uint16_t nameLength;
+		///A Compression value
+		uint8_t compression;
+		///Always 0
+		uint8_t reserved;
+
+		///Hash a file name the way the pack index does
+		static uint64_t hash(const char* name, size_t length)
+		{
+			uint64_t value = 14695981039346656037ull;
+			for(size_t i { 0 }; i < length; ++i)
+			{
+				value ^= uint8_t(name[i]);
+				value *= 1099511628211ull;
+			}
+			return value;
+		}
+
+		///Hash a file name the way the pack index does
+		static uint64_t hash(const std::string& name)
+		{
+			return hash(name.data(), name.size());
+		}
+	};
+
+	///Header of an Annwvyn resource pack (.annpak). Little endian. Made by the AnnPackBuilder tool, read by the "AnnPack" Ogre archive type.
+	///Layout : header, file data (each entry aligned), index (entryCount AnnPackEntry), name table (names with '/' separators)
+	struct AnnPackHeader
+	{
+		///Identify the file format
+		static constexpr std::array<char, 4> expectedMagic { { 'A', 'P', 'A', 'K' } };
+		///Current version of the format
+		static constexpr uint16_t currentVersion { 1 };
+		///File extension of resource packs
+		static constexpr const char* extension { ".annpak" };
+		///Alignment of the data of every entry in the pack
+		static constexpr uint64_t entryAlignment { 64 };
+
+		///Must be expectedMagic
+		std::array<char, 4> magic;
+		///Must be currentVersion
+		uint16_t version;
+		///Always 0
+		uint16_t reserved;
+		///Number of entries in the index
+		uint32_t entryCount;
+		///Size of the name table in bytes
+		uint32_t nameTableSize;
+		///Offset of the index from the start of the pack
+		uint64_t indexOffset;
+		///Offset of the name table from the start of the pack
+		uint64_t nameTableOffset;
+
+		///Build a header for this content
+		static AnnPackHeader make(uint32_t entryCount, uint64_t indexOffset, uint64_t nameTableOffset, uint32_t nameTableSize)
+		{
+			return { expectedMagic, currentVersion, 0, entryCount, nameTableSize, indexOffset, nameTableOffset };
+		}
+
+		///Return true if this header describes an index and a name table that fit in that many bytes
+		bool isValid(size_t fileSize) const
+		{
+			return magic == expectedMagic
+				&& version == currentVersion
+				&& indexOffset % alignof(AnnPackEntry) == 0
+				&& indexOffset <= fileSize
+				&& uint64_t(entryCount) * sizeof(AnnPackEntry) <= fileSize - indexOffset
+				&& nameTableOffset <= fileSize
+				&& nameTableSize <= fileSize - nameTableOffset;
+		}
+
+		///Get the header at the start of that data, or nullptr if it isn't a valid pack
+		static const AnnPackHeader* find(const void* data, size_t size)
+		{
+			if(!data || size < sizeof(AnnPackHeader)) return nullptr;
+			const auto header = static_cast<const AnnPackHeader*>(data);
+			return header->isValid(size) ? header : nullptr;
+		}
+
+		///Round an offset up to the entry alignment
+		static uint64_t align(uint64_t offset, uint64_t alignment = entryAlignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+	};
+
+	static_assert(sizeof(AnnPackEntry) == 40, "Pack entries are read directly from files, they must not have padding");
+	static_assert(sizeof(AnnPackHeader) == 32, "Pack header is read directly from files, it must not have padding");
+}
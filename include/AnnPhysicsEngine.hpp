@@ -8,7 +8,9 @@
 
 #include "systemMacro.h"
 
+#include <future>
 #include <memory>
+#include <vector>
 
 //Bullet
 #include <btBulletCollisionCommon.h>
@@ -82,9 +84,12 @@ namespace Annwvyn
 		///Process the collision query system
 		void processCollisionTesting() const;
 
-		///Remove a body from simulation
+		///Remove a body from simulation. Bodies that are not in the simulation anymore are ignored
 		void removeRigidBody(btRigidBody* body) const;
 
+		///Remove many bodies from simulation in one pass over the world, instead of one search per body
+		void removeRigidBodies(const std::vector<btRigidBody*>& bodies) const;
+
 		///Init the class "standing" designed for the Oculus physics where the player is not moving in the room at all
 		void initPlayerStandingPhysics(Ogre::SceneNode* playerAnchorNode);
 
@@ -112,6 +117,12 @@ namespace Annwvyn
 		///advanced : functions called to setup physics by game objects
 		btCollisionShape* _getGameObjectShape(AnnGameObject* obj, phyShapeType type);
 
+		///advanced : read the vertices of the object now, and build its shape (hull, BVH...) on a worker thread. The future only depends on the workers
+		std::future<btCollisionShape*> _getGameObjectShapeAsync(AnnGameObject* obj, phyShapeType type);
+
+		///advanced : delete a shape made by _getGameObjectShape, and the mesh data it owns
+		static void _destroyShape(btCollisionShape* shape);
+
 	private:
 		friend class AnnEngine;
 		///Update by steeping simulation by one frame time. Should be called only once, and only by AnnEngine
@@ -4,8 +4,29 @@
 #include "OgreResourceGroupManager.h"
 #include "AnnSubsystem.hpp"
 
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
 namespace Annwvyn
 {
+	///Memory held by loaded resources
+	struct AnnResourceMemoryUsage
+	{
+		///Bytes held in system memory
+		size_t cpuBytes;
+		///Bytes held by the graphics card (textures, meshes, shaders)
+		size_t gpuBytes;
+		///Number of loaded resources
+		size_t resourceCount;
+
+		///Get the total number of bytes
+		size_t getTotalBytes() const { return cpuBytes + gpuBytes; }
+	};
+
 	///Annwvyn interface class with Ogre's ResourceGroupManager.
 	class AnnDllExport AnnResourceManager : public AnnSubSystem
 	{
@@ -16,6 +37,11 @@ namespace Annwvyn
 		/// \param resourceGroupName name of the resource group where the content will be added
 		void addZipLocation(const std::string& path, const std::string& resourceGroupName = getDefaultResourceGroupName()) const;
 
+		///Give an Annwvyn resource pack (.annpak, made by AnnPackBuilder) location to the Ogre Resource Group Manager
+		/// \param path The path to the pack file
+		/// \param resourceGroupName name of the resource group where the content will be added
+		void addPackLocation(const std::string& path, const std::string& resourceGroupName = getDefaultResourceGroupName()) const;
+
 		///Give a directory resource location to the Ogre Resource Group Manager
 		/// \param path The path to the directory
 		/// \param resourceGroupName name of the resource group
@@ -30,19 +56,103 @@ namespace Annwvyn
 		///Load in memory the content of the specified group
 		void loadGroup(const std::string& groupName) const;
 
+		///Load the content of the specified group without stalling the frame. Files are read and decoded on worker threads, resources are then finished on the main thread within the TaskManager budget.
+		///Progress is sent to the event listeners as AnnResourceLoadEvent. The returned future becomes ready when the whole group is loaded
+		std::shared_future<void> loadGroupAsync(const std::string& groupName);
+
+		///Return true if the specified group is being loaded in the background
+		bool isGroupLoading(const std::string& groupName) const;
+
+		///Prepare a resource (read and decode its file) on a TaskManager worker, then call onPrepared on that worker with the exception raised, or nullptr. Call it from the main thread.
+		///Ogre only locks its archives and resource groups when built with thread support. Without it, only resources from archives that can be read by many threads at once ("FileSystem" and "AnnPack")
+		///are prepared on a worker. Others (a "Zip" has one read cursor for everyone) are prepared on the main thread within the TaskManager budget, onPrepared is then called there.
+		///Return true if the resource is prepared on a worker
+		bool prepareInBackground(Ogre::ResourcePtr resource, std::function<void(std::exception_ptr)> onPrepared);
+
+		///Get the memory held by the loaded resources of a group
+		AnnResourceMemoryUsage getGroupMemoryUsage(const std::string& groupName) const;
+
+		///Get the memory held by the loaded resources of a group, by resource type ("Texture", "Mesh2", "AnnAudioFile"...)
+		std::map<std::string, AnnResourceMemoryUsage> getGroupMemoryUsageByType(const std::string& groupName) const;
+
+		///Write the memory held by each resource group to the log
+		void logMemoryUsage() const;
+
+		///Set how many bytes (CPU and GPU) the loaded resources of a group can hold. When it's exceeded, the least recently used resources
+		///that nothing references anymore are unloaded. They will be loaded again when needed. 0 removes the budget
+		void setGroupMemoryBudget(const std::string& groupName, size_t bytes);
+
+		///Get the memory budget of a group, 0 if it has none
+		size_t getGroupMemoryBudget(const std::string& groupName) const;
+
 		///Return the default resource group name
 		static const char* getDefaultResourceGroupName();
 
 		///Return the reserved resource group name
 		static const char* getReservedResourceGroupName();
 
+	protected:
+		///Enforce the memory budgets of the groups
+		void update() override;
+
+		///Only update if a group has a memory budget
+		bool needUpdate() override;
+
 	private:
+		///Call a function on every resource declared in a group
+		void forEachResource(const std::string& groupName, const std::function<void(Ogre::ResourceManager*, const Ogre::ResourcePtr&)>& function) const;
+
+		///Return true if resources of this type live on the graphics card
+		static bool isGpuResourceType(const Ogre::String& resourceType);
+
+		///Unload unreferenced resources of the group, least recently used first, until it fits in the budget
+		void enforceMemoryBudget(const std::string& groupName, size_t budget);
+
 		///Log the fact that resource location creation as been rejected
 		static void refuseResource(const std::string& name, const std::string& group);
 
-		///Add to the default resource group "FileSystem=media" and "Zip=media/CORE.zip"
+		///Make the "AnnPack" archive type known to Ogre
+		static void registerPackArchiveFactory();
+
+		///Add to the default resource group "FileSystem=media" and "AnnPack=media/CORE.annpak", or "Zip=media/CORE.zip" if there's no pack
 		void addDefaultResourceLocation() const;
 
+		///A group being loaded in the background
+		struct AsyncGroupLoad
+		{
+			///Resources to load, in the order Ogre would load them
+			std::vector<Ogre::ResourcePtr> resources;
+			///Set when the resource at the same index is prepared
+			std::vector<bool> prepared;
+			///Number of resources done. They are finished in order
+			size_t loaded;
+			///Set when every resource is done
+			std::promise<void> done;
+			///Future of done
+			std::shared_future<void> future;
+		};
+
+		///A resource of a group is prepared. Finish loading the prepared resources on the main thread in order, and report the progress of the group
+		void finishAsyncResource(const std::string& groupName, size_t index);
+
+		///Find the archive a resource will be read from, nullptr if it's nowhere. Resources declared in the autodetect group are moved to the group that has their file
+		Ogre::Archive* findArchive(const Ogre::ResourcePtr& resource) const;
+
+		///Return true if many threads can read from this archive at once, without Ogre locking it
+		static bool isConcurrentlyReadable(const Ogre::Archive* archive);
+
+		///Groups being loaded in the background
+		std::map<std::string, std::shared_ptr<AsyncGroupLoad>> asyncLoads;
+
+		///Memory budget of the groups that have one
+		std::map<std::string, size_t> groupMemoryBudgets;
+
+		///Last time the loaded resources of a budgeted group were seen referenced, by group and resource handle
+		std::map<std::string, std::unordered_map<Ogre::ResourceHandle, std::chrono::steady_clock::time_point>> resourceLastUse;
+
+		///Next time the budgets are checked
+		std::chrono::steady_clock::time_point nextBudgetCheck;
+
 		///Pointer to the resource group manager. We cache the address to prevent calling a static method all the time
 		Ogre::ResourceGroupManager* ResourceGroupManager;
 	};
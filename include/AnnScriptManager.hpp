@@ -10,6 +10,11 @@
 #include <chaiscript_stdlib.hpp>
 #include <AnnTypes.h>
 
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
 namespace Annwvyn
 {
 	class AnnGameObject;
@@ -32,11 +37,40 @@ namespace Annwvyn
 		TriggerHook,
 		HandHook,
 		CollisionHook,
-		PlayerCollisionHook
+		PlayerCollisionHook,
+		HookCount
+	};
+
+	class AnnBehaviorScriptDispatcher;
+	class AnnScriptManager;
+
+	///Statistics of the calls to one hook of a script, gathered by the script profiler
+	struct AnnDllExport AnnScriptProfileEntry
+	{
+		///Number of calls
+		uint64_t calls;
+		///Time spent in all the calls, in milliseconds
+		double totalMilliseconds;
+		///Longest call, in milliseconds
+		double maxMilliseconds;
+
+		///Account for one call
+		void add(double milliseconds);
+		///Add the statistics of another entry to this one
+		void merge(const AnnScriptProfileEntry& other);
+	};
+
+	///Statistics of one script class on one game object
+	struct AnnScriptProfile
+	{
+		///Calls to update()
+		AnnScriptProfileEntry update;
+		///Calls to the event hooks, indexed by KeyHook, MouseHook...
+		std::array<AnnScriptProfileEntry, HookCount> hooks;
 	};
 
 	///Object that reprenset a script defining an object "behavior"
-	class AnnDllExport AnnBehaviorScript : LISTENER
+	class AnnDllExport AnnBehaviorScript
 	{
 	public:
 		///Invalid script constructor
@@ -63,6 +97,67 @@ namespace Annwvyn
 		///unregister this object as an event listener
 		void unregisterAsListener();
 
+	private:
+		friend class AnnBehaviorScriptDispatcher;
+		friend class AnnScriptManager;
+
+		///Call one of the event hooks, if the script class implements it
+		template <size_t Hook, class Event>
+		void callHook(const Event& e);
+
+		///Get where to account a call to a hook (HookCount for update). nullptr when the profiler is disabled
+		AnnScriptProfileEntry* getProfileEntry(size_t hook);
+
+		///Validity state of this object. Cannot change.
+		const bool valid;
+
+		///Name of this script. Name of the "class" defined in the script
+		std::string name;
+
+		///The ChaiScript object that is an instance of "name" class. BlackBox to find what "update" to call on the script engine
+		chaiscript::Boxed_Value ScriptObjectInstance;
+
+		///The "update" function. ChaiScript "object.update()" is like calling "update(object)"
+		std::function<void(chaiscript::Boxed_Value&)> callUpdateOnScriptInstance;
+
+		///Event hooks, indexed by KeyHook, MouseHook...
+		AnnBehaviorScriptHooks hooks;
+
+		///True while the script receives events
+		bool registered;
+
+		///Script manager that created this script
+		AnnScriptManager* manager;
+
+		///Name of the game object this script is attached to
+		std::string ownerName;
+
+		///Statistics of this script in the profiler, found on the first profiled call
+		AnnScriptProfile* profile;
+
+		///Just call the update on the instance
+		void callUpdateOnScript() { callUpdateOnScriptInstance(ScriptObjectInstance); }
+	};
+
+	///Single event listener of all the behavior scripts. Each event is only given to the scripts which class implements a hook for it
+	class AnnDllExport AnnBehaviorScriptDispatcher : LISTENER
+	{
+	public:
+		///Construct an empty dispatcher
+		AnnBehaviorScriptDispatcher();
+
+		///Start sending events to this script
+		void add(AnnBehaviorScript* script);
+
+		///Stop sending events to this script
+		void remove(AnnBehaviorScript* script);
+
+		///Return true if no script receives events
+		bool empty() const;
+
+		///Get the number of scripts that receive the events of a hook (KeyHook, MouseHook...)
+		size_t getScriptCount(size_t hook) const;
+
 		///Event from the keyboard
 		void KeyEvent(AnnKeyEvent e) override;
 		///Event from the mouse
@@ -81,39 +176,21 @@ namespace Annwvyn
 		void PlayerCollisionEvent(AnnPlayerCollisionEvent e) override;
 
 	private:
-		///Validity state of this object. Cannot change.
-		const bool valid;
+		///Call the hook on every script of its table
+		template <size_t Hook, class Event>
+		void dispatch(const Event& e);
 
-		///Name of this script. Name of the "class" defined in the script
-		std::string name;
+		///For each hook, the scripts that implement it. Removed scripts are set to nullptr while dispatching
+		std::array<std::vector<AnnBehaviorScript*>, HookCount> tables;
 
-		///The ChaiScript object that is an instance of "name" class. BlackBox to find what "update" to call on the script engine
-		chaiscript::Boxed_Value ScriptObjectInstance;
+		///Number of registered scripts
+		size_t scriptCount;
 
-		///The "update" function. ChaiScript "object.update()" is like calling "update(object)"
-		std::function<void(chaiscript::Boxed_Value&)> callUpdateOnScriptInstance;
-		///Hook for key event
-		std::function<void(chaiscript::Boxed_Value&, AnnKeyEvent)> callKeyEventOnScriptInstance;
-		///Hook for Mouse event
-		std::function<void(chaiscript::Boxed_Value&, AnnMouseEvent)> callMouseEventOnScriptInstance;
-		///Hook for Stick event
-		std::function<void(chaiscript::Boxed_Value&, AnnControllerEvent)> callStickEventOnScriptInstance;
-		///Hook for Time event
-		std::function<void(chaiscript::Boxed_Value&, AnnTimeEvent)> callTimeEventOnScriptInstance;
-		///Hook for Trigger event
-		std::function<void(chaiscript::Boxed_Value&, AnnTriggerEvent)> callTriggerEventOnScriptInstance;
-		///Hook for Hand Controller event
-		std::function<void(chaiscript::Boxed_Value&, AnnHandControllerEvent)> callHandControllertOnScriptInstance;
-		///Hook for Collision event
-		std::function<void(chaiscript::Boxed_Value&, AnnCollisionEvent)> callCollisionEventOnScriptInstance;
-		///Hook for PlayerCollision event
-		std::function<void(chaiscript::Boxed_Value&, AnnPlayerCollisionEvent)> callPlayerCollisionEventOnScriptInstance;
-
-		///Call guards for the hooks above.
-		bool cannotKey, cannotMouse, cannotStick, cannotTime, cannotTrigger, cannotHand, cannotCollision, cannotPlayerCollision;
+		///Set while an event is being dispatched
+		bool dispatching;
 
-		///Just call the update on the instance
-		void callUpdateOnScript() { callUpdateOnScriptInstance(ScriptObjectInstance); }
+		///Set when a table has null entries to remove
+		bool needCompaction;
 	};
 
 	///Script Manager, serve as an interface between ChaiScript and the rest of the engine
@@ -146,10 +223,46 @@ namespace Annwvyn
 		///GetAccess to the chaiscript engine. Only use for special cases.
 		chaiscript::ChaiScript* _getEngine();
 
+		///Enable or disable the script profiler. When enabled, the time spent in each update() and event hook is recorded per script class and game object
+		void setProfilingEnabled(bool state);
+
+		///Return true if the script profiler is enabled
+		bool isProfilingEnabled() const;
+
+		///Forget everything recorded by the script profiler
+		void resetProfile();
+
+		///Get the hooks where scripts spent the most time, one line per script class and hook, most expensive first
+		std::vector<std::string> getProfileReport(size_t maxLines = 10) const;
+
+		///Write everything recorded by the script profiler as CSV, one line per script class, game object and hook. Return false if the file can't be written
+		bool dumpProfile(const std::string& path) const;
+
 	private:
+		friend class AnnBehaviorScript;
+		friend class AnnBehaviorScriptDispatcher;
+
 		///ChaiScript engine
 		chaiscript::ChaiScript chai;
 
+		///Listener that sends the events to the scripts
+		std::shared_ptr<AnnBehaviorScriptDispatcher> dispatcher;
+
+		///Start sending events to a script. The dispatcher only listens to events while there are scripts
+		void registerBehaviorScript(AnnBehaviorScript* script);
+
+		///Stop sending events to a script
+		void unregisterBehaviorScript(AnnBehaviorScript* script);
+
+		///Get the statistics of a script class on a game object
+		AnnScriptProfile& getProfile(const std::string& scriptName, const std::string& owner);
+
+		///State of the script profiler
+		bool profiling;
+
+		///Statistics of the script profiler, by script class then owner name. Entries are never removed, scripts keep pointers to them
+		std::map<std::string, std::map<std::string, AnnScriptProfile>> profiles;
+
 		///Pointer to the script manager
 		AnnScriptFileResourceManager* scriptFileManager;
 
@@ -171,48 +284,22 @@ namespace Annwvyn
 		///Prefix for debug print called from a script
 		static constexpr const char* const logFromScript { "Script - " };
 
-		///String constant for script loading and class initialization. This is a bit of ChaiScript code to bootstrap a behavior script
-		static constexpr const char* const scriptTemplate {
-			R"chaiscript(def create__SCRIPT_NAME____OBJECT_SCRIPT_ID__(owner)
-						{
-							var ScriptInstance__OBJECT_SCRIPT_ID__ = __SCRIPT_NAME__(owner);
-							return ScriptInstance__OBJECT_SCRIPT_ID__;
-						})chaiscript"
+		///A script class, compiled once when its file is evaluated. Instances only need a call to the constructor
+		struct ScriptClass
+		{
+			///The ChaiScript constructor of the class, taking the name of the owner
+			std::function<chaiscript::Boxed_Value(std::string)> constructor;
+			///The "update" function
+			std::function<void(chaiscript::Boxed_Value&)> update;
+			///Event hooks, null for the events that have no function defined
+			AnnBehaviorScriptHooks hooks;
 		};
 
-		///Marker for the name of the script
-		static constexpr const char* const scriptNameMarker { "__SCRIPT_NAME__" };
-		///Marker for the ID of the script
-		static constexpr const char* const scriptObjectID { "__OBJECT_SCRIPT_ID__" };
-		///Marker for the owner of the script
-		static constexpr const char* const scriptOwnerMarker { "__SCRIPT_OWNER__" };
-		///Prefix of the name of an instance
-		static constexpr const char* const scriptInstanceMarker { "ScriptInstance" };
-		///Prefix for the owner of a script
-		static constexpr const char* const scriptOwnerPrefix { "ScriptOwner" };
-
-		///Static lengths of constant string of the same name
-		static constexpr const size_t nameMarkerLen { 15 };
-		///Static lengths of constant string of the same name
-		static constexpr const size_t scriptIDMarkerLen { 20 };
-		///Static lengths of constant string of the same name
-		static constexpr const size_t scriptOwnerMarkerLen { 16 };
-
-		///Static counter that will be incremented at each script creation
-		static AnnScriptID ID;
-
-		///To create the event hooks for the scripts :
-		std::function<void(chaiscript::Boxed_Value&, AnnKeyEvent)> callKeyEventOnScriptInstance;
-		std::function<void(chaiscript::Boxed_Value&, AnnMouseEvent)> callMouseEventOnScriptInstance;
-		std::function<void(chaiscript::Boxed_Value&, AnnControllerEvent)> callStickEventOnScriptInstance;
-		std::function<void(chaiscript::Boxed_Value&, AnnTimeEvent)> callTimeEventOnScriptInstance;
-		std::function<void(chaiscript::Boxed_Value&, AnnTriggerEvent)> callTriggerEventOnScriptInstance;
-		std::function<void(chaiscript::Boxed_Value&, AnnHandControllerEvent)> callHandControllertOnScriptInstance;
-		std::function<void(chaiscript::Boxed_Value&, AnnCollisionEvent)> callCollisionEventOnScriptInstance;
-		std::function<void(chaiscript::Boxed_Value&, AnnPlayerCollisionEvent)> callPlayerCollisionEventOnScriptInstance;
-
-		///Hook the event listener's "methdod" to the script ones, if possible...
-		void tryAndGetEventHooks();
+		///Script classes already compiled, by name
+		std::unordered_map<std::string, ScriptClass> scriptClasses;
+
+		///Get the compiled class of a script, evaluate its file and compile it if needed. Throw what ChaiScript throws
+		const ScriptClass& getScriptClass(const std::string& scriptName);
 	};
 
 	using AnnScriptManagerPtr = std::shared_ptr<AnnScriptManager>;
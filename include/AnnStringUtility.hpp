@@ -5,9 +5,19 @@
 #include <memory>
 #include <functional>
 #include <random>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
 
 namespace Annwvyn
 {
+	///Compact identifier of an interned string. Two equal strings always get the same ID
+	using AnnStringID = uint32_t;
+
+	///ID that is never given to any string
+	constexpr AnnStringID AnnInvalidStringID { 0 };
+
 	///String management utility. Every hashed string in the engine is generated by this object
 	class AnnDllExport AnnStringUility
 	{
@@ -21,6 +31,18 @@ namespace Annwvyn
 		///Get a string of random characters of specified length. 15 char by default
 		std::string getRandomString(size_t length = 15U);
 
+		///Get the ID of a string, adding it to the table if needed. Thread safe
+		AnnStringID intern(const std::string& string);
+
+		///Get the ID of a string if it has already been interned, AnnInvalidStringID otherwise. Never grows the table. Thread safe
+		AnnStringID find(const std::string& string) const;
+
+		///Get back the string from it's ID. The reference stays valid for the lifetime of this object. Thread safe
+		const std::string& getString(AnnStringID id) const;
+
+		///Get the number of interned strings
+		size_t getInternedCount() const;
+
 	private:
 		///Hasher
 		std::unique_ptr<std::hash<std::string>> stringHasher;
@@ -28,6 +50,13 @@ namespace Annwvyn
 		std::random_device r;
 		///mt engine
 		std::mt19937_64 mt;
+
+		///String to ID table
+		std::unordered_map<std::string, AnnStringID> internedIDs;
+		///ID to string table. Index is ID - 1. A deque never moves its elements when growing
+		std::deque<std::string> internedStrings;
+		///Interning can happen from worker threads
+		mutable std::shared_mutex internMutex;
 	};
 
 	using AnnStringUtilityPtr = std::shared_ptr<AnnStringUility>;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "systemMacro.h"
+#include "AnnStringUtility.hpp"
 
 #include <string>
 #include <memory>
@@ -19,6 +20,9 @@ namespace Annwvyn
 		///Destruct a SubSystem
 		virtual ~AnnSubSystem();
 
+		///Get the interned ID of the name of this subsystem
+		AnnStringID getNameID() const;
+
 	protected:
 		friend class AnnEngine;
 
@@ -30,6 +34,9 @@ namespace Annwvyn
 
 		///Name of the subsystem
 		std::string name;
+
+		///Interned ID of the name
+		AnnStringID nameID;
 	};
 
 	using AnnSubSystemPtr = std::shared_ptr<AnnSubSystem>;
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "systemMacro.h"
+#include "AnnSubsystem.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Annwvyn
+{
+	///Pool of worker threads, and a queue of work that has to be finished on the main thread, within a time budget each frame.
+	class AnnDllExport AnnTaskManager : public AnnSubSystem
+	{
+	public:
+		///A piece of work
+		using Task = std::function<void()>;
+
+		///Construct the task manager. 0 worker means "one less than the number of hardware threads"
+		AnnTaskManager(size_t workerCount = 0);
+
+		///Stop and join all workers. Work still in the queues is discarded
+		~AnnTaskManager();
+
+		AnnTaskManager(const AnnTaskManager&) = delete;
+		AnnTaskManager& operator=(const AnnTaskManager&) = delete;
+
+		///Run a callable on a worker thread. The returned future will hold the result, or the exception thrown
+		template <class Callable>
+		auto submit(Callable&& work) -> std::future<decltype(work())>
+		{
+			using Result = decltype(work());
+			auto task	= std::make_shared<std::packaged_task<Result()>>(std::forward<Callable>(work));
+			auto future  = task->get_future();
+			pushWorkerTask([task] { (*task)(); });
+			return future;
+		}
+
+		///Queue some work to be done on the main thread. Can be called from any thread. The work is run by update() within the frame budget
+		void runOnMainThread(Task work);
+
+		///Set how many milliseconds of main thread work can be done per frame. At least one queued task will run each frame whatever the budget.
+		void setMainThreadBudget(double milliseconds);
+
+		///Get the milliseconds per frame given to main thread work
+		double getMainThreadBudget() const;
+
+		///Get the number of worker threads
+		size_t getWorkerCount() const;
+
+		///Get the number of tasks waiting for, or running on a worker
+		size_t getPendingWorkerTaskCount() const;
+
+		///Get the number of tasks waiting to be run on the main thread
+		size_t getPendingMainThreadTaskCount() const;
+
+		///Return true if the caller is on the thread that created the engine
+		bool isMainThread() const;
+
+		///Wait for a future. On the main thread, queued main thread work is run meanwhile, as the future may depend on it
+		template <class Future>
+		void wait(const Future& future)
+		{
+			if(!isMainThread()) return future.wait();
+			while(future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				if(!runMainThreadTask()) future.wait_for(std::chrono::milliseconds(1));
+		}
+
+	protected:
+		///Run queued main thread work until the budget is spent
+		void update() override;
+
+		///Only update when there's something to do on the main thread
+		bool needUpdate() override;
+
+	private:
+		///Push work to the worker queue and wake up a worker
+		void pushWorkerTask(Task task);
+
+		///Main loop of a worker thread
+		void workerLoop();
+
+		///Run the oldest main thread task. Return false if there is none
+		bool runMainThreadTask();
+
+		///Worker threads
+		std::vector<std::thread> workers;
+
+		///Work waiting for a worker
+		std::deque<Task> workerQueue;
+
+		///Protect the workerQueue and the stopping flag
+		mutable std::mutex workerMutex;
+
+		///Wake up a worker
+		std::condition_variable workerCondition;
+
+		///Set when the workers need to quit
+		bool stopping;
+
+		///Tasks pushed and not finished by the workers
+		std::atomic<size_t> pendingWorkerTasks;
+
+		///Work waiting to be run on the main thread
+		std::deque<Task> mainThreadQueue;
+
+		///Protect the mainThreadQueue
+		mutable std::mutex mainThreadMutex;
+
+		///Time budget for main thread work, in milliseconds
+		double mainThreadBudget;
+
+		///Identifier of the main thread
+		std::thread::id mainThreadId;
+	};
+
+	using AnnTaskManagerPtr = std::shared_ptr<AnnTaskManager>;
+}
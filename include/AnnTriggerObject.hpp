@@ -9,6 +9,7 @@
 #include "systemMacro.h"
 #include <AnnTypes.h>
 #include "AnnAbstractMovable.hpp"
+#include "AnnStringUtility.hpp"
 #include <BulletCollision/CollisionShapes/btCollisionShape.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
 
@@ -41,6 +42,9 @@ namespace Annwvyn
 
 		std::string getName() const;
 
+		///Get the interned ID of the name of this trigger
+		AnnStringID getNameID() const;
+
 		///Class destructor
 		virtual ~AnnTriggerObject();
 
@@ -65,6 +69,7 @@ namespace Annwvyn
 
 	private:
 		const std::string name;
+		AnnStringID nameID;
 
 		///For engine : Set contact state
 		/// \param contact Contact state
@@ -99,6 +99,7 @@ namespace Annwvyn
 #include <AnnException.hpp>
 #include <AnnStringUtility.hpp>
 #include <AnnScriptManager.hpp>
+#include <AnnTaskManager.hpp>
 
 //Other Annwvyn
 #include <AnnTypes.h>
@@ -5,14 +5,43 @@
 #include "AnnGetter.hpp"
 #include "Annwvyn.h"
 #include <string>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
 
 using namespace Annwvyn;
 
+unsigned AnnAudioEngine::loopbackSampleRate { 0 };
+
+void AnnAudioEngine::setLoopbackRendering(unsigned sampleRate)
+{
+	loopbackSampleRate = sampleRate;
+}
+
 AnnAudioEngine::AnnAudioEngine() :
  AnnSubSystem("AudioEngine"),
  lastError("Initialize OpenAL based sound system"),
  alDevice(nullptr),
  alContext(nullptr),
+ useCounter(0),
+ bufferCacheBudget(0),
+ residentBytes(0),
+ cacheHits(0),
+ cacheMisses(0),
+ cacheEvictions(0),
+ voiceLimit(32),
+ audibilityThreshold(0.001f),
+ listenerPosition(AnnVect3::ZERO),
+ submittedBatch(0),
+ appliedBatch(0),
+ feedbackBatch(0),
+ audioThreadRunning(false),
+ alDeferUpdates(nullptr),
+ alProcessUpdates(nullptr),
+ alcRenderSamples(nullptr),
+ loopbackFrameCarry(0),
+ renderedFrames(0),
+ renderTime(0),
  audioFileManager(nullptr)
 {
 	//Try to init OpenAL
@@ -23,6 +52,7 @@ AnnAudioEngine::AnnAudioEngine() :
 	const auto player   = AnnGetPlayer();
 	const auto position = player->getPosition();
 	alListener3f(AL_POSITION, position.x, position.y, position.z);
+	listenerPosition = position;
 
 	//Define the default orientation
 	const AnnQuaternion orientation = player->getOrientation().toQuaternion();
@@ -33,11 +63,28 @@ AnnAudioEngine::AnnAudioEngine() :
 	//Apply the orientation
 	alListenerfv(AL_ORIENTATION, alOrientation);
 
-	//Create a source for the BGM
-	alGenSources(1, &bgmSource);
 	locked = false;
 
+	//Everything in a batch of commands is heard at the same time with this extension
+	if(alIsExtensionPresent("AL_SOFT_deferred_updates"))
+	{
+		alDeferUpdates   = reinterpret_cast<LPALDEFERUPDATESSOFT>(alGetProcAddress("alDeferUpdatesSOFT"));
+		alProcessUpdates = reinterpret_cast<LPALPROCESSUPDATESSOFT>(alGetProcAddress("alProcessUpdatesSOFT"));
+	}
+	if(!alDeferUpdates || !alProcessUpdates)
+	{
+		AnnDebug() << "AL_SOFT_deferred_updates is not available, audio state changes will not be batched";
+		alDeferUpdates   = nullptr;
+		alProcessUpdates = nullptr;
+	}
+
+	audioThreadRunning = true;
+	audioThread		   = std::thread([this] { audioThreadLoop(); });
+
 	audioFileManager = OGRE_NEW AnnAudioFileManager;
+
+	//Create a stream for the BGM
+	bgmStream = createStream();
 }
 
 void AnnAudioEngine::logError() const
@@ -47,6 +94,10 @@ void AnnAudioEngine::logError() const
 
 AnnAudioEngine::~AnnAudioEngine()
 {
+	//Workers may still be reading files through the audio file manager
+	for(auto& pending : pendingBuffers)
+		if(pending.second->onWorker) pending.second->decoded.wait();
+
 	locked = true;
 	shutdownOpenAL();
 
@@ -75,7 +126,7 @@ void AnnAudioEngine::detectPlaybackDevices(const char* list)
 	}
 }
 
-bool AnnAudioEngine::initOpenAL()
+bool AnnAudioEngine::openPlaybackDevice()
 {
 	//Open audio playback device
 	//Check if OpenAL support device enumeration extension here
@@ -110,16 +161,96 @@ bool AnnAudioEngine::initOpenAL()
 		return false;
 	}
 
-	//Create context and make it current
+	//Create context
 	alContext = alcCreateContext(alDevice, nullptr);
 	if(!alContext)
 	{
 		lastError = "Failed to create an OpenAL Context";
+		closeDevice();
 		return false;
 	}
+
+	return true;
+}
+
+bool AnnAudioEngine::openLoopbackDevice()
+{
+	AnnDebug() << "Opening an OpenAL loopback device rendering at " << loopbackSampleRate << "Hz";
+	if(!alcIsExtensionPresent(nullptr, "ALC_SOFT_loopback"))
+	{
+		lastError = "ALC_SOFT_loopback is not supported, cannot render audio in memory";
+		return false;
+	}
+
+	const auto loopbackOpenDevice = reinterpret_cast<LPALCLOOPBACKOPENDEVICESOFT>(alcGetProcAddress(nullptr, "alcLoopbackOpenDeviceSOFT"));
+	const auto isRenderFormatSupported = reinterpret_cast<LPALCISRENDERFORMATSUPPORTEDSOFT>(alcGetProcAddress(nullptr, "alcIsRenderFormatSupportedSOFT"));
+	alcRenderSamples = reinterpret_cast<LPALCRENDERSAMPLESSOFT>(alcGetProcAddress(nullptr, "alcRenderSamplesSOFT"));
+	if(!loopbackOpenDevice || !isRenderFormatSupported || !alcRenderSamples)
+	{
+		lastError		 = "Cannot get the ALC_SOFT_loopback functions";
+		alcRenderSamples = nullptr;
+		return false;
+	}
+
+	alDevice = loopbackOpenDevice(nullptr);
+	if(!alDevice)
+	{
+		lastError = "Failed to open an OpenAL loopback device";
+		alcRenderSamples = nullptr;
+		return false;
+	}
+
+	//Always render 16bit stereo
+	if(!isRenderFormatSupported(alDevice, ALCsizei(loopbackSampleRate), ALC_STEREO_SOFT, ALC_SHORT_SOFT))
+	{
+		lastError = "The loopback device cannot render 16bit stereo at " + std::to_string(loopbackSampleRate) + "Hz";
+		closeDevice();
+		return false;
+	}
+
+	const ALCint attributes[] = {
+		ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+		ALC_FORMAT_TYPE_SOFT, ALC_SHORT_SOFT,
+		ALC_FREQUENCY, ALCint(loopbackSampleRate),
+		0
+	};
+
+	alContext = alcCreateContext(alDevice, attributes);
+	if(!alContext)
+	{
+		lastError = "Failed to create an OpenAL Context on the loopback device";
+		closeDevice();
+		return false;
+	}
+
+	return true;
+}
+
+void AnnAudioEngine::closeDevice()
+{
+	if(alContext)
+	{
+		alcMakeContextCurrent(nullptr);
+		alcDestroyContext(alContext);
+	}
+	if(alDevice) alcCloseDevice(alDevice);
+
+	//Nothing is rendered without a device
+	alContext		 = nullptr;
+	alDevice		 = nullptr;
+	alcRenderSamples = nullptr;
+}
+
+bool AnnAudioEngine::initOpenAL()
+{
+	//Open a sound card, or render in memory
+	if(!(loopbackSampleRate == 0 ? openPlaybackDevice() : openLoopbackDevice()))
+		return false;
+
 	if(!alcMakeContextCurrent(alContext))
 	{
 		lastError = "failed to make " + std::to_string(reinterpret_cast<uint64_t>(alContext)) + " as current context";
+		closeDevice();
 		return false;
 	}
 
@@ -143,25 +274,39 @@ bool AnnAudioEngine::initOpenAL()
 
 void AnnAudioEngine::shutdownOpenAL()
 {
-	//Stop and delete the bgmSource buffer
-	alSourceStop(bgmSource);
-	alDeleteSources(1, &bgmSource);
-
-	//Stop and delete other audio sources
+	//Stop streaming threads and delete their sources and buffers, even if someone still holds a stream
+	for(auto& weakStream : audioStreams)
+		if(auto stream = weakStream.lock())
+			stream->shutdown();
+	audioStreams.clear();
+	bgmStream.reset();
+
+	//Take the voices back from the sources. Sources held elsewhere should not talk to us anymore
+	for(auto& source : audioSources)
+	{
+		releaseVoice(*source);
+		source->engine = nullptr;
+	}
 	audioSources.clear();
 
-	//Delete the BGM buffer if it has been initialized
-	if(alIsBuffer(bgmBuffer) == AL_TRUE)
-		alDeleteBuffers(1, &bgmBuffer);
+	//Nobody else talks to OpenAL after this
+	stopAudioThread();
+	alcRenderSamples = nullptr;
+
+	//Delete the voice pool
+	if(!voicePool.empty())
+		alDeleteSources(ALsizei(voicePool.size()), voicePool.data());
+	voicePool.clear();
+	freeVoices.clear();
 
 	//Delete all buffers created here
-	for(auto buffer : buffers)
-		alDeleteBuffers(1, &buffer.second);
+	for(auto& buffer : buffers)
+		alDeleteBuffers(1, &buffer.second.buffer);
+	buffers.clear();
+	residentBytes = 0;
 
 	//Close the AL environment
-	alcMakeContextCurrent(nullptr);
-	alcDestroyContext(alContext);
-	alcCloseDevice(alDevice);
+	closeDevice();
 	alGetError(); //Purge pending error.
 
 	AnnAudioFile::clearSndFileVioStruct();
@@ -176,15 +321,15 @@ ALuint AnnAudioEngine::isBufferLoader(const std::string& filename)
 {
 	auto query = buffers.find(filename);
 	if(query != buffers.end())
-		return query->second;
+		return query->second.buffer;
 	return false;
 }
 
-ALuint AnnAudioEngine::loadBuffer(const std::string& filename)
+AnnAudioFilePtr AnnAudioEngine::getAudioFile(const std::string& filename) const
 {
-	if(auto buffer = isBufferLoader(filename)) return buffer;
-
-	AnnDebug() << filename << " Not loaded on an OpenAL buffer, loading from file...";
+	//Ogre's load() returns right away while a worker reads the file, before the data is there
+	const auto pending = pendingBuffers.find(filename);
+	if(pending != pendingBuffers.end() && pending->second->onWorker) pending->second->decoded.wait();
 
 	//Attempt to retrieve the resource...
 	auto audioFileResource = audioFileManager->getResourceByName(filename).staticCast<AnnAudioFile>();
@@ -192,90 +337,313 @@ ALuint AnnAudioEngine::loadBuffer(const std::string& filename)
 	{
 		audioFileResource = audioFileManager->load(filename, AnnGetResourceManager()->getDefaultResourceGroupName());
 		if(!audioFileResource) //Okay, that file doesn't exist or something.
-		{
 			AnnDebug() << "Error, cannot load file " << filename << " as a recognized audio file";
-			return 0;
-		}
+	}
+	//It may only have been declared by an asynchronous preload
+	else
+	{
+		audioFileResource->load();
 	}
 
-	// Open Audio file with libsndfile
-	SF_INFO fileInfos;
-	auto File = sf_open_virtual(audioFileResource->getSndFileVioStruct(), SFM_READ, &fileInfos, audioFileResource.getPointer());
+	return audioFileResource;
+}
+
+ALuint AnnAudioEngine::loadBuffer(const std::string& filename)
+{
+	//A worker is reading and decoding this file. Use its work instead of reading the file at the same time
+	if(const auto pending = pendingBuffers.find(filename); pending != pendingBuffers.end() && pending->second->onWorker)
+	{
+		const auto decode = pending->second;
+		decode->decoded.wait();
+		finishAsyncLoad(filename, decode);
+	}
+
+	if(auto query = buffers.find(filename); query != buffers.end())
+	{
+		//Used again, forget about a pending unload
+		++cacheHits;
+		query->second.lastUse			 = ++useCounter;
+		query->second.unloadWhenReleased = false;
+		return query->second.buffer;
+	}
 
-	//get the number of sample and the sample-rate (in samples by seconds)
-	auto nbSamples  = static_cast<ALsizei>(fileInfos.channels * fileInfos.frames);
-	auto sampleRate = static_cast<ALsizei>(fileInfos.samplerate);
+	++cacheMisses;
+	AnnDebug() << filename << " Not loaded on an OpenAL buffer, loading from file...";
 
-	AnnDebug(Log::Important) << "Loading " << nbSamples << " samples. Playback sample-rate : " << sampleRate << "Hz";
+	auto audioFileResource = getAudioFile(filename);
+	if(!audioFileResource) return 0;
 
-	//Read samples in 16bits signed
-	std::vector<float> samplesBuffer(nbSamples);
-	auto readSamples = sf_read_float(File, samplesBuffer.data(), nbSamples);
+	auto audio = decode(audioFileResource);
+	audioFileResource.setNull();
 
-	//This sometimes happen with OGG files, but it seems to run fine anyway. This is probably due to meta-data/tags present at the end of files
-	if(readSamples < nbSamples)
+	if(!audio.message.empty())
 	{
-		lastError = "Warning: It looks like the " + std::to_string(nbSamples - readSamples);
-		lastError += " last samples of the file have been omitted. Ignore if file has meta-data appended at the end. ";
+		lastError = audio.message;
 		logError();
 	}
 
-	if(sf_error(File) != SF_ERR_NO_ERROR)
+	const ALuint buffer = audio.format ? uploadBuffer(filename, audio) : 0;
+
+	//Now in an OpenAL buffer, the PCM and file data are not needed anymore
+	audio = {};
+	releaseAudioFile(filename);
+	return buffer;
+}
+
+AnnAudioEngine::DecodedAudio AnnAudioEngine::decode(const AnnAudioFilePtr& file)
+{
+	DecodedAudio audio;
+
+	//Cooked files are already what OpenAL wants
+	if(const auto cooked = file->getCookedHeader())
 	{
-		lastError = "Error while reading the file " + filename + " through sndfile library: ";
-		lastError += sf_error_number(sf_error(File));
-		logError();
-		return 0;
+		audio.cookedFile = file;
+		audio.cooked	 = cooked;
+		audio.format	 = cooked->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+		audio.sampleRate = ALsizei(cooked->sampleRate);
+		return audio;
 	}
 
-	std::vector<ALshort> alSamplesBuffer(nbSamples);
-	for(size_t i(0); i < alSamplesBuffer.size(); i++)
-		//This will step down a bit the amplitude (88% of max) of the signal to prevent saturation while using some formats (OGG)
-		alSamplesBuffer[i] = static_cast<ALshort>(0x7FFF * samplesBuffer[i] * 0.88f);
-
-	//close file
-	sf_close(File);
+	AnnAudioFileDecoder decoder(file);
+	if(!decoder.isOpen())
+	{
+		audio.message = "Error while reading the file " + file->getName() + " through sndfile library: " + decoder.getError();
+		return audio;
+	}
 
 	//Read the number of channels. sound effects should be mono and background music should be stereo
-	ALenum Format;
-	switch(fileInfos.channels)
+	const auto channels = decoder.getChannels();
+	switch(channels)
 	{
 		case 1:
-			AnnEngine::writeToLog("Mono 16bits sound loaded");
-			Format = AL_FORMAT_MONO16;
+			audio.format = AL_FORMAT_MONO16;
 			break;
 		case 2:
-			AnnEngine::writeToLog("Stereo 16bits sound loaded");
-			Format = AL_FORMAT_STEREO16;
+			audio.format = AL_FORMAT_STEREO16;
 			break;
-
 		default:
-			lastError = "Error : File has to have either one or two audio channel to be loaded";
-			logError();
-			return 0;
+			audio.message = "Error : File has to have either one or two audio channel to be loaded";
+			return audio;
 	}
 
+	//libsndfile converts and clips to signed 16bits itself
+	const auto frames = decoder.getFrameCount();
+	audio.samples.resize(size_t(frames * channels));
+	const auto readFrames = decoder.readFrames(audio.samples.data(), frames);
+	audio.sampleRate	  = ALsizei(decoder.getSampleRate());
+
+	//This sometimes happen with OGG files, but it seems to run fine anyway. This is probably due to meta-data/tags present at the end of files
+	if(readFrames < frames)
+	{
+		audio.message = "Warning: It looks like the " + std::to_string((frames - readFrames) * channels);
+		audio.message += " last samples of the file have been omitted. Ignore if file has meta-data appended at the end. ";
+		audio.samples.resize(size_t(readFrames * channels));
+	}
+
+	return audio;
+}
+
+ALuint AnnAudioEngine::uploadBuffer(const std::string& filename, const DecodedAudio& audio)
+{
+	//Somebody else loaded it in the meantime
+	if(auto buffer = isBufferLoader(filename)) return buffer;
+
+	AnnDebug(Log::Important) << "Loading " << audio.getSampleCount() << " samples. Playback sample-rate : " << audio.sampleRate << "Hz";
+	AnnEngine::writeToLog(audio.format == AL_FORMAT_MONO16 ? "Mono 16bits sound loaded" : "Stereo 16bits sound loaded");
+
 	//create OpenAL buffer
-	ALuint buffer;
+	ALuint buffer { 0 };
 	alGenBuffers(1, &buffer);
 	AnnDebug() << "Created OpenAL buffer at index " << buffer;
 
 	//load data into buffer
-	alBufferData(buffer, Format, &alSamplesBuffer[0], nbSamples * sizeof(ALshort), sampleRate);
+	const auto bytes = audio.getSampleCount() * sizeof(int16_t);
+	if(alIsBuffer(buffer)) alBufferData(buffer, audio.format, audio.getSamples(), ALsizei(bytes), audio.sampleRate);
 
-	//check errors
-	if(alGetError() != AL_NO_ERROR)
+	//The audio thread uses the context too, alGetError() could report one of its errors. Ask the buffer what it holds instead
+	ALint size { -1 };
+	if(alIsBuffer(buffer)) alGetBufferi(buffer, AL_SIZE, &size);
+	if(size != ALint(bytes))
 	{
 		lastError = "Error : cannot create an audio buffer for : " + filename;
 		logError();
+		if(alIsBuffer(buffer)) alDeleteBuffers(1, &buffer);
 		return 0;
 	}
 
 	AnnDebug() << filename << " successfully loaded into audio engine";
-	buffers[filename] = buffer;
+	buffers[filename] = { buffer, bytes, 0, ++useCounter, false };
+	residentBytes += bytes;
+
+	//The budget may be too small for this buffer alone, but the caller still needs it
+	enforceBufferBudget(filename);
+	return buffer;
+}
+
+void AnnAudioEngine::releaseAudioFile(const std::string& filename) const
+{
+	auto file = audioFileManager->getResourceByName(filename);
+
+	//Keep the data if anybody else than the resource system and us holds it, a stream may be reading it
+	if(file && long(file.useCount()) <= long(Ogre::ResourceGroupManager::RESOURCE_SYSTEM_NUM_REFERENCE_COUNTS) + 1)
+		file->unload();
+}
+
+ALuint AnnAudioEngine::acquireBuffer(const std::string& filename)
+{
+	const auto buffer = loadBuffer(filename);
+	if(buffer) ++buffers[filename].references;
 	return buffer;
 }
 
+void AnnAudioEngine::releaseBuffer(const std::string& filename)
+{
+	auto query = buffers.find(filename);
+	if(query == buffers.end()) return;
+
+	auto& entry = query->second;
+	if(entry.references > 0) --entry.references;
+	entry.lastUse = ++useCounter;
+
+	if(entry.references == 0 && entry.unloadWhenReleased)
+	{
+		AnnDebug() << "Last audio source released " << filename << ", unloading it";
+		eraseBuffer(query);
+	}
+
+	enforceBufferBudget();
+}
+
+void AnnAudioEngine::eraseBuffer(std::unordered_map<std::string, BufferCacheEntry>::iterator entry)
+{
+	//Free it from memory once the voices don't use it, and remove the object from the buffer list
+	queueCommand({ AudioCommand::Type::DeleteBuffer, entry->second.buffer });
+	residentBytes -= entry->second.bytes;
+	buffers.erase(entry);
+}
+
+void AnnAudioEngine::enforceBufferBudget(const std::string& keep)
+{
+	if(bufferCacheBudget == 0) return;
+
+	while(residentBytes > bufferCacheBudget)
+	{
+		//Find the least recently used buffer that no source is attached to
+		auto victim = buffers.end();
+		for(auto it = buffers.begin(); it != buffers.end(); ++it)
+			if(it->second.references == 0 && it->first != keep && (victim == buffers.end() || it->second.lastUse < victim->second.lastUse))
+				victim = it;
+
+		//Everything is in use
+		if(victim == buffers.end()) return;
+
+		AnnDebug() << "Audio buffer cache over budget, unloading " << victim->first;
+		++cacheEvictions;
+		eraseBuffer(victim);
+	}
+}
+
+void AnnAudioEngine::setBufferCacheBudget(size_t bytes)
+{
+	bufferCacheBudget = bytes;
+	enforceBufferBudget();
+}
+
+size_t AnnAudioEngine::getBufferCacheBudget() const
+{
+	return bufferCacheBudget;
+}
+
+AnnAudioBufferCacheStats AnnAudioEngine::getBufferCacheStats() const
+{
+	return { cacheHits, cacheMisses, cacheEvictions, buffers.size(), residentBytes, bufferCacheBudget };
+}
+
+AnnAudioPreloadProgressPtr AnnAudioEngine::preLoadBufferAsync(const std::string& filename, BufferReadyCallback onReady)
+{
+	return preLoadBuffersAsync({ filename }, std::move(onReady));
+}
+
+AnnAudioPreloadProgressPtr AnnAudioEngine::preLoadBuffersAsync(const std::vector<std::string>& filenames, BufferReadyCallback onReady)
+{
+	auto progress		   = std::make_shared<AnnAudioPreloadProgress>(filenames.size());
+	const auto taskManager = AnnGetTaskManager().get();
+
+	for(const auto& filename : filenames)
+	{
+		BufferReadyCallback whenReady = [progress, onReady](const std::string& name, ALuint buffer) {
+			if(buffer)
+				++progress->loadedCount;
+			else
+				++progress->failedCount;
+			if(onReady) onReady(name, buffer);
+		};
+
+		if(const auto buffer = isBufferLoader(filename))
+		{
+			whenReady(filename, buffer);
+			continue;
+		}
+
+		//Somebody already asked for this one, just wait for it too
+		auto& entry = pendingBuffers[filename];
+		if(entry)
+		{
+			entry->callbacks.push_back(std::move(whenReady));
+			continue;
+		}
+
+		entry		 = std::make_shared<PendingDecode>();
+		auto pending = entry;
+		pending->callbacks.push_back(std::move(whenReady));
+		pending->decoded = pending->done.get_future().share();
+
+		//Declare the resource from here. It's read like any other resource, then decoded by the same thread
+		AnnAudioFilePtr file = audioFileManager->createOrRetrieve(filename, AnnGetResourceManager()->getDefaultResourceGroupName()).first.staticCast<AnnAudioFile>();
+
+		pending->onWorker = AnnGetResourceManager()->prepareInBackground(file, [this, taskManager, file, filename, pending](std::exception_ptr error) mutable {
+			try
+			{
+				if(error) std::rethrow_exception(error);
+				pending->audio = decode(file);
+			}
+			catch(const std::exception& e)
+			{
+				pending->audio.message = "Error : cannot load " + filename + " : " + e.what();
+			}
+
+			//Don't hold the file, so the main thread can release it's data
+			file.setNull();
+			pending->done.set_value();
+
+			taskManager->runOnMainThread([this, pending, filename] { finishAsyncLoad(filename, pending); });
+		});
+	}
+
+	return progress;
+}
+
+void AnnAudioEngine::finishAsyncLoad(const std::string& filename, const std::shared_ptr<PendingDecode>& pending)
+{
+	//loadBuffer() didn't wait for the main thread to finish it
+	const auto query = pendingBuffers.find(filename);
+	if(query == pendingBuffers.end() || query->second != pending) return;
+	pendingBuffers.erase(query);
+
+	auto& audio = pending->audio;
+	if(!audio.message.empty())
+	{
+		lastError = audio.message;
+		logError();
+	}
+
+	const ALuint buffer = audio.format ? uploadBuffer(filename, audio) : 0;
+	audio				= {};
+	releaseAudioFile(filename);
+
+	for(auto& callback : pending->callbacks) callback(filename, buffer);
+}
+
 void AnnAudioEngine::unloadBuffer(const std::string& filename)
 {
 	if(locked) return;
@@ -290,48 +658,58 @@ void AnnAudioEngine::unloadBuffer(const std::string& filename)
 		return; //if query is equal to iterator::end(), buffer isn't known
 	}
 
-	//Get the buffer from the iterator
-	AnnDebug() << "Sound file found by the Audio resource system. OpenAL buffer " << query->second;
-	auto buffer = query->second;
+	AnnDebug() << "Sound file found by the Audio resource system. OpenAL buffer " << query->second.buffer;
 
-	//Free it from memory and remove the object from the buffer list
-	alDeleteBuffers(1, &buffer);
+	//Sources still play it, releaseBuffer() will unload it after the last one
+	if(query->second.references > 0)
+	{
+		AnnDebug() << query->second.references << " audio sources are still using " << filename << ", it will be unloaded when they stop using it";
+		query->second.unloadWhenReleased = true;
+		return;
+	}
+
+	eraseBuffer(query);
 	AnnDebug() << "Buffer deleted";
-	buffers.erase(query);
 }
 
 void AnnAudioEngine::playBGM(const std::string& filename, const float volume)
 {
 	AnnDebug() << "Using " << filename << " as BGM";
 
-	//Load buffer from disk or cache
-	bgmBuffer = loadBuffer(filename);
-
-	//Set parameters to the source
-	alSourcei(bgmSource, AL_BUFFER, bgmBuffer);
-	alSourcei(bgmSource, AL_LOOPING, AL_TRUE);
-	alSourcef(bgmSource, AL_GAIN, volume);
+	//Music is streamed, it's never fully decoded in memory
+	bgmStream->setVolume(volume);
+	bgmStream->play(filename, true);
+}
 
-	//Put the source in play mode
-	alSourcePlay(bgmSource);
+void AnnAudioEngine::queueBGM(const std::string& filename, bool loop)
+{
+	AnnDebug() << "Queuing " << filename << " as next BGM";
+	bgmStream->queueNext(filename, loop);
 }
 
 void AnnAudioEngine::stopBGM() const
 {
 	AnnDebug() << "Stop any BGM playing";
-	alSourceStop(bgmSource);
+	bgmStream->stop();
+}
+
+AnnAudioStreamPtr AnnAudioEngine::createStream()
+{
+	//Forget about the streams that don't exist anymore
+	audioStreams.erase(std::remove_if(std::begin(audioStreams), std::end(audioStreams), [](const std::weak_ptr<AnnAudioStream>& stream) {
+						   return stream.expired();
+					   }),
+					   std::end(audioStreams));
+
+	auto stream = std::make_shared<AnnAudioStream>();
+	audioStreams.push_back(stream);
+	return stream;
 }
 
 void AnnAudioEngine::updateListenerPos(AnnVect3 pos)
 {
-	alListener3f(AL_POSITION, pos.x, pos.y, pos.z);
-	//make sure that all positions are synced
-	for(auto source : audioSources)
-		if(source->posRelToPlayer)
-		{
-			AnnVect3 absolute = pos + source->pos;
-			alSource3f(source->source, AL_POSITION, absolute.x, absolute.y, absolute.z);
-		}
+	queueCommand({ AudioCommand::Type::ListenerPosition, 0, 0, { pos.x, pos.y, pos.z } });
+	listenerPosition = pos;
 }
 
 void AnnAudioEngine::updateListenerOrient(AnnQuaternion orient)
@@ -339,9 +717,7 @@ void AnnAudioEngine::updateListenerOrient(AnnQuaternion orient)
 	const auto at = orient.getAtVector(); // Direction object facing
 	const auto up = orient.getUpVector(); // Up Vector
 
-	const ALfloat orientation[] = { at.x, at.y, at.z, up.x, up.y, up.z };
-
-	alListenerfv(AL_ORIENTATION, orientation);
+	queueCommand({ AudioCommand::Type::ListenerOrientation, 0, 0, { at.x, at.y, at.z, up.x, up.y, up.z } });
 }
 
 void AnnAudioEngine::update()
@@ -349,6 +725,397 @@ void AnnAudioEngine::update()
 	const auto pose = AnnGetVRRenderer()->trackedHeadPose;
 	updateListenerPos(pose.position);
 	updateListenerOrient(pose.orientation);
+	updateVoices(pose.position, float(AnnGetEngine()->getFrameTime()));
+
+	//Render as much audio as the time that passed
+	if(isLoopback())
+	{
+		loopbackFrameCarry += AnnGetEngine()->getFrameTime() * loopbackSampleRate;
+		const auto frames = std::floor(loopbackFrameCarry);
+		loopbackFrameCarry -= frames;
+		queueCommand({ AudioCommand::Type::Render, 0, ALint(frames) });
+	}
+
+	//Everything done to the sources during this frame is applied together
+	submitCommands();
+}
+
+void AnnAudioEngine::updateVoices(AnnVect3 listener, float deltaTime)
+{
+	//What the voices looked like after the last batch the audio thread applied
+	uint64_t frameFeedbackBatch;
+	{
+		std::lock_guard<std::mutex> lock(feedbackMutex);
+		frameFeedback	  = voiceFeedback;
+		frameFeedbackBatch = feedbackBatch;
+	}
+
+	voiceCandidates.clear();
+	for(auto& sourcePtr : audioSources)
+	{
+		auto& source = *sourcePtr;
+
+		//Playback position advances on its own, real voices correct it below
+		if(source.state == AnnAudioSource::State::Playing)
+			source.playbackOffset += deltaTime;
+
+		if(source.voice)
+		{
+			//Real voices tell us where they are, and if they reached the end. Feedback older than the last play/stop is meaningless
+			if(frameFeedbackBatch >= source.voiceSyncBatch && source.voiceIndex < frameFeedback.size())
+			{
+				const auto& feedback = frameFeedback[source.voiceIndex];
+				if(source.state == AnnAudioSource::State::Playing && feedback.state == AL_STOPPED)
+				{
+					source.state		  = AnnAudioSource::State::Stopped;
+					source.playbackOffset = 0;
+				}
+				else if(feedback.state == AL_PLAYING)
+				{
+					source.playbackOffset = feedback.offset;
+				}
+			}
+		}
+		else if(source.state == AnnAudioSource::State::Playing && source.playbackOffset >= source.duration)
+		{
+			//Virtual voices reach the end on their own
+			if(source.looping && source.duration > 0)
+			{
+				source.playbackOffset = std::fmod(source.playbackOffset, source.duration);
+			}
+			else
+			{
+				source.state		  = AnnAudioSource::State::Stopped;
+				source.playbackOffset = 0;
+			}
+		}
+
+		if(source.state != AnnAudioSource::State::Playing)
+		{
+			releaseVoice(source);
+			continue;
+		}
+
+		//Same curve as OpenAL's default inverse distance clamped model
+		const auto distance = source.posRelToPlayer ? source.pos.length() : listener.distance(source.pos);
+		source.audibility   = source.gain * source.priority / std::max(1.0f, distance);
+
+		if(source.audibility < audibilityThreshold)
+			releaseVoice(source);
+		else
+			voiceCandidates.push_back(&source);
+	}
+
+	//Only the most audible sounds get a voice
+	const auto byAudibility = [](const AnnAudioSource* a, const AnnAudioSource* b) { return a->audibility > b->audibility; };
+	if(voiceCandidates.size() > voiceLimit)
+	{
+		std::nth_element(std::begin(voiceCandidates), std::begin(voiceCandidates) + voiceLimit, std::end(voiceCandidates), byAudibility);
+		for(auto it = std::begin(voiceCandidates) + voiceLimit; it != std::end(voiceCandidates); ++it)
+			releaseVoice(**it);
+		voiceCandidates.resize(voiceLimit);
+	}
+
+	for(auto source : voiceCandidates)
+	{
+		if(!source->voice && !acquireVoice(*source)) continue;
+		if(source->posRelToPlayer) applyVoicePosition(*source, listener);
+	}
+}
+
+bool AnnAudioEngine::acquireVoice(AnnAudioSource& source)
+{
+	if(source.voice) return true;
+	if(!source.buffer || voicePool.size() - freeVoices.size() >= voiceLimit) return false;
+
+	if(freeVoices.empty())
+	{
+		//Like in uploadBuffer(), don't rely on the error state the audio thread shares with us
+		ALuint voice { 0 };
+		alGenSources(1, &voice);
+		if(!alIsSource(voice))
+		{
+			//The OpenAL implementation ran out of sources, that's our limit now
+			AnnDebug() << "OpenAL cannot create more than " << voicePool.size() << " sources, lowering the voice limit";
+			voiceLimit = voicePool.size();
+			return false;
+		}
+
+		//The audio thread reads the state of every voice of the pool
+		queueCommand({ AudioCommand::Type::AddVoice, voice });
+		freeVoices.push_back(voicePool.size());
+		voicePool.push_back(voice);
+	}
+
+	source.voiceIndex = freeVoices.back();
+	source.voice	  = voicePool[source.voiceIndex];
+	freeVoices.pop_back();
+	source.voiceSyncBatch = submittedBatch + 1;
+
+	queueCommand({ AudioCommand::Type::Buffer, source.voice, ALint(source.buffer) });
+	queueCommand({ AudioCommand::Type::Looping, source.voice, source.looping ? AL_TRUE : AL_FALSE });
+	queueCommand({ AudioCommand::Type::Gain, source.voice, 0, { source.gain } });
+	applyVoicePosition(source, listenerPosition);
+
+	//Continue where the virtual sound is
+	queueCommand({ AudioCommand::Type::Offset, source.voice, 0, { source.playbackOffset } });
+	if(source.state == AnnAudioSource::State::Playing)
+		queueCommand({ AudioCommand::Type::Play, source.voice });
+	return true;
+}
+
+void AnnAudioEngine::releaseVoice(AnnAudioSource& source)
+{
+	if(!source.voice) return;
+
+	//The playback offset is already tracked by updateVoices()
+	queueCommand({ AudioCommand::Type::Stop, source.voice });
+	queueCommand({ AudioCommand::Type::Buffer, source.voice, AL_NONE });
+	freeVoices.push_back(source.voiceIndex);
+	source.voice = 0;
+}
+
+void AnnAudioEngine::applyVoicePosition(const AnnAudioSource& source, AnnVect3 listener)
+{
+	const auto position = source.posRelToPlayer ? listener + source.pos : source.pos;
+	queueCommand({ AudioCommand::Type::Position, source.voice, 0, { position.x, position.y, position.z } });
+}
+
+void AnnAudioEngine::queueCommand(const AudioCommand& command)
+{
+	pendingCommands.push_back(command);
+}
+
+void AnnAudioEngine::submitCommands()
+{
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+
+		//If the audio thread is late, it will apply the two batches together
+		submittedCommands.insert(std::end(submittedCommands), std::begin(pendingCommands), std::end(pendingCommands));
+		++submittedBatch;
+	}
+	pendingCommands.clear();
+	commandReady.notify_one();
+}
+
+void AnnAudioEngine::audioThreadLoop()
+{
+	std::vector<AudioCommand> batch;
+	std::vector<ALuint> voices;
+	std::vector<VoiceFeedback> feedback;
+
+	for(;;)
+	{
+		uint64_t batchNumber;
+		{
+			std::unique_lock<std::mutex> lock(commandMutex);
+			commandReady.wait(lock, [this] { return !audioThreadRunning || submittedBatch != appliedBatch; });
+			if(submittedBatch == appliedBatch) return;
+
+			batch.swap(submittedCommands);
+			batchNumber = submittedBatch;
+		}
+
+		//Nothing is heard before the whole batch is applied
+		if(alDeferUpdates) alDeferUpdates();
+		for(const auto& command : batch) applyCommand(command, voices);
+		if(alProcessUpdates) alProcessUpdates();
+		batch.clear();
+
+		feedback.resize(voices.size());
+		for(size_t i { 0 }; i < voices.size(); ++i)
+		{
+			alGetSourcei(voices[i], AL_SOURCE_STATE, &feedback[i].state);
+			alGetSourcef(voices[i], AL_SEC_OFFSET, &feedback[i].offset);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(feedbackMutex);
+			voiceFeedback = feedback;
+			feedbackBatch = batchNumber;
+		}
+
+		std::lock_guard<std::mutex> lock(commandMutex);
+		appliedBatch = batchNumber;
+		commandReady.notify_all();
+	}
+}
+
+void AnnAudioEngine::applyCommand(const AudioCommand& command, std::vector<ALuint>& voices)
+{
+	const auto object = command.object;
+	const auto& v	 = command.values;
+
+	switch(command.type)
+	{
+		case AudioCommand::Type::AddVoice:
+			voices.push_back(object);
+			break;
+		case AudioCommand::Type::ListenerPosition:
+			alListener3f(AL_POSITION, v[0], v[1], v[2]);
+			break;
+		case AudioCommand::Type::ListenerOrientation:
+			alListenerfv(AL_ORIENTATION, v.data());
+			break;
+		case AudioCommand::Type::Position:
+			alSource3f(object, AL_POSITION, v[0], v[1], v[2]);
+			break;
+		case AudioCommand::Type::Gain:
+			alSourcef(object, AL_GAIN, v[0]);
+			break;
+		case AudioCommand::Type::Looping:
+			alSourcei(object, AL_LOOPING, command.value);
+			break;
+		case AudioCommand::Type::Buffer:
+			alSourcei(object, AL_BUFFER, command.value);
+			break;
+		case AudioCommand::Type::Offset:
+			alSourcef(object, AL_SEC_OFFSET, v[0]);
+			break;
+		case AudioCommand::Type::Play:
+			alSourcePlay(object);
+			break;
+		case AudioCommand::Type::Pause:
+			alSourcePause(object);
+			break;
+		case AudioCommand::Type::Stop:
+			alSourceStop(object);
+			break;
+		case AudioCommand::Type::Rewind:
+			alSourceRewind(object);
+			break;
+		case AudioCommand::Type::DeleteBuffer:
+			alDeleteBuffers(1, &object);
+			break;
+		case AudioCommand::Type::Render:
+			renderLoopbackSamples(size_t(command.value));
+			break;
+	}
+}
+
+void AnnAudioEngine::renderLoopbackSamples(size_t frameCount)
+{
+	if(!alcRenderSamples || frameCount == 0) return;
+
+	std::lock_guard<std::mutex> lock(loopbackMutex);
+
+	//Keep the last seconds if nobody takes the samples
+	const size_t capacity = 2 * loopbackSampleRate * loopbackCapacitySeconds;
+	const auto start	  = loopbackSamples.size();
+	loopbackSamples.resize(start + 2 * frameCount);
+
+	const auto before = std::chrono::steady_clock::now();
+	alcRenderSamples(alDevice, loopbackSamples.data() + start, ALCsizei(frameCount));
+	renderTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before).count();
+	renderedFrames += frameCount;
+
+	if(loopbackSamples.size() > capacity)
+		loopbackSamples.erase(std::begin(loopbackSamples), std::end(loopbackSamples) - capacity);
+}
+
+void AnnAudioEngine::renderLoopback(size_t frameCount)
+{
+	if(!isLoopback()) return;
+
+	//Apply everything done so far, render, and wait for the audio thread to do it
+	queueCommand({ AudioCommand::Type::Render, 0, ALint(frameCount) });
+	submitCommands();
+
+	std::unique_lock<std::mutex> lock(commandMutex);
+	const auto batch = submittedBatch;
+	commandReady.wait(lock, [&] { return appliedBatch >= batch || !audioThreadRunning; });
+}
+
+bool AnnAudioEngine::isLoopback() const
+{
+	//Reset by closeDevice() when the loopback device failed to open or has been closed
+	return alDevice && alcRenderSamples;
+}
+
+unsigned AnnAudioEngine::getLoopbackSampleRate() const
+{
+	return isLoopback() ? loopbackSampleRate : 0;
+}
+
+std::vector<int16_t> AnnAudioEngine::takeLoopbackSamples()
+{
+	std::lock_guard<std::mutex> lock(loopbackMutex);
+	std::vector<int16_t> samples;
+	samples.swap(loopbackSamples);
+	return samples;
+}
+
+size_t AnnAudioEngine::getRenderedFrameCount() const
+{
+	std::lock_guard<std::mutex> lock(loopbackMutex);
+	return renderedFrames;
+}
+
+double AnnAudioEngine::getLoopbackRenderTime() const
+{
+	std::lock_guard<std::mutex> lock(loopbackMutex);
+	return renderTime;
+}
+
+void AnnAudioEngine::stopAudioThread()
+{
+	if(!audioThread.joinable()) return;
+
+	//Apply what's left, then let the thread return once it's done
+	submitCommands();
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		audioThreadRunning = false;
+	}
+	commandReady.notify_all();
+	audioThread.join();
+}
+
+float AnnAudioEngine::getBufferDuration(ALuint buffer)
+{
+	if(!buffer) return 0;
+
+	ALint size, channels, bits, frequency;
+	alGetBufferi(buffer, AL_SIZE, &size);
+	alGetBufferi(buffer, AL_CHANNELS, &channels);
+	alGetBufferi(buffer, AL_BITS, &bits);
+	alGetBufferi(buffer, AL_FREQUENCY, &frequency);
+
+	if(channels <= 0 || bits <= 0 || frequency <= 0) return 0;
+	return float(size) / float(channels * (bits / 8) * frequency);
+}
+
+void AnnAudioEngine::setVoiceLimit(size_t voices)
+{
+	voiceLimit = voices;
+}
+
+size_t AnnAudioEngine::getVoiceLimit() const
+{
+	return voiceLimit;
+}
+
+void AnnAudioEngine::setAudibilityThreshold(float threshold)
+{
+	audibilityThreshold = std::max(0.0f, threshold);
+}
+
+float AnnAudioEngine::getAudibilityThreshold() const
+{
+	return audibilityThreshold;
+}
+
+size_t AnnAudioEngine::getRealVoiceCount() const
+{
+	return voicePool.size() - freeVoices.size();
+}
+
+size_t AnnAudioEngine::getVirtualVoiceCount() const
+{
+	return size_t(std::count_if(std::begin(audioSources), std::end(audioSources), [](const AnnAudioSourcePtr& source) {
+		return source->isVirtual();
+	}));
 }
 
 std::string AnnAudioEngine::getLastError() const
@@ -365,83 +1132,436 @@ std::shared_ptr<AnnAudioSource> AnnAudioEngine::createSource(std::string filenam
 
 void AnnAudioEngine::removeSource(std::shared_ptr<AnnAudioSource> source)
 {
-	audioSources.remove(source);
+	if(!source || source->registryIndex >= audioSources.size() || audioSources[source->registryIndex] != source) return;
+
+	releaseVoice(*source);
+
+	//Swap with the last source to keep the registry packed
+	const auto index = source->registryIndex;
+	audioSources[index].swap(audioSources.back());
+	audioSources[index]->registryIndex = index;
+	audioSources.pop_back();
+	source->registryIndex = size_t(-1);
 }
 
 std::shared_ptr<AnnAudioSource> AnnAudioEngine::createSource()
 {
-	auto audioSource		= std::make_shared<AnnAudioSource>();
-	audioSource->bufferName = "Nothing";
-	alGenSources(1, &audioSource->source);
+	auto audioSource		   = std::make_shared<AnnAudioSource>();
+	audioSource->bufferName	= "Nothing";
+	audioSource->engine		   = this;
+	audioSource->registryIndex = audioSources.size();
 
+	//The OpenAL source is taken from the voice pool when the sound plays
 	audioSources.push_back(audioSource);
-	AnnDebug() << "OpenAL:source:" << audioSource->source << " successfully created";
 
 	//Return it to the caller
 	return audioSource;
 }
 
 AnnAudioSource::AnnAudioSource() :
- source(0),
+ holdsBuffer(false),
+ engine(nullptr),
+ buffer(0),
+ duration(0),
+ voice(0),
+ voiceIndex(0),
+ voiceSyncBatch(0),
  pos(AnnVect3::ZERO),
- posRelToPlayer(false)
+ posRelToPlayer(false),
+ gain(1),
+ looping(false),
+ priority(1),
+ state(State::Stopped),
+ playbackOffset(0),
+ audibility(0),
+ registryIndex(size_t(-1))
 {
 }
 
 AnnAudioSource::~AnnAudioSource()
 {
-	AnnDebug() << "Destroying source";
-	stop();
-	alDeleteSources(1, &source);
-	source = AL_NONE;
+	if(!engine) return;
+
+	//Give the voice back, and let the cache unload that buffer when it needs to
+	engine->releaseVoice(*this);
+	if(holdsBuffer) engine->releaseBuffer(bufferName);
 }
 
 void AnnAudioSource::setPositon(AnnVect3 position)
 {
-	alSource3f(source, AL_POSITION, position.x, position.y, position.z);
 	pos = position;
+	if(voice && !posRelToPlayer) engine->applyVoicePosition(*this, AnnVect3::ZERO);
 }
 
-void AnnAudioSource::setVolume(float gain) const
+void AnnAudioSource::setVolume(float newGain)
 {
-	alSourcef(source, AL_GAIN, gain);
+	gain = newGain;
+	if(voice) engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Gain, voice, 0, { gain } });
 }
 
-void AnnAudioSource::rewind() const
+void AnnAudioSource::rewind()
 {
-	alSourceRewind(source);
+	state		   = State::Stopped;
+	playbackOffset = 0;
+	if(!voice) return;
+	engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Rewind, voice });
+	voiceSyncBatch = engine->submittedBatch + 1;
 }
 
-void AnnAudioSource::play() const
+void AnnAudioSource::play()
 {
-	alSourcePlay(source);
+	//Like OpenAL, only a paused sound resumes, everything else restarts
+	if(state != State::Paused) playbackOffset = 0;
+	state = State::Playing;
+
+	if(voice)
+	{
+		engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Offset, voice, 0, { playbackOffset } });
+		engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Play, voice });
+		voiceSyncBatch = engine->submittedBatch + 1;
+	}
+
+	//Don't wait for the next frame to be heard if there's a free voice
+	else if(engine && registryIndex != size_t(-1))
+	{
+		engine->acquireVoice(*this);
+	}
 }
 
-void AnnAudioSource::pause() const
+void AnnAudioSource::pause()
 {
-	alSourcePause(source);
+	if(state != State::Playing) return;
+	state = State::Paused;
+	if(!voice) return;
+	engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Pause, voice });
+	voiceSyncBatch = engine->submittedBatch + 1;
 }
 
-void AnnAudioSource::stop() const
+void AnnAudioSource::stop()
 {
-	alSourceStop(source);
+	state		   = State::Stopped;
+	playbackOffset = 0;
+	if(!voice) return;
+	engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Stop, voice });
+	voiceSyncBatch = engine->submittedBatch + 1;
 }
 
 void AnnAudioSource::changeSound(std::string filename)
 {
-	if(filename.empty()) return;
-	bufferName = filename;
+	if(filename.empty() || !engine) return;
+
+	const auto newBuffer = engine->acquireBuffer(filename);
+	if(!newBuffer) return;
 
-	auto buffer = AnnGetAudioEngine()->loadBuffer(bufferName);
-	if(buffer) alSourcei(source, AL_BUFFER, buffer);
+	//OpenAL doesn't change the buffer of a playing source
+	if(voice)
+	{
+		engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Stop, voice });
+		engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Buffer, voice, ALint(newBuffer) });
+		voiceSyncBatch = engine->submittedBatch + 1;
+	}
+	state		   = State::Stopped;
+	playbackOffset = 0;
+	buffer		   = newBuffer;
+	duration	   = AnnAudioEngine::getBufferDuration(buffer);
+
+	//The previous buffer is not attached anymore
+	if(holdsBuffer) engine->releaseBuffer(bufferName);
+	bufferName  = filename;
+	holdsBuffer = true;
 }
 
-void AnnAudioSource::setLooping(bool looping) const
+void AnnAudioSource::setLooping(bool loop)
 {
-	alSourcei(source, AL_LOOPING, looping ? AL_TRUE : AL_FALSE);
+	looping = loop;
+	if(voice) engine->queueCommand({ AnnAudioEngine::AudioCommand::Type::Looping, voice, looping ? AL_TRUE : AL_FALSE });
 }
 
 void AnnAudioSource::setPositionRelToPlayer(bool rel)
 {
 	posRelToPlayer = rel;
 }
+
+void AnnAudioSource::setPriority(float newPriority)
+{
+	priority = std::max(0.0f, newPriority);
+}
+
+float AnnAudioSource::getPriority() const
+{
+	return priority;
+}
+
+bool AnnAudioSource::isPlaying() const
+{
+	return state == State::Playing;
+}
+
+bool AnnAudioSource::isVirtual() const
+{
+	return state == State::Playing && !voice;
+}
+
+AnnAudioStream::AnnAudioStream() :
+ source(0),
+ buffers {},
+ loopCurrent(false),
+ loopNext(false),
+ running(true),
+ playing(false)
+{
+	alGenSources(1, &source);
+	alGenBuffers(ALsizei(bufferCount), buffers.data());
+
+	//Music is not positioned in space
+	alSourcei(source, AL_SOURCE_RELATIVE, AL_TRUE);
+	alSource3f(source, AL_POSITION, 0, 0, 0);
+
+	streamThread = std::thread([this] { streamThreadLoop(); });
+}
+
+AnnAudioStream::~AnnAudioStream()
+{
+	shutdown();
+}
+
+void AnnAudioStream::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(streamMutex);
+		if(!running) return;
+		running = false;
+	}
+
+	wakeUp.notify_all();
+	if(streamThread.joinable()) streamThread.join();
+
+	alSourceStop(source);
+	clearQueue();
+	alDeleteSources(1, &source);
+	alDeleteBuffers(ALsizei(bufferCount), buffers.data());
+	current.reset();
+	next.reset();
+}
+
+std::unique_ptr<AnnAudioFileDecoder> AnnAudioStream::openDecoder(const std::string& filename)
+{
+	auto file = AnnGetAudioEngine()->getAudioFile(filename);
+	if(!file) return nullptr;
+
+	auto decoder = std::make_unique<AnnAudioFileDecoder>(file);
+	if(!decoder->isOpen() || decoder->getChannels() < 1 || decoder->getChannels() > 2)
+	{
+		AnnDebug() << "Cannot stream " << filename << " : " << decoder->getError();
+		return nullptr;
+	}
+
+	return decoder;
+}
+
+void AnnAudioStream::play(const std::string& filename, bool loop)
+{
+	//Reading the file happens here, decoding happens in the streaming thread
+	auto decoder = openDecoder(filename);
+
+	std::lock_guard<std::mutex> lock(streamMutex);
+	if(!running) return;
+
+	alSourceStop(source);
+	clearQueue();
+	next.reset();
+
+	current		= std::move(decoder);
+	loopCurrent = loop;
+	prime();
+}
+
+void AnnAudioStream::queueNext(const std::string& filename, bool loop)
+{
+	auto decoder = openDecoder(filename);
+
+	std::lock_guard<std::mutex> lock(streamMutex);
+	if(!running) return;
+
+	//Nothing to wait for, just play it
+	if(!playing)
+	{
+		current		= std::move(decoder);
+		loopCurrent = loop;
+		clearQueue();
+		prime();
+		return;
+	}
+
+	next	 = std::move(decoder);
+	loopNext = loop;
+}
+
+void AnnAudioStream::stop()
+{
+	std::lock_guard<std::mutex> lock(streamMutex);
+	if(!running) return;
+
+	alSourceStop(source);
+	clearQueue();
+	current.reset();
+	next.reset();
+	playing = false;
+}
+
+void AnnAudioStream::setVolume(float gain) const
+{
+	alSourcef(source, AL_GAIN, gain);
+}
+
+bool AnnAudioStream::isPlaying() const
+{
+	std::lock_guard<std::mutex> lock(streamMutex);
+	return playing;
+}
+
+void AnnAudioStream::clearQueue() const
+{
+	//On a stopped source, this unqueue everything
+	alSourcei(source, AL_BUFFER, 0);
+}
+
+void AnnAudioStream::prime()
+{
+	ALsizei queued { 0 };
+	for(auto buffer : buffers)
+	{
+		if(!fill(buffer)) break;
+		alSourceQueueBuffers(source, 1, &buffer);
+		++queued;
+	}
+
+	playing = queued > 0;
+	if(playing) alSourcePlay(source);
+	wakeUp.notify_all();
+}
+
+bool AnnAudioStream::fill(ALuint buffer)
+{
+	while(current)
+	{
+		const auto channels	= current->getChannels();
+		const auto sampleRate  = current->getSampleRate();
+		const auto frameCount = sf_count_t(sampleRate) * bufferMilliseconds / 1000;
+
+		chunk.resize(size_t(frameCount * channels));
+		const auto read = current->readFrames(chunk.data(), frameCount);
+		if(read > 0)
+		{
+			alBufferData(buffer,
+						 channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16,
+						 chunk.data(),
+						 ALsizei(read * channels * sizeof(int16_t)),
+						 ALsizei(sampleRate));
+			return true;
+		}
+
+		//End of the file. A queued file takes over, even from a looping one
+		if(next)
+		{
+			//A source can only queue buffers of the same format and sample-rate, a change waits for the queue to drain
+			if(next->getChannels() != channels || next->getSampleRate() != sampleRate)
+			{
+				current.reset();
+				break;
+			}
+
+			current		= std::move(next);
+			loopCurrent = loopNext;
+			continue;
+		}
+
+		//Loop it, if it has anything to read in the first place
+		if(loopCurrent && current->rewind() && current->getFrameCount() > 0)
+			continue;
+
+		current.reset();
+	}
+
+	return false;
+}
+
+void AnnAudioStream::streamThreadLoop()
+{
+	//Wake up a few times per buffer, so the queue never runs dry
+	const auto period = std::chrono::milliseconds(bufferMilliseconds / 4);
+
+	std::unique_lock<std::mutex> lock(streamMutex);
+	while(running)
+	{
+		wakeUp.wait_for(lock, period);
+		if(!running || !playing) continue;
+
+		//Refill the buffers that have been played
+		ALint processed { 0 };
+		alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+		while(processed-- > 0)
+		{
+			ALuint buffer;
+			alSourceUnqueueBuffers(source, 1, &buffer);
+			if(fill(buffer)) alSourceQueueBuffers(source, 1, &buffer);
+		}
+
+		ALint state { 0 }, queued { 0 };
+		alGetSourcei(source, AL_SOURCE_STATE, &state);
+		alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+		if(state == AL_PLAYING) continue;
+
+		//The source ran dry before we refilled it. Restart it
+		if(queued > 0)
+		{
+			alSourcePlay(source);
+			continue;
+		}
+
+		//Nothing queued anymore : start the next file if we were waiting for a format change, otherwise we are done
+		if(!current && next)
+		{
+			current		= std::move(next);
+			loopCurrent = loopNext;
+		}
+
+		if(current)
+			prime();
+		else
+			playing = false;
+	}
+}
+
+AnnAudioPreloadProgress::AnnAudioPreloadProgress(size_t fileCount) :
+ fileCount(fileCount),
+ loadedCount(0),
+ failedCount(0)
+{
+}
+
+size_t AnnAudioPreloadProgress::getFileCount() const
+{
+	return fileCount;
+}
+
+size_t AnnAudioPreloadProgress::getLoadedCount() const
+{
+	return loadedCount;
+}
+
+size_t AnnAudioPreloadProgress::getFailedCount() const
+{
+	return failedCount;
+}
+
+bool AnnAudioPreloadProgress::isFinished() const
+{
+	return loadedCount + failedCount >= fileCount;
+}
+
+float AnnAudioPreloadProgress::getProgress() const
+{
+	if(fileCount == 0) return 1;
+	return float(loadedCount + failedCount) / float(fileCount);
+}
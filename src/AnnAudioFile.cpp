@@ -5,6 +5,8 @@
 #include "AnnAudioFile.hpp"
 #include "AnnLogger.hpp"
 
+#include <OgreArchive.h>
+
 using namespace Annwvyn;
 using namespace Ogre;
 
@@ -16,17 +18,43 @@ void AnnAudioFile::readFromStream(DataStreamPtr& stream)
 	AnnDebug() << "Read " << read << " raw bytes into audio data vector";
 }
 
-//Ogre's loading from disk
-void AnnAudioFile::loadImpl()
+bool AnnAudioFile::mapFromFileSystem()
+{
+	//Compressed archives (Zip...) still need to be inflated into memory once
+	const auto archive = ResourceGroupManager::getSingleton()._getArchiveToResource(mName, mGroup);
+	if(!archive || archive->getType() != "FileSystem") return false;
+
+	if(!mapping.open(archive->getName() + "/" + mName)) return false;
+
+	AnnDebug() << "Mapped " << mapping.getSize() << " bytes of audio data from disk";
+	return true;
+}
+
+//Ogre's reading from disk. Also done by load() when the file isn't prepared
+void AnnAudioFile::prepareImpl()
 {
-	AnnDebug() << "AnnAudioFile::loadImpl for resource (" << mName << ", " << mGroup << ")";
+	AnnDebug() << "AnnAudioFile::prepareImpl for resource (" << mName << ", " << mGroup << ")";
+	if(mapFromFileSystem()) return;
+
 	auto stream = ResourceGroupManager::getSingleton().openResource(mName, mGroup, true, this);
 	readFromStream(stream);
 }
 
+void AnnAudioFile::unprepareImpl()
+{
+	unloadImpl();
+}
+
+void AnnAudioFile::loadImpl()
+{
+	//The data read by prepareImpl() is all there is
+}
+
 void AnnAudioFile::unloadImpl()
 {
 	data.clear();
+	data.shrink_to_fit();
+	mapping.close();
 }
 
 size_t AnnAudioFile::calculateSize() const
@@ -48,6 +76,7 @@ AnnAudioFile::~AnnAudioFile()
 
 const byte* AnnAudioFile::getData() const
 {
+	if(mapping.isOpen()) return mapping.getData();
 	return data.data();
 }
 
@@ -132,7 +161,7 @@ sf_count_t AnnAudioFile::sfVioRead(void* ptr, sf_count_t count, void* audioFileR
 	const auto bytesCopied = stop - start;
 
 	//Load bytes into output buffer
-	memcpy(ptr, reinterpret_cast<void*>(file->data.data() + start), bytesCopied);
+	memcpy(ptr, file->getData() + start, bytesCopied);
 
 	//advance cursor
 	file->sf_offset += bytesCopied;
@@ -184,5 +213,155 @@ void AnnAudioFile::clearSndFileVioStruct()
 
 size_t AnnAudioFile::getSize() const
 {
+	if(mapping.isOpen()) return mapping.getSize();
 	return data.size();
 }
+
+const AnnCookedAudioHeader* AnnAudioFile::getCookedHeader() const
+{
+	return AnnCookedAudioHeader::find(getData(), getSize());
+}
+
+SF_VIRTUAL_IO AnnAudioFileDecoder::vio {
+	&AnnAudioFileDecoder::vioGetFileLen,
+	&AnnAudioFileDecoder::vioSeek,
+	&AnnAudioFileDecoder::vioRead,
+	&AnnAudioFileDecoder::vioWrite,
+	&AnnAudioFileDecoder::vioTell
+};
+
+AnnAudioFileDecoder::AnnAudioFileDecoder(AnnAudioFilePtr audioFile) :
+ file(audioFile),
+ offset(0),
+ info {},
+ cooked(nullptr),
+ handle(nullptr)
+{
+	if(!file) return;
+
+	//Already 16bit PCM, nothing to decode
+	if((cooked = file->getCookedHeader()) != nullptr)
+	{
+		info.channels	= cooked->channels;
+		info.samplerate = int(cooked->sampleRate);
+		info.frames		= sf_count_t(cooked->frameCount);
+		return;
+	}
+
+	handle = sf_open_virtual(&vio, SFM_READ, &info, this);
+
+	//Float encoded files (OGG...) can go past 1.0, don't let them wrap around when converted to 16bit
+	if(handle) sf_command(handle, SFC_SET_CLIPPING, nullptr, SF_TRUE);
+}
+
+AnnAudioFileDecoder::~AnnAudioFileDecoder()
+{
+	if(handle) sf_close(handle);
+}
+
+bool AnnAudioFileDecoder::isOpen() const
+{
+	return handle != nullptr || cooked != nullptr;
+}
+
+int AnnAudioFileDecoder::getChannels() const
+{
+	return info.channels;
+}
+
+int AnnAudioFileDecoder::getSampleRate() const
+{
+	return info.samplerate;
+}
+
+sf_count_t AnnAudioFileDecoder::getFrameCount() const
+{
+	return info.frames;
+}
+
+sf_count_t AnnAudioFileDecoder::readFrames(int16_t* output, sf_count_t frameCount)
+{
+	if(cooked)
+	{
+		const auto read = std::min(frameCount, info.frames - offset);
+		memcpy(output, cooked->getSamples() + offset * info.channels, size_t(read * info.channels) * sizeof(int16_t));
+		offset += read;
+		return read;
+	}
+
+	if(!handle) return 0;
+	return sf_readf_short(handle, output, frameCount);
+}
+
+bool AnnAudioFileDecoder::rewind()
+{
+	if(cooked)
+	{
+		offset = 0;
+		return true;
+	}
+
+	if(!handle) return false;
+	return sf_seek(handle, 0, SEEK_SET) == 0;
+}
+
+std::string AnnAudioFileDecoder::getError() const
+{
+	if(cooked) return {};
+	return sf_strerror(handle);
+}
+
+const AnnAudioFilePtr& AnnAudioFileDecoder::getFile() const
+{
+	return file;
+}
+
+sf_count_t AnnAudioFileDecoder::vioGetFileLen(void* decoder)
+{
+	return static_cast<AnnAudioFileDecoder*>(decoder)->file->getSize();
+}
+
+sf_count_t AnnAudioFileDecoder::vioSeek(sf_count_t offset, int whence, void* decoder)
+{
+	auto self		= static_cast<AnnAudioFileDecoder*>(decoder);
+	const auto size = sf_count_t(self->file->getSize());
+
+	switch(whence)
+	{
+		case SEEK_CUR:
+			self->offset += offset;
+			break;
+		case SEEK_END:
+			self->offset = size + offset;
+			break;
+		case SEEK_SET:
+			self->offset = offset;
+			break;
+		default:
+			break;
+	}
+
+	self->offset = std::max<sf_count_t>(0, std::min(self->offset, size));
+	return self->offset;
+}
+
+sf_count_t AnnAudioFileDecoder::vioRead(void* ptr, sf_count_t count, void* decoder)
+{
+	auto self		= static_cast<AnnAudioFileDecoder*>(decoder);
+	const auto size = sf_count_t(self->file->getSize());
+	const auto read = std::max<sf_count_t>(0, std::min(count, size - self->offset));
+
+	memcpy(ptr, self->file->getData() + self->offset, size_t(read));
+	self->offset += read;
+	return read;
+}
+
+sf_count_t AnnAudioFileDecoder::vioWrite(const void*, sf_count_t, void*)
+{
+	return 0;
+}
+
+sf_count_t AnnAudioFileDecoder::vioTell(void* decoder)
+{
+	return static_cast<AnnAudioFileDecoder*>(decoder)->offset;
+}
@@ -0,0 +1,112 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <AnnCompiledLevel.hpp>
+
+#include "Annwvyn.h"
+
+using namespace Annwvyn;
+
+static_assert(int(AnnCompiledLevelObject::StaticShape) == staticShape && int(AnnCompiledLevelObject::SphereShape) == sphereShape,
+			  "Compiled level shapes are cast to phyShapeType");
+
+namespace
+{
+	AnnLightObject::LightTypes toLightType(uint8_t type)
+	{
+		switch(type)
+		{
+			case AnnCompiledLevelLight::Directional: return AnnLightObject::ANN_LIGHT_DIRECTIONAL;
+			case AnnCompiledLevelLight::Spotlight: return AnnLightObject::ANN_LIGHT_SPOTLIGHT;
+			default: return AnnLightObject::ANN_LIGHT_POINT;
+		}
+	}
+}
+
+AnnCompiledLevel::AnnCompiledLevel(std::string path, const bool preload) :
+ AnnDataLevel(),
+ header(nullptr)
+{
+	if(!file.open(path))
+		throw AnnInitializationError(ANN_ERR_INFILE, "Could not map compiled level file " + path);
+
+	//Everything is checked here, the rest of the class reads the file without further checks
+	header = AnnCompiledLevelHeader::find(file.getData(), file.getSize());
+	if(!header)
+		throw AnnInitializationError(ANN_ERR_INFILE, path + " is not a valid compiled level (version " + std::to_string(AnnCompiledLevelHeader::currentVersion) + ")");
+
+	name = getString(header->name);
+	AnnDebug() << "Compiled level " << name << " : " << header->objectCount << " objects, " << header->lightCount << " lights";
+
+	auto resourceManager = AnnGetResourceManager();
+	for(uint32_t i { 0 }; i < header->resourceCount; ++i)
+	{
+		const auto& resource = header->getResources()[i];
+		const auto group	 = getGroup(resource);
+		if(header->getString(resource.type) == "Zip")
+			resourceManager->addZipLocation(getString(resource.path), group);
+
+		addResourceGroup(group);
+		if(preload && group != resourceManager->getDefaultResourceGroupName())
+			resourceManager->loadGroup(group);
+	}
+}
+
+AnnCompiledLevel::~AnnCompiledLevel()
+{
+}
+
+std::string AnnCompiledLevel::getString(uint32_t index) const
+{
+	return std::string(header->getString(index));
+}
+
+std::string AnnCompiledLevel::getGroup(const AnnCompiledLevelResource& resource) const
+{
+	const auto group = header->getString(resource.group);
+	return group.empty() ? AnnResourceManager::getDefaultResourceGroupName() : std::string(group);
+}
+
+size_t AnnCompiledLevel::getObjectCount() const
+{
+	return header->objectCount;
+}
+
+AnnDataLevel::ObjectDescription AnnCompiledLevel::getObject(size_t index) const
+{
+	const auto& compiledObject = header->getObjects()[index];
+
+	ObjectDescription object {};
+	object.name				= getString(compiledObject.name);
+	object.mesh				= getString(compiledObject.mesh);
+	object.position			= AnnVect3(compiledObject.position);
+	object.orientation		= AnnQuaternion(compiledObject.orientation[3], compiledObject.orientation[0], compiledObject.orientation[1], compiledObject.orientation[2]);
+	object.scale			= AnnVect3(compiledObject.scale);
+	object.hasPhysics		= compiledObject.hasPhysics != 0;
+	object.mass				= compiledObject.mass;
+	object.shape			= phyShapeType(compiledObject.shape);
+	object.colideWithPlayer = compiledObject.playerCollide != 0;
+	for(uint32_t i { 0 }; i < compiledObject.scriptCount; ++i)
+		object.scripts.push_back(getString(header->getScripts()[compiledObject.firstScript + i]));
+
+	return object;
+}
+
+void AnnCompiledLevel::finishContent()
+{
+	for(uint32_t i { 0 }; i < header->lightCount; ++i)
+	{
+		const auto& compiledLight = header->getLights()[i];
+		auto light				  = AnnGetGameObjectManager()->createLightObject(getString(compiledLight.name));
+		light->setType(toLightType(compiledLight.type));
+		light->setPower(compiledLight.power);
+		if(compiledLight.hasPosition) light->setPosition(AnnVect3(compiledLight.position));
+		if(compiledLight.hasDirection) light->setDirection(AnnVect3(compiledLight.direction));
+		levelLighting.push_back(light);
+	}
+
+	auto player = AnnGetPlayer();
+	player->setPosition(AnnVect3(header->playerPosition));
+	player->setOrientation(AnnQuaternion(header->playerOrientation[3], header->playerOrientation[0], header->playerOrientation[1], header->playerOrientation[2]));
+	AnnDebug() << "Player position reset";
+}
@@ -561,6 +561,7 @@ bool AnnConsole::runSpecialInput(const std::string& input)
 		append("you can't create global variables from that console. You have to");
 		append("reference GameObject by their name for example");
 		append("You can display this help by typing \"help\"");
+		append("Type \"profile on\", then \"profile\" to see the slowest scripts");
 
 		return true;
 	}
@@ -592,6 +593,42 @@ bool AnnConsole::runSpecialInput(const std::string& input)
 		return true;
 	}
 
+	else if(input == "profile" || input.compare(0, 8, "profile ") == 0)
+	{
+		auto scriptManager = AnnGetScriptManager();
+		const auto option  = input.size() > 8 ? input.substr(8) : std::string {};
+
+		if(option == "on" || option == "off")
+		{
+			scriptManager->setProfilingEnabled(option == "on");
+			append(std::string("Script profiler ") + (option == "on" ? "enabled" : "disabled"));
+		}
+		else if(option == "reset")
+		{
+			scriptManager->resetProfile();
+			append("Script profiler reset");
+		}
+		else if(option == "dump")
+		{
+			AnnGetFileSystemManager()->createSaveDirectory();
+			const auto path = AnnGetFileSystemManager()->getPathForFileName("script_profile.csv");
+			append(scriptManager->dumpProfile(path) ? "Script profile written to " + path : "Cannot write " + path);
+		}
+		else if(option.empty())
+		{
+			bufferClear();
+			if(!scriptManager->isProfilingEnabled()) append("Script profiler is disabled, type \"profile on\"");
+			for(const auto& line : scriptManager->getProfileReport(CONSOLE_BUFFER - 1))
+				append(line);
+		}
+		else
+		{
+			append("Usage : profile [on|off|reset|dump]");
+		}
+
+		return true;
+	}
+
 	return false;
 }
 
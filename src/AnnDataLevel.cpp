@@ -0,0 +1,184 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include <AnnDataLevel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include "Annwvyn.h"
+
+using namespace Annwvyn;
+
+namespace
+{
+	//Wait for a worker, or only check if it's done. The work may be queued for the main thread
+	template <class Future>
+	bool isDone(const Future& future, bool wait)
+	{
+		if(wait) AnnGetTaskManager()->wait(future);
+		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+}
+
+AnnDataLevel::AnnDataLevel() :
+ constructLevel(),
+ loadedContent(0),
+ readyObjects(0)
+{
+}
+
+AnnDataLevel::~AnnDataLevel()
+{
+	discardPendingObjects();
+}
+
+void AnnDataLevel::discardPendingObjects()
+{
+	for(auto& pending : pendingObjects)
+	{
+		if(!pending.shape.valid()) continue;
+		try
+		{
+			AnnPhysicsEngine::_destroyShape(pending.shape.get());
+		}
+		catch(const std::exception&)
+		{
+		}
+	}
+	pendingObjects.clear();
+	readyObjects = 0;
+}
+
+void AnnDataLevel::addResourceGroup(const std::string& group)
+{
+	if(std::find(begin(resourceGroups), end(resourceGroups), group) == end(resourceGroups))
+		resourceGroups.push_back(group);
+}
+
+void AnnDataLevel::load()
+{
+	beginLoad();
+	while(step(true) != LoadProgress::Done)
+		;
+	finishLoad();
+}
+
+void AnnDataLevel::beginLoad()
+{
+	loadedContent = 0;
+	discardPendingObjects();
+
+	//Every mesh of the level is read and decoded by the workers in parallel, while the objects are created one by one
+	objectMeshes.clear();
+	for(size_t i { 0 }; i < getObjectCount(); ++i)
+	{
+		const auto mesh  = getObject(i).mesh;
+		auto preparation = meshPreparations.find(mesh);
+		if(preparation == end(meshPreparations))
+			preparation = meshPreparations.emplace(mesh, AnnGetGameObjectManager()->prepareMesh(mesh)).first;
+		objectMeshes.push_back(preparation->second);
+	}
+}
+
+AnnLevel::LoadProgress AnnDataLevel::loadStep()
+{
+	//The frame goes on while the workers are busy, the level manager calls again later
+	return step(false);
+}
+
+AnnLevel::LoadProgress AnnDataLevel::step(bool wait)
+{
+	if(loadedContent < getObjectCount())
+	{
+		//Only waits for the workers, errors are reported by createGameObject()
+		if(!isDone(objectMeshes[loadedContent], wait)) return LoadProgress::Waiting;
+		auto description = getObject(loadedContent++);
+
+		auto object = AnnGetGameObjectManager()->createGameObject(description.mesh, description.name);
+		if(!object) throw AnnNullGameObjectError();
+
+		//The previous level may still be visible and running. The object gets its body and its scripts in finishLoad()
+		object->setInvisible();
+		object->setPosition(description.position);
+		object->setOrientation(description.orientation);
+		object->setScale(description.scale);
+		levelContent.push_back(object);
+
+		PendingObject pending { object, false, description.mass, description.colideWithPlayer, {}, std::move(description.scripts) };
+		if(description.hasPhysics)
+		{
+			if(description.shape == error) throw AnnInvalidPhysicalShapeError(object->getName());
+			if((pending.hasBody = description.mass >= 0))
+				pending.shape = AnnGetPhysicsEngine()->_getGameObjectShapeAsync(object.get(), description.shape);
+		}
+		pendingObjects.push_back(std::move(pending));
+		return LoadProgress::Progress;
+	}
+
+	//Shapes are built in parallel while the objects are created
+	for(; readyObjects < pendingObjects.size(); ++readyObjects)
+	{
+		const auto& pending = pendingObjects[readyObjects];
+		if(pending.hasBody && !isDone(pending.shape, wait)) return LoadProgress::Waiting;
+	}
+
+	return LoadProgress::Done;
+}
+
+void AnnDataLevel::finishLoad()
+{
+	//Everything is added at once, when the previous level is gone
+	for(auto& pending : pendingObjects)
+	{
+		if(pending.hasBody)
+			pending.object->_setupPhysics(pending.mass, pending.shape.get(), pending.colideWithPlayer);
+
+		for(const auto& script : pending.scripts)
+			pending.object->attachScript(script);
+
+		pending.object->setVisible();
+	}
+	pendingObjects.clear();
+	readyObjects = 0;
+
+	finishContent();
+}
+
+void AnnDataLevel::abandonLoad()
+{
+	discardPendingObjects();
+	AnnLevel::abandonLoad();
+}
+
+void AnnDataLevel::preload()
+{
+	if(!preloads.empty()) return;
+
+	auto resourceManager = AnnGetResourceManager();
+	for(const auto& group : resourceGroups)
+		if(group != resourceManager->getDefaultResourceGroupName())
+			preloads.push_back(resourceManager->loadGroupAsync(group));
+
+	//Meshes can come from any group, the default one included
+	std::vector<std::string> meshes;
+	for(size_t i { 0 }; i < getObjectCount(); ++i)
+	{
+		auto mesh = getObject(i).mesh;
+		if(std::find(begin(meshes), end(meshes), mesh) != end(meshes)) continue;
+		preloads.push_back(AnnGetGameObjectManager()->preloadMesh(mesh));
+		meshes.push_back(std::move(mesh));
+	}
+
+	AnnDebug() << "Preloading " << resourceGroups.size() << " resource groups and " << meshes.size() << " meshes for level " << name;
+}
+
+bool AnnDataLevel::isPreloaded() const
+{
+	return std::all_of(begin(preloads), end(preloads), [](const std::shared_future<void>& preload) {
+		return preload.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	});
+}
+
+void AnnDataLevel::runLogic()
+{
+}
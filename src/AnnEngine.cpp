@@ -216,6 +216,7 @@ AnnEngine::AnnEngine(const char title[], const std::string& hmdCommand) :
  resetGuard(this),
  applicationQuitRequested(false),
  renderer(nullptr),
+ taskManager(nullptr),
  resourceManager(nullptr),
  sceneryManager(nullptr),
  filesystemManager(nullptr),
@@ -261,6 +262,7 @@ AnnEngine::AnnEngine(const char title[], const std::string& hmdCommand) :
 	writeToLog("Setup Annwvyn's subsystems");
 
 	// Subsystems are updated in their creation order :
+	// - work finished by background tasks is committed
 	// - level management is handeled
 	// - object management is handeled
 	// - physics is ticked (stuff move)
@@ -269,6 +271,7 @@ AnnEngine::AnnEngine(const char title[], const std::string& hmdCommand) :
 	// - other less important operation are done
 	// then the game can redraw
 
+	subsystems.push_back(taskManager = std::make_shared<AnnTaskManager>());
 	subsystems.push_back(levelManager = std::make_shared<AnnLevelManager>());
 	subsystems.push_back(gameObjectManager = std::make_shared<AnnGameObjectManager>());
 	subsystems.push_back(physicsEngine = std::make_shared<AnnPhysicsEngine>(getSceneManager()->getRootSceneNode(), player));
@@ -335,6 +338,7 @@ void AnnEngine::initPlayerStandingPhysics() const { physicsEngine->initPlayerSta
 void AnnEngine::initPlayerRoomscalePhysics() const { physicsEngine->initPlayerRoomscalePhysics(vrRendererPovGameplayPlacement); }
 AnnConsolePtr AnnEngine::getOnScreenConsole() const { return onScreenConsole; }
 AnnStringUtilityPtr AnnEngine::getStringUtility() const { return stringUtility; }
+AnnTaskManagerPtr AnnEngine::getTaskManager() const { return taskManager; }
 
 void AnnEngine::setConsoleGreen()
 {
@@ -438,7 +442,7 @@ AnnPose AnnEngine::getHmdPose() const
 AnnUserSubSystemPtr AnnEngine::registerUserSubSystem(AnnUserSubSystemPtr userSystem)
 {
 	for(const auto system : subsystems)
-		if(userSystem->name == system->name)
+		if(userSystem->nameID == system->nameID)
 		{
 			AnnDebug() << "A subsystem with the name "
 					   << userSystem->name
@@ -506,11 +510,19 @@ void AnnEngine::loadUserSubSystemFromPlugin(const std::string& pluginName, bool
 }
 
 AnnSubSystemPtr AnnEngine::getSubSystemByName(const std::string& name)
+{
+	//A name that was never interned can't be the name of a subsystem
+	const auto nameID = stringUtility->find(name);
+	if(nameID == AnnInvalidStringID) return nullptr;
+	return getSubSystemByName(nameID);
+}
+
+AnnSubSystemPtr AnnEngine::getSubSystemByName(AnnStringID nameID)
 {
 	auto result = std::find_if(std::begin(subsystems),
 							   std::end(subsystems),
-							   [&](AnnSubSystemPtr s) {
-								   return s->name == name;
+							   [&](const AnnSubSystemPtr& s) {
+								   return s->nameID == nameID;
 							   });
 
 	if(result == std::end(subsystems)) return nullptr;
@@ -143,6 +143,7 @@ void AnnEventManager::update()
 	processInput();
 	processTriggerEvents();
 	processTimers();
+	processResourceLoadEvents();
 	processUserSpaceEvents();
 }
 
@@ -348,6 +349,29 @@ void AnnEventManager::processCollisionEvents()
 	playerCollisionBuffer.clear();
 }
 
+void AnnEventManager::processResourceLoadEvents()
+{
+	for(const auto& resourceLoadEvent : resourceLoadEventBuffer)
+		for(const auto& weakListener : listeners)
+			if(auto listener = weakListener.lock())
+				listener->ResourceLoadEvent(resourceLoadEvent);
+
+	resourceLoadEventBuffer.clear();
+}
+
+void AnnEventManager::resourceLoadProgress(const std::string& group, size_t loaded, size_t total)
+{
+	//Only the last progress of a group in a frame is worth sending
+	for(auto& resourceLoadEvent : resourceLoadEventBuffer)
+		if(resourceLoadEvent.getGroup() == group)
+		{
+			resourceLoadEvent = { group, loaded, total };
+			return;
+		}
+
+	resourceLoadEventBuffer.emplace_back(group, loaded, total);
+}
+
 size_t AnnEventManager::getControllerCount() const
 {
 	return Joysticks.size();
@@ -463,6 +463,40 @@ AnnGameObject* AnnPlayerCollisionEvent::getObject() const
 	return col;
 }
 
+AnnResourceLoadEvent::AnnResourceLoadEvent(const std::string& group, size_t loaded, size_t total) :
+ AnnEvent(),
+ group { group },
+ loaded { loaded },
+ total { total }
+{
+	type = RESOURCE_LOADING;
+}
+
+const std::string& AnnResourceLoadEvent::getGroup() const
+{
+	return group;
+}
+
+size_t AnnResourceLoadEvent::getLoadedCount() const
+{
+	return loaded;
+}
+
+size_t AnnResourceLoadEvent::getTotalCount() const
+{
+	return total;
+}
+
+float AnnResourceLoadEvent::getProgress() const
+{
+	return total == 0 ? 1 : float(loaded) / float(total);
+}
+
+bool AnnResourceLoadEvent::isFinished() const
+{
+	return loaded >= total;
+}
+
 AnnTimerID AnnTimeEvent::getID() const
 {
 	return tID;
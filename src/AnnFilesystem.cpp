@@ -5,15 +5,228 @@
 #include "AnnLogger.hpp"
 #include "AnnGetter.hpp"
 
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace Annwvyn;
 using namespace std;
 
+namespace
+{
+	//Append the bytes of a value to a binary file content
+	template <typename T>
+	void put(string& content, const T& value)
+	{
+		content.append(reinterpret_cast<const char*>(&value), sizeof value);
+	}
+
+	//Read values from a binary file content, without going past the end
+	struct BinaryCursor
+	{
+		const string& content;
+		size_t position;
+
+		template <typename T>
+		bool get(T& value)
+		{
+			if(content.size() - position < sizeof value) return false;
+			memcpy(&value, content.data() + position, sizeof value);
+			position += sizeof value;
+			return true;
+		}
+
+		bool get(string& text, size_t length)
+		{
+			if(content.size() - position < length) return false;
+			text.assign(content, position, length);
+			position += length;
+			return true;
+		}
+	};
+
+	//Same text as the fixed notation the text format always used
+	string floatToText(float value)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof buffer, "%.*f", 2 + numeric_limits<float>::max_digits10, double(value));
+		return buffer;
+	}
+
+	//Forbidden characters in text "key=value" file
+	void strip(string& text)
+	{
+		for(auto achar : AnnFilesystemManager::charToStrip)
+			replace(begin(text), end(text), achar, '_');
+	}
+
+	//Types tags of the binary format. This is the index of the type in AnnSaveValue
+	enum : uint8_t { BinaryString,
+					 BinaryInt,
+					 BinaryFloat,
+					 BinaryVect3,
+					 BinaryQuaternion };
+
+	//Operations of journal records
+	enum : uint8_t { JournalSet,
+					 JournalClear };
+
+	//Append a key to a binary file content
+	void putKey(string& content, const string& key)
+	{
+		put(content, uint32_t(key.size()));
+		content += key;
+	}
+
+	//Append an entry (type, key, value) to a binary file content
+	void putEntry(string& content, const string& key, const AnnSaveValue& value)
+	{
+		put(content, uint8_t(value.index()));
+		putKey(content, key);
+
+		visit([&content](const auto& typedValue) {
+			using T = decay_t<decltype(typedValue)>;
+			if constexpr(is_same_v<T, string>)
+			{
+				put(content, uint32_t(typedValue.size()));
+				content += typedValue;
+			}
+			else if constexpr(is_same_v<T, AnnVect3>)
+			{
+				put(content, typedValue.x);
+				put(content, typedValue.y);
+				put(content, typedValue.z);
+			}
+			else if constexpr(is_same_v<T, AnnQuaternion>)
+			{
+				put(content, typedValue.w);
+				put(content, typedValue.x);
+				put(content, typedValue.y);
+				put(content, typedValue.z);
+			}
+			else
+			{
+				put(content, typedValue);
+			}
+		},
+			  value);
+	}
+
+	//Read a key from a binary file content
+	bool getKey(BinaryCursor& cursor, string& key)
+	{
+		uint32_t keyLength;
+		return cursor.get(keyLength) && cursor.get(key, keyLength);
+	}
+
+	//Read an entry (type, key, value) from a binary file content
+	bool getEntry(BinaryCursor& cursor, string& key, AnnSaveValue& value)
+	{
+		uint8_t type;
+		if(!cursor.get(type) || !getKey(cursor, key)) return false;
+
+		switch(type)
+		{
+			case BinaryString:
+			{
+				uint32_t length;
+				string text;
+				if(!cursor.get(length) || !cursor.get(text, length)) return false;
+				value = move(text);
+				return true;
+			}
+			case BinaryInt:
+			{
+				int32_t integer;
+				if(!cursor.get(integer)) return false;
+				value = int(integer);
+				return true;
+			}
+			case BinaryFloat:
+			{
+				float floating;
+				if(!cursor.get(floating)) return false;
+				value = floating;
+				return true;
+			}
+			case BinaryVect3:
+			{
+				AnnVect3 vector;
+				if(!cursor.get(vector.x) || !cursor.get(vector.y) || !cursor.get(vector.z)) return false;
+				value = vector;
+				return true;
+			}
+			case BinaryQuaternion:
+			{
+				AnnQuaternion quaternion;
+				if(!cursor.get(quaternion.w) || !cursor.get(quaternion.x) || !cursor.get(quaternion.y) || !cursor.get(quaternion.z)) return false;
+				value = quaternion;
+				return true;
+			}
+			default:
+				return false;
+		}
+	}
+
+	//FNV-1a, to know which snapshot a journal goes with
+	uint64_t hashContent(const string& content)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for(const auto c : content)
+		{
+			hash ^= uint8_t(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	//Journal of a save file
+	string journalPathFor(const string& path)
+	{
+		return path + ".journal";
+	}
+
+	//Read a whole file. Return false if it can't be opened
+	bool readWholeFile(const string& path, string& content)
+	{
+		ifstream file(path, ios::binary | ios::ate);
+		if(!file) return false;
+		content.assign(size_t(file.tellg()), '\0');
+		file.seekg(0);
+		file.read(&content[0], streamsize(content.size()));
+		return bool(file);
+	}
+}
+
 vector<char> AnnFilesystemManager::charToEscape;
 vector<char> AnnFilesystemManager::charToStrip;
 
-AnnFileWriter::AnnFileWriter()
+AnnFileWriter::AnnFileWriter() :
+ journalCompactionThreshold(64 * 1024),
+ coalesceDelay(250),
+ flushing(false),
+ running(true)
 {
 	AnnDebug() << "FileWriter instantiated";
+	writerThread = thread([this] { writerThreadLoop(); });
+}
+
+AnnFileWriter::~AnnFileWriter()
+{
+	//Nothing that was saved is lost
+	{
+		lock_guard<mutex> lock(writerMutex);
+		running  = false;
+		flushing = true;
+	}
+	writerCondition.notify_all();
+	writerThread.join();
 }
 
 void AnnFileWriter::write(shared_ptr<AnnSaveFileData> data)
@@ -21,21 +234,343 @@ void AnnFileWriter::write(shared_ptr<AnnSaveFileData> data)
 	//Create the resources needed for the write operation
 	auto fsmanager(AnnGetFileSystemManager());
 	auto path(fsmanager->getPathForFileName(data->fileName));
-	ofstream saveFile;
 
 	//Make sure the "user save" directory as been created on the user's personal folder
 	fsmanager->createSaveDirectory();
 
-	//Open the file, abort if the file isn't openable
-	saveFile.open(path);
-	if(!saveFile.is_open()) return;
-	//push as plain text all key and data in a "key=data\n" format
-	for(auto storedData : data->storedTextData)
-		saveFile << storedData.first
-				 << "="
-				 << storedData.second
-				 << endl;
+	//The journal doesn't go with the new file anymore
+	openJournals.erase(path);
+
+	//A queued snapshot is older than this one and would overwrite it later. Drop it, and don't share the temporary file with the thread
+	PendingWrite superseded;
+	auto hadPendingWrite { false };
+	{
+		unique_lock<mutex> lock(writerMutex);
+		if(auto query = pendingWrites.find(path); query != end(pendingWrites))
+		{
+			superseded = move(query->second);
+			pendingWrites.erase(query);
+			hadPendingWrite = true;
+		}
+		writerCondition.notify_all();
+		writerCondition.wait(lock, [&] { return writingFilename != data->fileName; });
+	}
+
+	const auto written = writeAtomically(path, serialize(*data));
+	if(written)
+	{
+		data->changed = false;
+		data->journalKeys.clear();
+	}
+
+	//Whoever waited for the dropped snapshot gets this write instead
+	if(hadPendingWrite) superseded.done.set_value(written);
+}
+
+bool AnnFileWriter::writeJournaled(shared_ptr<AnnSaveFileData> data)
+{
+	auto fsmanager(AnnGetFileSystemManager());
+	auto path(fsmanager->getPathForFileName(data->fileName));
+	fsmanager->createSaveDirectory();
+
+	//An older snapshot of this file may still be going to the disk
+	if(isWriting(data->fileName)) waitForPendingWrites();
+
+	const auto journalPath = journalPathFor(path);
+	if(auto journal = openJournals.find(path); journal != end(openJournals))
+	{
+		//Records : size, operation, key, and value if it's set
+		string records;
+		for(const auto& key : data->journalKeys)
+		{
+			string record;
+			if(auto value = data->find(key))
+			{
+				put(record, JournalSet);
+				putEntry(record, key, *value);
+			}
+			else
+			{
+				put(record, JournalClear);
+				putKey(record, key);
+			}
+
+			put(records, uint32_t(record.size()));
+			records += record;
+		}
+
+		if(journal->second + records.size() <= journalCompactionThreshold)
+		{
+			if(records.empty() || writeToDisk(journalPath, records, true))
+			{
+				journal->second += records.size();
+				data->journalKeys.clear();
+				data->changed = false;
+				return true;
+			}
+
+			AnnDebug() << "Could not append to " << journalPath << ", writing the whole file";
+		}
+	}
+
+	//Full snapshot, then a new journal that goes with it. A crash in between leaves a journal that doesn't match and is ignored
+	const auto content = serialize(*data);
+	string journal;
+	put(journal, journalMagic);
+	put(journal, journalVersion);
+	put(journal, uint16_t(0));
+	put(journal, hashContent(content));
+	put(journal, uint64_t(content.size()));
+
+	openJournals.erase(path);
+	if(!writeAtomically(path, content)) return false;
+	data->journalKeys.clear();
+	data->changed = false;
+
+	if(writeAtomically(journalPath, journal))
+		openJournals[path] = journal.size();
+	return true;
+}
+
+void AnnFileWriter::setJournalCompactionThreshold(size_t bytes)
+{
+	journalCompactionThreshold = bytes;
+}
+
+size_t AnnFileWriter::getJournalCompactionThreshold() const
+{
+	return journalCompactionThreshold;
+}
+
+shared_future<bool> AnnFileWriter::writeAsync(shared_ptr<AnnSaveFileData> data)
+{
+	auto fsmanager(AnnGetFileSystemManager());
+	auto path(fsmanager->getPathForFileName(data->fileName));
+	fsmanager->createSaveDirectory();
+
+	//The snapshot is the serialized file, the game can continue to modify the data
+	auto content  = serialize(*data);
 	data->changed = false;
+	data->journalKeys.clear();
+	openJournals.erase(path);
+
+	shared_future<bool> future;
+	{
+		lock_guard<mutex> lock(writerMutex);
+		auto query = pendingWrites.find(path);
+		if(query != end(pendingWrites))
+		{
+			//Not written yet, it will be written with this snapshot. Keep the time of the first request, or a file saved often would never be written
+			query->second.content = move(content);
+			return query->second.future;
+		}
+
+		auto& pending		= pendingWrites[path];
+		pending.filename	= data->fileName;
+		pending.content		= move(content);
+		pending.requestTime = chrono::steady_clock::now();
+		pending.future		= pending.done.get_future().share();
+		future				= pending.future;
+	}
+
+	writerCondition.notify_all();
+	return future;
+}
+
+void AnnFileWriter::writerThreadLoop()
+{
+	unique_lock<mutex> lock(writerMutex);
+	for(;;)
+	{
+		if(pendingWrites.empty())
+		{
+			flushing = false;
+			writerCondition.notify_all();
+			if(!running) return;
+			writerCondition.wait(lock);
+			continue;
+		}
+
+		//Take the oldest request, once its coalescing delay is over
+		auto next = min_element(begin(pendingWrites), end(pendingWrites), [](const auto& a, const auto& b) {
+			return a.second.requestTime < b.second.requestTime;
+		});
+		const auto writeTime = next->second.requestTime + coalesceDelay;
+		if(!flushing && chrono::steady_clock::now() < writeTime)
+		{
+			writerCondition.wait_until(lock, writeTime);
+			continue;
+		}
+
+		const auto path = next->first;
+		auto pending	= move(next->second);
+		pendingWrites.erase(next);
+		writingFilename = pending.filename;
+
+		lock.unlock();
+		const auto written = writeAtomically(path, pending.content);
+		if(!written) AnnDebug(Log::Important) << "Could not write save file " << path;
+		pending.done.set_value(written);
+		lock.lock();
+
+		writingFilename.clear();
+		writerCondition.notify_all();
+	}
+}
+
+bool AnnFileWriter::isWriting(const string& filename) const
+{
+	lock_guard<mutex> lock(writerMutex);
+	if(writingFilename == filename) return true;
+	return any_of(begin(pendingWrites), end(pendingWrites), [&](const auto& pending) { return pending.second.filename == filename; });
+}
+
+bool AnnFileWriter::hasPendingWrites() const
+{
+	lock_guard<mutex> lock(writerMutex);
+	return !pendingWrites.empty() || !writingFilename.empty();
+}
+
+void AnnFileWriter::waitForPendingWrites()
+{
+	unique_lock<mutex> lock(writerMutex);
+	flushing = true;
+	writerCondition.notify_all();
+	writerCondition.wait(lock, [this] { return pendingWrites.empty() && writingFilename.empty(); });
+}
+
+void AnnFileWriter::setCoalesceDelay(chrono::milliseconds delay)
+{
+	{
+		lock_guard<mutex> lock(writerMutex);
+		coalesceDelay = delay;
+	}
+	writerCondition.notify_all();
+}
+
+chrono::milliseconds AnnFileWriter::getCoalesceDelay() const
+{
+	lock_guard<mutex> lock(writerMutex);
+	return coalesceDelay;
+}
+
+string AnnFileWriter::serialize(const AnnSaveFileData& data)
+{
+	return AnnGetFileSystemManager()->getSaveFileFormat() == AnnSaveFileFormat::Binary ? toBinary(data) : toText(data);
+}
+
+bool AnnFileWriter::writeToDisk(const string& path, const string& content, bool append)
+{
+#ifdef WIN32
+	const auto file = CreateFileA(path.c_str(), append ? FILE_APPEND_DATA : GENERIC_WRITE, 0, nullptr, append ? OPEN_EXISTING : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	DWORD written = 0;
+	const auto ok = WriteFile(file, content.data(), DWORD(content.size()), &written, nullptr)
+		&& written == content.size()
+		&& FlushFileBuffers(file);
+	CloseHandle(file);
+	return ok;
+#endif
+#ifdef __linux__
+	const auto file = open(path.c_str(), O_WRONLY | (append ? O_APPEND : O_CREAT | O_TRUNC), S_IRUSR | S_IWUSR);
+	if(file < 0) return false;
+
+	auto data	  = content.data();
+	auto remaining = content.size();
+	while(remaining > 0)
+	{
+		const auto written = ::write(file, data, remaining);
+		if(written < 0)
+		{
+			if(errno == EINTR) continue;
+			break;
+		}
+		data += written;
+		remaining -= size_t(written);
+	}
+
+	const auto ok = remaining == 0 && fsync(file) == 0;
+	close(file);
+	return ok;
+#endif
+}
+
+bool AnnFileWriter::writeAtomically(const string& path, const string& content)
+{
+	//A crash while writing only leaves a temporary file, the previous save is intact until the rename
+	const auto temporaryPath = path + ".tmp";
+	const auto written		 = writeToDisk(temporaryPath, content, false);
+
+#ifdef WIN32
+	if(!written || !MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		DeleteFileA(temporaryPath.c_str());
+		return false;
+	}
+#endif
+#ifdef __linux__
+	if(!written || rename(temporaryPath.c_str(), path.c_str()) != 0)
+	{
+		unlink(temporaryPath.c_str());
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+string AnnFileWriter::toBinary(const AnnSaveFileData& data)
+{
+	string content;
+	content.reserve(12 + 32 * data.storedData.size());
+
+	//Header
+	put(content, binaryMagic);
+	put(content, binaryVersion);
+	put(content, uint16_t(0));
+	put(content, uint32_t(data.storedData.size()));
+
+	//Entries : type, key, value
+	for(const auto& [key, value] : data.storedData)
+		putEntry(content, key, value);
+
+	return content;
+}
+
+string AnnFileWriter::toText(const AnnSaveFileData& data)
+{
+	//push as plain text all key and data in a "key=data\n" format
+	string content;
+	const auto line = [&content](const string& key, const string& value) {
+		content += key;
+		content += '=';
+		content += value;
+		content += '\n';
+	};
+
+	for(const auto& [key, value] : data.storedData)
+	{
+		if(auto vector = get_if<AnnVect3>(&value))
+		{
+			line(key + ".x", floatToText(vector->x));
+			line(key + ".y", floatToText(vector->y));
+			line(key + ".z", floatToText(vector->z));
+		}
+		else if(auto quaternion = get_if<AnnQuaternion>(&value))
+		{
+			line(key + ".w", floatToText(quaternion->w));
+			line(key + ".x", floatToText(quaternion->x));
+			line(key + ".y", floatToText(quaternion->y));
+			line(key + ".z", floatToText(quaternion->z));
+		}
+		else
+		{
+			line(key, AnnSaveFileData::toText(value));
+		}
+	}
+
+	return content;
 }
 
 AnnFileReader::AnnFileReader()
@@ -50,12 +585,10 @@ AnnSaveFileDataPtr AnnFileReader::read(string fileName) const
 	//Create the resource needed to the read operation
 	auto fsmanager(AnnGetFileSystemManager());
 
-	//Open the file
-	ifstream ifile;
+	//Read the whole file at once
 	auto fullPath = fsmanager->getPathForFileName(fileName);
-	ifile.open(fullPath);
-
-	if(!ifile)
+	string content;
+	if(!readWholeFile(fullPath, content))
 	{
 		AnnDebug() << "file " << fullPath << " doesn't exist or is not openable.";
 		return nullptr;
@@ -63,36 +596,128 @@ AnnSaveFileDataPtr AnnFileReader::read(string fileName) const
 
 	auto fileData(fsmanager->crateSaveFileDataObject(fileName));
 	if(!fileData) return nullptr;
-	string buffer, key, value;
 
 	//make sure the dataObject don't contain old content
-	fileData->storedTextData.clear();
+	fileData->storedData.clear();
 
-	//While we've not reach the end of the file
-	while(!ifile.eof())
+	uint32_t magic = 0;
+	if(content.size() >= sizeof magic) memcpy(&magic, content.data(), sizeof magic);
+
+	if(magic == AnnFileWriter::binaryMagic)
 	{
-		//Read a line
-		getline(ifile, buffer);
-		//Don't try to extract data from empty lines on the file
-		if(buffer.empty()) continue;
+		if(!fromBinary(content, *fileData))
+		{
+			AnnDebug(Log::Important) << "Save file " << fullPath << " is corrupted or from a newer version";
+			fsmanager->releaseSaveFileDataObject(fileData);
+			return nullptr;
+		}
+	}
+	else
+	{
+		fromText(content, *fileData);
+	}
+
+	//Changes saved after this snapshot
+	replayJournal(fullPath, content, *fileData);
+
+	fileData->changed = false;
+	fileData->journalKeys.clear();
+	return fileData;
+}
 
-		//Create a string stream on the buffer
-		stringstream readStream(buffer);
+void AnnFileReader::replayJournal(const string& path, const string& snapshot, AnnSaveFileData& data)
+{
+	string journal;
+	if(!readWholeFile(journalPathFor(path), journal)) return;
 
-		//Getline permit you to specify the "end-line" character. We use this to split the sting at the '=' in the file
-		getline(readStream, key, '=');
-		getline(readStream, value);
+	BinaryCursor cursor { journal, 0 };
+	uint32_t magic;
+	uint16_t version, reserved;
+	uint64_t snapshotHash, snapshotSize;
+	if(!cursor.get(magic) || !cursor.get(version) || !cursor.get(reserved) || !cursor.get(snapshotHash) || !cursor.get(snapshotSize)) return;
+	if(magic != AnnFileWriter::journalMagic || version > AnnFileWriter::journalVersion) return;
 
-		//Store on the file data object the given key
-		fileData->storedTextData[key] = value;
+	//Left by a crash during a full write
+	if(snapshotSize != snapshot.size() || snapshotHash != hashContent(snapshot))
+	{
+		AnnDebug() << "Ignoring journal of " << path << ", it was written for another version of the file";
+		return;
 	}
 
-	fileData->changed = false;
-	return fileData;
+	size_t replayed = 0;
+	string key;
+	AnnSaveValue value;
+	uint32_t recordSize;
+	while(cursor.get(recordSize))
+	{
+		//A crash while appending leaves a truncated record at the end
+		string record;
+		if(!cursor.get(record, recordSize)) break;
+
+		BinaryCursor recordCursor { record, 0 };
+		uint8_t operation;
+		if(!recordCursor.get(operation)) break;
+
+		if(operation == JournalSet && getEntry(recordCursor, key, value))
+			data.storedData[key] = move(value);
+		else if(operation == JournalClear && getKey(recordCursor, key))
+			data.storedData.erase(key);
+		else
+			break;
+		++replayed;
+	}
+
+	AnnDebug() << "Replayed " << replayed << " journal records on " << path;
+}
+
+bool AnnFileReader::fromBinary(const string& content, AnnSaveFileData& data)
+{
+	BinaryCursor cursor { content, 0 };
+
+	uint32_t magic, count;
+	uint16_t version, reserved;
+	if(!cursor.get(magic) || !cursor.get(version) || !cursor.get(reserved) || !cursor.get(count)) return false;
+	if(magic != AnnFileWriter::binaryMagic || version > AnnFileWriter::binaryVersion) return false;
+
+	string key;
+	AnnSaveValue value;
+	for(uint32_t i { 0 }; i < count; ++i)
+	{
+		if(!getEntry(cursor, key, value)) return false;
+		data.storedData[key] = move(value);
+	}
+
+	return true;
+}
+
+void AnnFileReader::fromText(const string& content, AnnSaveFileData& data)
+{
+	size_t start = 0;
+	while(start < content.size())
+	{
+		//Read a line
+		auto end = content.find('\n', start);
+		if(end == string::npos) end = content.size();
+		auto length = end - start;
+		if(length > 0 && content[start + length - 1] == '\r') --length;
+
+		//Don't try to extract data from empty lines on the file. The key ends at the first '='
+		if(length > 0)
+		{
+			const auto separator = content.find('=', start);
+			if(separator < start + length)
+				data.storedData[content.substr(start, separator - start)] = content.substr(separator + 1, start + length - separator - 1);
+			else
+				data.storedData[content.substr(start, length)] = string {};
+		}
+
+		start = end + 1;
+	}
 }
 
 AnnFilesystemManager::AnnFilesystemManager(string title) :
  AnnSubSystem("FilesystemManager"),
+ saveFileFormat(AnnSaveFileFormat::Binary),
  fileWriter(nullptr),
  fileReader(nullptr)
 {
@@ -210,6 +835,16 @@ AnnFileWriterPtr AnnFilesystemManager::getFileWriter() const
 	return fileWriter;
 }
 
+void AnnFilesystemManager::setSaveFileFormat(AnnSaveFileFormat format)
+{
+	saveFileFormat = format;
+}
+
+AnnSaveFileFormat AnnFilesystemManager::getSaveFileFormat() const
+{
+	return saveFileFormat;
+}
+
 AnnSaveFileData::AnnSaveFileData(string name) :
  fileName(name),
  changed(false)
@@ -227,54 +862,165 @@ string AnnSaveFileData::getFilename() const
 	return fileName;
 }
 
-string AnnSaveFileData::getValue(string key)
+const AnnSaveValue* AnnSaveFileData::find(const string& key) const
+{
+	const auto query = storedData.find(key);
+	if(query != end(storedData)) return &query->second;
+	return nullptr;
+}
+
+bool AnnSaveFileData::toFloat(const AnnSaveValue& value, float& output)
+{
+	if(auto floating = get_if<float>(&value))
+		output = *floating;
+	else if(auto integer = get_if<int>(&value))
+		output = float(*integer);
+	else if(auto text = get_if<string>(&value))
+	{
+		char* parsedEnd;
+		output = strtof(text->c_str(), &parsedEnd);
+		return parsedEnd != text->c_str();
+	}
+	else
+		return false;
+	return true;
+}
+
+string AnnSaveFileData::toText(const AnnSaveValue& value)
+{
+	if(auto text = get_if<string>(&value)) return *text;
+	if(auto integer = get_if<int>(&value)) return to_string(*integer);
+	if(auto floating = get_if<float>(&value)) return floatToText(*floating);
+	return {};
+}
+
+string AnnSaveFileData::getValue(string key) const
 {
 	//if key exist:
-	if(storedTextData.find(key) != end(storedTextData))
-		return storedTextData[key];
+	if(auto value = find(key)) return toText(*value);
+
+	//Component of a vector or a quaternion
+	if(key.size() > 2 && key[key.size() - 2] == '.')
+		if(auto value = find(key.substr(0, key.size() - 2)))
+		{
+			const auto component = key.back();
+			if(auto vector = get_if<AnnVect3>(value))
+			{
+				if(component == 'x') return floatToText(vector->x);
+				if(component == 'y') return floatToText(vector->y);
+				if(component == 'z') return floatToText(vector->z);
+			}
+			else if(auto quaternion = get_if<AnnQuaternion>(value))
+			{
+				if(component == 'w') return floatToText(quaternion->w);
+				if(component == 'x') return floatToText(quaternion->x);
+				if(component == 'y') return floatToText(quaternion->y);
+				if(component == 'z') return floatToText(quaternion->z);
+			}
+		}
+
 	//else:
 	return "";
 }
 
-void AnnSaveFileData::setValue(string key, string value)
+bool AnnSaveFileData::hasValue(const string& key) const
 {
-	for(auto achar : AnnFilesystemManager::charToStrip)
+	return find(key) || !getValue(key).empty();
+}
+
+int AnnSaveFileData::getInt(const string& key, int fallback) const
+{
+	const auto value = find(key);
+	if(!value) return fallback;
+	if(auto integer = get_if<int>(value)) return *integer;
+	if(auto text = get_if<string>(value))
 	{
-		replace(begin(key), end(key), achar, '_');
-		replace(begin(value), end(value), achar, '_');
+		char* parsedEnd;
+		const auto integer = strtol(text->c_str(), &parsedEnd, 10);
+		return parsedEnd != text->c_str() ? int(integer) : fallback;
 	}
-	storedTextData[key] = value;
-	changed				= true;
+
+	float floating;
+	return toFloat(*value, floating) ? int(floating) : fallback;
+}
+
+float AnnSaveFileData::getFloat(const string& key, float fallback) const
+{
+	const auto value = find(key);
+	float floating;
+	return value && toFloat(*value, floating) ? floating : fallback;
+}
+
+AnnVect3 AnnSaveFileData::getVect3(const string& key) const
+{
+	if(auto value = find(key))
+		if(auto vector = get_if<AnnVect3>(value)) return *vector;
+
+	//Text files have one key per component
+	AnnVect3 vector;
+	const AnnSaveValue *x, *y, *z;
+	if(!(x = find(key + ".x")) || !toFloat(*x, vector.x)) return AnnVect3(false);
+	if(!(y = find(key + ".y")) || !toFloat(*y, vector.y)) return AnnVect3(false);
+	if(!(z = find(key + ".z")) || !toFloat(*z, vector.z)) return AnnVect3(false);
+	return vector;
+}
+
+AnnQuaternion AnnSaveFileData::getQuaternion(const string& key) const
+{
+	if(auto value = find(key))
+		if(auto quaternion = get_if<AnnQuaternion>(value)) return *quaternion;
+
+	//Text files have one key per component
+	AnnQuaternion quaternion;
+	const AnnSaveValue *w, *x, *y, *z;
+	if(!(w = find(key + ".w")) || !toFloat(*w, quaternion.w)) return AnnQuaternion(false);
+	if(!(x = find(key + ".x")) || !toFloat(*x, quaternion.x)) return AnnQuaternion(false);
+	if(!(y = find(key + ".y")) || !toFloat(*y, quaternion.y)) return AnnQuaternion(false);
+	if(!(z = find(key + ".z")) || !toFloat(*z, quaternion.z)) return AnnQuaternion(false);
+	return quaternion;
+}
+
+void AnnSaveFileData::setValue(string key, string value)
+{
+	strip(key);
+	strip(value);
+	journalKeys.insert(key);
+	storedData[key] = move(value);
+	changed			= true;
 }
 
 void AnnSaveFileData::setValue(string key, int value)
 {
-	stringstream sstream;
-	sstream << value;
-	setValue(key, sstream.str());
+	strip(key);
+	journalKeys.insert(key);
+	storedData[key] = value;
+	changed			= true;
 }
 
 void AnnSaveFileData::setValue(string key, float value)
 {
-	stringstream sstream;
-	sstream.precision(2 + numeric_limits<float>::max_digits10);
-	sstream << fixed << value;
-	setValue(key, sstream.str());
+	strip(key);
+	journalKeys.insert(key);
+	storedData[key] = value;
+	changed			= true;
 }
 
 void AnnSaveFileData::setValue(string key, AnnVect3 vector)
 {
-	setValue(key + ".x", vector.x);
-	setValue(key + ".y", vector.y);
-	setValue(key + ".z", vector.z);
+	strip(key);
+	clearVectorValue(key);
+	journalKeys.insert(key);
+	storedData[key] = vector;
+	changed			= true;
 }
 
 void AnnSaveFileData::setValue(string key, AnnQuaternion quaternion)
 {
-	setValue(key + ".x", quaternion.x);
-	setValue(key + ".y", quaternion.y);
-	setValue(key + ".z", quaternion.z);
-	setValue(key + ".w", quaternion.w);
+	strip(key);
+	clearQuaternionValue(key);
+	journalKeys.insert(key);
+	storedData[key] = quaternion;
+	changed			= true;
 }
 
 void AnnSaveFileData::setValue(string key, const char* value)
@@ -284,12 +1030,15 @@ void AnnSaveFileData::setValue(string key, const char* value)
 
 void AnnSaveFileData::clearValue(string key)
 {
-	storedTextData.erase(key);
+	//Only remember keys that existed, the journal doesn't need to clear anything else
+	if(storedData.erase(key) == 0) return;
+	journalKeys.insert(key);
 	changed = true;
 }
 
 void AnnSaveFileData::clearVectorValue(string key)
 {
+	clearValue(key);
 	clearValue(key + ".x");
 	clearValue(key + ".y");
 	clearValue(key + ".z");
@@ -329,32 +1078,12 @@ int AnnSaveDataInterpretor::keyStringToInt(string key) const
 
 AnnVect3 AnnSaveDataInterpretor::keyStringToVect3(string key) const
 {
-	//Get text data from the dataObject return an invalid vector if the keyvalue wanted is not found
-	string x, y, z;
-	if((x = dataObject->getValue(key + ".x")).empty()) return AnnVect3(false);
-	if((y = dataObject->getValue(key + ".y")).empty()) return AnnVect3(false);
-	if((z = dataObject->getValue(key + ".z")).empty()) return AnnVect3(false);
-
-	//Convert the text data to floats and send them to the AnnVect3 constructor and return the object
-	return AnnVect3(
-		stringToFloat(x),
-		stringToFloat(y),
-		stringToFloat(z));
+	//Return an invalid vector if the key is not found
+	return dataObject->getVect3(key);
 }
 
 AnnQuaternion AnnSaveDataInterpretor::keyStringToQuaternion(string key) const
 {
-	//Get text data from the dataObject return an invalid quaternion if the keyvalue wanted is not found
-	string x, y, z, w;
-	if((x = dataObject->getValue(key + ".x")).empty()) return AnnQuaternion(false);
-	if((y = dataObject->getValue(key + ".y")).empty()) return AnnQuaternion(false);
-	if((z = dataObject->getValue(key + ".z")).empty()) return AnnQuaternion(false);
-	if((w = dataObject->getValue(key + ".w")).empty()) return AnnQuaternion(false);
-
-	//Convert the text data to floats and send them to the AnnQuaternion constructor and return the object
-	return AnnQuaternion(
-		stringToFloat(w),
-		stringToFloat(x),
-		stringToFloat(y),
-		stringToFloat(z));
+	//Return an invalid quaternion if the key is not found
+	return dataObject->getQuaternion(key);
 }
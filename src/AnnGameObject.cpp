@@ -16,6 +16,8 @@ AnnGameObject::AnnGameObject() :
  rigidBody(nullptr),
  bodyMass(0),
  audioSource(nullptr),
+ nameID(AnnInvalidStringID),
+ updateDeltaTime(0),
  state(nullptr)
 {
 }
@@ -33,12 +35,7 @@ AnnGameObject::~AnnGameObject()
 		AnnGetPhysicsEngine()->removeRigidBody(rigidBody);
 
 	if(rigidBody) delete rigidBody;
-	if(collisionShape)
-	{
-		if(collisionShape->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE)
-			delete static_cast<btBvhTriangleMeshShape*>(collisionShape)->getMeshInterface();
-		delete collisionShape;
-	}
+	AnnPhysicsEngine::_destroyShape(collisionShape);
 	if(state) delete state;
 
 	//Prevent dereferencing null pointer here. Parent can be something other than root scene node now.
@@ -210,11 +207,25 @@ void AnnGameObject::setupPhysics(float mass, phyShapeType type, bool colideWithP
 	if(checkForBodyInChild()) throw AnnPhysicsSetupChildError(this);
 	if(mass < 0) return;
 
+	//Get the collision shape from the physics engine
+	_setupPhysics(mass, AnnGetPhysicsEngine()->_getGameObjectShape(this, type), colideWithPlayer);
+}
+
+void AnnGameObject::_setupPhysics(float mass, btCollisionShape* shape, bool colideWithPlayer)
+{
+	//Same sanity checks as setupPhysics(). Nobody else owns the shape if they fail
+	const auto parentHasBody = checkForBodyInParent();
+	if(parentHasBody || checkForBodyInChild())
+	{
+		AnnPhysicsEngine::_destroyShape(shape);
+		if(parentHasBody) throw AnnPhysicsSetupParentError(this);
+		throw AnnPhysicsSetupChildError(this);
+	}
+
 	//Easy access to physics engine
 	auto physicsEngine = AnnGetPhysicsEngine();
 
-	//Get the collision shape from the physics engine
-	collisionShape = physicsEngine->_getGameObjectShape(this, type);
+	collisionShape = shape;
 
 	//Apply local scaling
 	AnnVect3 scale = getNode()->getScale();
@@ -333,6 +344,16 @@ std::string AnnGameObject::getName() const
 	return name;
 }
 
+AnnStringID AnnGameObject::getNameID() const
+{
+	return nameID;
+}
+
+double AnnGameObject::getUpdateDeltaTime() const
+{
+	return updateDeltaTime;
+}
+
 void AnnGameObject::attachScript(const std::string& scriptName)
 {
 	auto script = AnnGetScriptManager()->getBehaviorScript(scriptName, this);
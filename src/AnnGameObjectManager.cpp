@@ -10,10 +10,56 @@
 #include "AnnGetter.hpp"
 #include "AnnException.hpp"
 
+#include <OgreSphere.h>
+
+#include <unordered_set>
+
 using namespace Annwvyn;
 
+namespace
+{
+	//Unregister every object of the list with a single pass over the manager's container
+	template <class T>
+	void removeAll(std::vector<std::shared_ptr<T>>& container, std::unordered_map<AnnStringID, std::shared_ptr<T>>& identified, const std::vector<std::shared_ptr<T>>& objects)
+	{
+		std::unordered_set<const T*> removed;
+		removed.reserve(objects.size());
+		for(const auto& object : objects)
+		{
+			if(!object) throw AnnNullGameObjectError();
+			removed.insert(object.get());
+			identified.erase(object->getNameID());
+		}
+
+		container.erase(
+			std::remove_if(std::begin(container), std::end(container), [&](const std::shared_ptr<T>& object) { return removed.count(object.get()) > 0; }),
+			std::end(container));
+	}
+
+	//Get the extension of a file name, in lower case
+	std::string getLowerCaseExtension(const std::string& fileName)
+	{
+		auto ext = fileName.substr(fileName.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return char(::tolower(int(c))); });
+		return ext;
+	}
+
+	//Return true if the file is an Ogre v1 mesh, that can be read on a worker and converted to v2
+	bool isV1Mesh(const std::string& meshName)
+	{
+		return getLowerCaseExtension(meshName) == "mesh";
+	}
+}
+
 AnnGameObjectManager::AnnGameObjectManager() :
- AnnSubSystem("GameObjectManager"), halfPos(true), halfTexCoord(true), qTan(true)
+ AnnSubSystem("GameObjectManager"),
+ halfPos(true),
+ halfTexCoord(true),
+ qTan(true),
+ updateLodEnabled(false),
+ updateLodTiers { { 10, 1, 1, 1 }, { 40, 2, 2, 1 }, { 100, 4, 6, 3 }, { 300, 8, 15, 6 } },
+ updateLodInvisiblePenalty(1),
+ frameCounter(0)
 {
 	//There will only be one manager, set the id to 0
 	autoID = 0;
@@ -26,16 +72,76 @@ AnnGameObjectManager::AnnGameObjectManager() :
 
 void AnnGameObjectManager::update()
 {
+	const auto frameTime = AnnGetEngine()->getFrameTime();
+	++frameCounter;
+
 	//Run animations and update OpenAL sources position
+	if(!updateLodEnabled)
+	{
+		for(auto gameObject : Objects)
+		{
+			gameObject->updateDeltaTime = frameTime;
+			gameObject->addAnimationTime(frameTime);
+			gameObject->updateOpenAlPos();
+			gameObject->update();
+			gameObject->callUpdateOnScripts();
+		}
+		return;
+	}
+
+	//Same, but far away or out of view objects are updated less often, with the time they missed
+	const AnnVect3 headPosition { AnnGetVRRenderer()->trackedHeadPose.position };
 	for(auto gameObject : Objects)
 	{
-		gameObject->addAnimationTime(AnnGetEngine()->getFrameTime());
-		gameObject->updateOpenAlPos();
-		gameObject->update();
-		gameObject->callUpdateOnScripts();
+		const auto& tier = getUpdateLodTier(*gameObject, headPosition);
+		auto& lod		 = gameObject->updateLod;
+		lod.animationTime += frameTime;
+		lod.scriptTime += frameTime;
+
+		if(isUpdateLodFrame(tier.animationInterval, *gameObject))
+		{
+			gameObject->addAnimationTime(lod.animationTime);
+			lod.animationTime = 0;
+		}
+
+		if(isUpdateLodFrame(tier.soundInterval, *gameObject))
+			gameObject->updateOpenAlPos();
+
+		if(isUpdateLodFrame(tier.scriptInterval, *gameObject))
+		{
+			gameObject->updateDeltaTime = lod.scriptTime;
+			lod.scriptTime				= 0;
+			gameObject->update();
+			gameObject->callUpdateOnScripts();
+		}
 	}
 }
 
+const AnnGameObjectManager::UpdateLodTier& AnnGameObjectManager::getUpdateLodTier(const AnnGameObject& object, const AnnVect3& headPosition) const
+{
+	const auto squaredDistance = headPosition.squaredDistance(object.getWorldPosition());
+	const auto tier			   = std::find_if(std::begin(updateLodTiers), std::end(updateLodTiers), [&](const UpdateLodTier& t) {
+		return squaredDistance < t.maxDistance * t.maxDistance;
+	});
+	auto index = size_t(std::distance(std::begin(updateLodTiers), tier));
+
+	//Things that were not seen in the last frame can wait a bit more
+	if(const auto item = object.getItem(); item && updateLodInvisiblePenalty > 0)
+	{
+		const auto aabb = item->getWorldAabb();
+		if(!AnnGetVRRenderer()->isInViewFrustum(Ogre::Sphere(aabb.mCenter, aabb.getRadius())))
+			index += updateLodInvisiblePenalty;
+	}
+
+	return updateLodTiers[std::min(index, updateLodTiers.size() - 1)];
+}
+
+bool AnnGameObjectManager::isUpdateLodFrame(unsigned interval, const AnnGameObject& object) const
+{
+	//The name ID offset spread objects of the same tier over different frames
+	return interval <= 1 || (frameCounter + object.getNameID()) % interval == 0;
+}
+
 Ogre::MeshPtr AnnGameObjectManager::getAndConvertFromV1Mesh(const char* meshName, Ogre::v1::MeshPtr& v1Mesh, Ogre::MeshPtr& v2Mesh) const
 {
 	static const std::string sufix = "_V2mesh";
@@ -62,18 +168,12 @@ Ogre::MeshPtr AnnGameObjectManager::getAndConvertFromV1Mesh(const char* meshName
 	return v2Mesh;
 }
 
-std::shared_ptr<AnnGameObject> AnnGameObjectManager::createGameObject(const std::string& meshName, std::string identifier, std::shared_ptr<AnnGameObject> obj)
+Ogre::Item* AnnGameObjectManager::createItemFromMesh(const std::string& meshName)
 {
-	AnnDebug("Creating a game object from the mesh file: " + std::string(meshName));
 	auto smgr { AnnGetEngine()->getSceneManager() };
 
-	Ogre::Item* item = nullptr;
-
 	//Check filename extension:
-	auto ext = meshName.substr(meshName.find_last_of('.') + 1);
-	std::transform(ext.begin(), ext.end(), ext.begin(), [](char c) { return char(::tolower(int(c))); });
-
-	if(ext == "mesh")
+	if(isV1Mesh(meshName))
 	{
 		Ogre::v1::MeshPtr v1Mesh;
 		Ogre::MeshPtr v2Mesh;
@@ -81,15 +181,19 @@ std::shared_ptr<AnnGameObject> AnnGameObjectManager::createGameObject(const std:
 		v1Mesh.setNull();
 
 		//Create an item
-		item = smgr->createItem(v2Mesh);
-	}
-	else if(ext == "glb")
-	{
-		item = glTFLoader->getModelData(meshName, Ogre_glTF::glTFLoader::LoadFrom::ResourceManager).makeItem(smgr);
+		return smgr->createItem(v2Mesh);
 	}
 
+	if(getLowerCaseExtension(meshName) == "glb")
+		return glTFLoader->getModelData(meshName, Ogre_glTF::glTFLoader::LoadFrom::ResourceManager).makeItem(smgr);
+
+	return nullptr;
+}
+
+std::shared_ptr<AnnGameObject> AnnGameObjectManager::registerGameObject(Ogre::Item* item, const std::string& meshName, std::string identifier, std::shared_ptr<AnnGameObject> obj)
+{
 	//Create a node
-	auto node = smgr->getRootSceneNode()->createChildSceneNode();
+	auto node = AnnGetEngine()->getSceneManager()->getRootSceneNode()->createChildSceneNode();
 
 	//Attach
 	node->attachObject(item);
@@ -108,14 +212,135 @@ std::shared_ptr<AnnGameObject> AnnGameObjectManager::createGameObject(const std:
 	AnnDebug() << "The object " << identifier << " has been created. Annwvyn memory address " << obj;
 	AnnDebug() << "This object take " << sizeof *obj.get() << " bytes";
 
-	obj->name					  = identifier;
-	identifiedObjects[identifier] = obj;
+	obj->nameID					   = AnnGetStringUtility()->intern(identifier);
+	obj->name					   = std::move(identifier);
+	identifiedObjects[obj->nameID] = obj;
 	Objects.push_back(obj);
 
 	obj->postInit();
 	return obj;
 }
 
+std::shared_ptr<AnnGameObject> AnnGameObjectManager::createGameObject(const std::string& meshName, std::string identifier, std::shared_ptr<AnnGameObject> obj)
+{
+	AnnDebug("Creating a game object from the mesh file: " + std::string(meshName));
+	return registerGameObject(createItemFromMesh(meshName), meshName, std::move(identifier), std::move(obj));
+}
+
+Ogre::v1::MeshPtr AnnGameObjectManager::declareV1Mesh(const std::string& meshName)
+{
+	//Declare the resource here, so the worker doesn't modify the resource manager's containers
+	return Ogre::v1::MeshManager::getSingleton().createOrRetrieve(meshName,
+																  Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME,
+																  false,
+																  nullptr,
+																  nullptr,
+																  Ogre::v1::HardwareBuffer::HBU_STATIC,
+																  Ogre::v1::HardwareBuffer::HBU_STATIC)
+		.first.staticCast<Ogre::v1::Mesh>();
+}
+
+std::shared_future<void> AnnGameObjectManager::prepareMesh(const std::string& meshName)
+{
+	if(!isV1Mesh(meshName))
+	{
+		std::promise<void> ready;
+		ready.set_value();
+		return ready.get_future().share();
+	}
+
+	auto prepared = std::make_shared<std::promise<void>>();
+	std::shared_future<void> result(prepared->get_future());
+	AnnGetResourceManager()->prepareInBackground(declareV1Mesh(meshName), [prepared](std::exception_ptr error) {
+		if(error)
+			prepared->set_exception(error);
+		else
+			prepared->set_value();
+	});
+	return result;
+}
+
+std::shared_future<void> AnnGameObjectManager::preloadMesh(const std::string& meshName)
+{
+	auto taskManager = AnnGetTaskManager().get();
+	auto promise	 = std::make_shared<std::promise<void>>();
+	std::shared_future<void> result(promise->get_future());
+
+	if(!isV1Mesh(meshName))
+	{
+		promise->set_value();
+		return result;
+	}
+
+	//Worker reads the file, main thread does the v2 import that createGameObject() would have done
+	AnnGetResourceManager()->prepareInBackground(declareV1Mesh(meshName), [=](std::exception_ptr error) {
+		if(error)
+		{
+			taskManager->runOnMainThread([=] { promise->set_exception(error); });
+			return;
+		}
+
+		taskManager->runOnMainThread([=] {
+			try
+			{
+				Ogre::v1::MeshPtr v1;
+				Ogre::MeshPtr v2;
+				(void)getAndConvertFromV1Mesh(meshName.c_str(), v1, v2);
+				promise->set_value();
+			}
+			catch(...)
+			{
+				promise->set_exception(std::current_exception());
+			}
+		});
+	});
+
+	return result;
+}
+
+std::shared_future<std::shared_ptr<AnnGameObject>> AnnGameObjectManager::createGameObjectAsync(const std::string& meshName, std::string identifier, std::shared_ptr<AnnGameObject> obj, GameObjectReadyCallback onReady)
+{
+	AnnDebug("Asynchronously creating a game object from the mesh file: " + std::string(meshName));
+	auto taskManager = AnnGetTaskManager().get();
+	auto promise	 = std::make_shared<std::promise<std::shared_ptr<AnnGameObject>>>();
+	std::shared_future<std::shared_ptr<AnnGameObject>> result(promise->get_future());
+
+	//Main thread part : the mesh data is in memory, do the v2 import, create the item and put it in the scene
+	auto finish = [=] {
+		std::shared_ptr<AnnGameObject> object;
+		try
+		{
+			object = registerGameObject(createItemFromMesh(meshName), meshName, identifier, obj);
+		}
+		catch(...)
+		{
+			promise->set_exception(std::current_exception());
+			return;
+		}
+
+		//The future is already satisfied, errors of the callback are the caller's, like with createGameObject()
+		promise->set_value(object);
+		if(onReady) onReady(object);
+	};
+
+	//Ogre_glTF doesn't separate parsing from Item creation, everything happens when the main thread gets to it
+	if(!isV1Mesh(meshName))
+	{
+		taskManager->runOnMainThread(finish);
+		return result;
+	}
+
+	//Worker part : read the file into memory. load() on the main thread will not touch the disk.
+	AnnGetResourceManager()->prepareInBackground(declareV1Mesh(meshName), [=](std::exception_ptr error) {
+		if(error)
+			taskManager->runOnMainThread([=] { promise->set_exception(error); });
+		else
+			taskManager->runOnMainThread(finish);
+	});
+
+	return result;
+}
+
 void AnnGameObjectManager::removeGameObject(std::shared_ptr<AnnGameObject> object)
 {
 	AnnDebug() << "Removed object " << object->getName();
@@ -126,7 +351,22 @@ void AnnGameObjectManager::removeGameObject(std::shared_ptr<AnnGameObject> objec
 		std::remove(std::begin(Objects), std::end(Objects), object),
 		std::end(Objects));
 
-	identifiedObjects.erase(object->getName());
+	identifiedObjects.erase(object->getNameID());
+}
+
+void AnnGameObjectManager::removeGameObjects(const AnnGameObjectList& objects)
+{
+	AnnDebug() << "Removing " << objects.size() << " objects";
+
+	std::vector<btRigidBody*> bodies;
+	bodies.reserve(objects.size());
+	for(const auto& object : objects)
+		if(object && object->getBody()) bodies.push_back(object->getBody());
+
+	//Destructors will find the bodies already out of the simulation
+	if(const auto physics = AnnGetPhysicsEngine())
+		physics->removeRigidBodies(bodies);
+	removeAll(Objects, identifiedObjects, objects);
 }
 
 std::shared_ptr<AnnGameObject> AnnGameObjectManager::getFromNode(Ogre::SceneNode* node)
@@ -147,7 +387,12 @@ void AnnGameObjectManager::removeLightObject(std::shared_ptr<AnnLightObject> lig
 		std::remove(std::begin(Lights), std::end(Lights), light),
 		std::end(Lights));
 
-	identifiedLights.erase(light->getName());
+	identifiedLights.erase(light->getNameID());
+}
+
+void AnnGameObjectManager::removeLightObjects(const AnnLightList& lights)
+{
+	removeAll(Lights, identifiedLights, lights);
 }
 
 std::shared_ptr<AnnLightObject> AnnGameObjectManager::createLightObject(std::string lightObjectName)
@@ -156,8 +401,9 @@ std::shared_ptr<AnnLightObject> AnnGameObjectManager::createLightObject(std::str
 	if(lightObjectName.empty()) lightObjectName = "light" + std::to_string(nextID());
 	auto Light = std::make_shared<AnnLightObject>(AnnGetEngine()->getSceneManager()->createLight(), lightObjectName);
 	Light->setType(AnnLightObject::LightTypes::ANN_LIGHT_POINT);
+	Light->nameID = AnnGetStringUtility()->intern(lightObjectName);
 	Lights.push_back(Light);
-	identifiedLights[lightObjectName] = Light;
+	identifiedLights[Light->nameID] = Light;
 	return Light;
 }
 
@@ -166,8 +412,9 @@ std::shared_ptr<AnnTriggerObject> AnnGameObjectManager::createTriggerObject(std:
 	AnnDebug("Creating a trigger object");
 	if(triggerObjectName.empty()) triggerObjectName = "trigger" + std::to_string(nextID());
 	auto trigger = std::make_shared<AnnTriggerObject>(triggerObjectName);
+	trigger->nameID = AnnGetStringUtility()->intern(triggerObjectName);
 	Triggers.push_back(trigger);
-	identifiedTriggerObjects[triggerObjectName] = trigger;
+	identifiedTriggerObjects[trigger->nameID] = trigger;
 	return trigger;
 }
 
@@ -177,7 +424,12 @@ void AnnGameObjectManager::removeTriggerObject(std::shared_ptr<AnnTriggerObject>
 		std::remove(std::begin(Triggers), std::end(Triggers), trigger),
 		std::end(Triggers));
 
-	identifiedTriggerObjects.erase(trigger->getName());
+	identifiedTriggerObjects.erase(trigger->getNameID());
+}
+
+void AnnGameObjectManager::removeTriggerObjects(const AnnTriggerObjectList& triggers)
+{
+	removeAll(Triggers, identifiedTriggerObjects, triggers);
 }
 
 std::shared_ptr<AnnGameObject> AnnGameObjectManager::playerLookingAt(unsigned short limit)
@@ -211,25 +463,40 @@ std::shared_ptr<AnnGameObject> AnnGameObjectManager::playerLookingAt(unsigned sh
 	return getFromNode(result->movable->getParentSceneNode());
 }
 
-std::shared_ptr<AnnGameObject> AnnGameObjectManager::getGameObject(std::string gameObjectName)
+std::shared_ptr<AnnGameObject> AnnGameObjectManager::getGameObject(const std::string& gameObjectName)
+{
+	return getGameObject(AnnGetStringUtility()->find(gameObjectName));
+}
+
+std::shared_ptr<AnnGameObject> AnnGameObjectManager::getGameObject(AnnStringID gameObjectID)
 {
-	const auto object = identifiedObjects.find(gameObjectName);
+	const auto object = identifiedObjects.find(gameObjectID);
 	if(object != end(identifiedObjects))
 		return object->second;
 	return nullptr;
 }
 
-std::shared_ptr<AnnLightObject> AnnGameObjectManager::getLightObject(std::string lightObjectName)
+std::shared_ptr<AnnLightObject> AnnGameObjectManager::getLightObject(const std::string& lightObjectName)
+{
+	return getLightObject(AnnGetStringUtility()->find(lightObjectName));
+}
+
+std::shared_ptr<AnnLightObject> AnnGameObjectManager::getLightObject(AnnStringID lightObjectID)
 {
-	const auto light = identifiedLights.find(lightObjectName);
+	const auto light = identifiedLights.find(lightObjectID);
 	if(light != end(identifiedLights))
 		return light->second;
 	return nullptr;
 }
 
-std::shared_ptr<AnnTriggerObject> Annwvyn::AnnGameObjectManager::getTriggerObject(std::string triggerObjectName)
+std::shared_ptr<AnnTriggerObject> AnnGameObjectManager::getTriggerObject(const std::string& triggerObjectName)
 {
-	const auto trigger = identifiedTriggerObjects.find(triggerObjectName);
+	return getTriggerObject(AnnGetStringUtility()->find(triggerObjectName));
+}
+
+std::shared_ptr<AnnTriggerObject> AnnGameObjectManager::getTriggerObject(AnnStringID triggerObjectID)
+{
+	const auto trigger = identifiedTriggerObjects.find(triggerObjectID);
 	if(trigger != end(identifiedTriggerObjects))
 		return trigger->second;
 	return nullptr;
@@ -242,6 +509,36 @@ void AnnGameObjectManager::setImportParameter(bool halfPosition, bool halfTextur
 	qTan		 = qTangents;
 }
 
+void AnnGameObjectManager::setUpdateLodEnabled(bool state)
+{
+	updateLodEnabled = state && !updateLodTiers.empty();
+}
+
+bool AnnGameObjectManager::isUpdateLodEnabled() const
+{
+	return updateLodEnabled;
+}
+
+void AnnGameObjectManager::setUpdateLodTiers(std::vector<UpdateLodTier> tiers)
+{
+	std::sort(std::begin(tiers), std::end(tiers), [](const UpdateLodTier& a, const UpdateLodTier& b) {
+		return a.maxDistance < b.maxDistance;
+	});
+
+	updateLodTiers = std::move(tiers);
+	if(updateLodTiers.empty()) updateLodEnabled = false;
+}
+
+const std::vector<AnnGameObjectManager::UpdateLodTier>& AnnGameObjectManager::getUpdateLodTiers() const
+{
+	return updateLodTiers;
+}
+
+void AnnGameObjectManager::setUpdateLodInvisiblePenalty(size_t tiers)
+{
+	updateLodInvisiblePenalty = tiers;
+}
+
 uID AnnGameObjectManager::nextID()
 {
 	return ++autoID;
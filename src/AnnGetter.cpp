@@ -22,4 +22,5 @@ namespace Annwvyn
 	AnnGameObjectManagerPtr AnnGetGameObjectManager() { return AnnGetEngine()->getGameObjectManager(); }
 	AnnConsolePtr AnnGetOnScreenConsole() { return AnnGetEngine()->getOnScreenConsole(); }
 	AnnStringUtilityPtr AnnGetStringUtility() { return AnnGetEngine()->getStringUtility(); }
+	AnnTaskManagerPtr AnnGetTaskManager() { return AnnGetEngine()->getTaskManager(); }
 }
@@ -64,28 +64,26 @@ namespace Annwvyn
 		p.colideWithPlayer = j["playerColide"];
 	}
 
-	void from_json(const json_t& j, AnnGameObjectPtr& obj)
+	void from_json(const json_t& j, AnnDataLevel::ObjectDescription& object)
 	{
-		auto GameObjectManager = AnnGetGameObjectManager();
-		obj					   = GameObjectManager->createGameObject(j["mesh"], j["name"]);
-		if(!obj) throw AnnNullGameObjectError();
-
-		obj->setPosition(j["position"]);
-		obj->setOrientation(j["orientation"]);
-		obj->setScale(j["scale"]);
-
-		if(j["hasPhysics"])
+		object.name		   = j["name"].get<std::string>();
+		object.mesh		   = j["mesh"].get<std::string>();
+		object.position	   = j["position"].get<AnnVect3>();
+		object.orientation = j["orientation"].get<AnnQuaternion>();
+		object.scale	   = j["scale"].get<AnnVect3>();
+
+		object.hasPhysics = j["hasPhysics"];
+		if(object.hasPhysics)
 		{
-			phyParam param = j["physics"];
-			if(param.type == error) throw AnnInvalidPhysicalShapeError(obj->getName());
-			obj->setupPhysics(param.mass, param.type, param.colideWithPlayer);
+			const phyParam param	= j["physics"];
+			object.mass				= param.mass;
+			object.shape			= param.type;
+			object.colideWithPlayer = param.colideWithPlayer;
 		}
 
 		if(!j["scripts"].is_null())
-		{
 			for(auto& jsonScript : j["scripts"])
-				obj->attachScript(jsonScript);
-		}
+				object.scripts.push_back(jsonScript.get<std::string>());
 	}
 
 	AnnLightObject::LightTypes lightTypeFromString(const std::string& s)
@@ -141,7 +139,7 @@ namespace Annwvyn
 using namespace Annwvyn;
 
 AnnJsonLevel::AnnJsonLevel(std::string path, const bool preload) :
- constructLevel(),
+ AnnDataLevel(),
  preloadResources(preload)
 {
 	jsonFile   = std::make_unique<AnnJson>();
@@ -169,7 +167,7 @@ AnnJsonLevel::AnnJsonLevel(std::string path, const bool preload) :
 }
 
 AnnJsonLevel::AnnJsonLevel(bool, std::string jsonCode, const bool preload) :
- constructLevel(),
+ AnnDataLevel(),
  preloadResources(preload)
 {
 	jsonFile   = std::make_unique<AnnJson>();
@@ -182,12 +180,19 @@ AnnJsonLevel::~AnnJsonLevel()
 {
 }
 
-void AnnJsonLevel::load()
+size_t AnnJsonLevel::getObjectCount() const
 {
-	auto& json = jsonFile->j;
+	return jsonFile->j["content"].size();
+}
 
-	for(auto& jsonGameObject : json["content"])
-		levelContent.push_back(jsonGameObject);
+AnnDataLevel::ObjectDescription AnnJsonLevel::getObject(size_t index) const
+{
+	return jsonFile->j["content"][index].get<ObjectDescription>();
+}
+
+void AnnJsonLevel::finishContent()
+{
+	auto& json = jsonFile->j;
 
 	for(auto& jsonLight : json["lighting"])
 		levelLighting.push_back(jsonLight);
@@ -200,15 +205,9 @@ void AnnJsonLevel::load()
 	AnnDebug() << player->getOrientation();
 }
 
-void AnnJsonLevel::runLogic()
-{
-}
-
 void AnnJsonLevel::processJson()
 {
 	auto& json = jsonFile->j;
-	AnnDebug() << "got json:\n"
-			   << json;
 	name = json["name"].get<std::string>();
 	AnnDebug() << "name is " << name;
 
@@ -217,6 +216,7 @@ void AnnJsonLevel::processJson()
 	for(const resLocParam resource : json["resources"])
 	{
 		declareResource(resource);
+		addResourceGroup(resource.group);
 		auto resourceManager = AnnGetResourceManager();
 		if(preloadResources && resource.group != resourceManager->getDefaultResourceGroupName())
 		{
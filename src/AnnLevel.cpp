@@ -31,24 +31,55 @@ void AnnLevel::unload()
 	//Restore the default gravity
 	AnnGetPhysicsEngine()->resetGravity();
 
+	removeContent();
+
+	AnnGetPlayer()->_hintRoomscaleUpdateTranslationReference();
+}
+
+void AnnLevel::removeContent()
+{
 	//Remove the level lights
-	for(auto obj : levelLighting)
-		AnnGetGameObjectManager()->removeLightObject(obj);
+	AnnGetGameObjectManager()->removeLightObjects(levelLighting);
 	levelLighting.clear();
 
-	//Remove the level objects
-	for(auto obj : levelContent)
-		AnnGetGameObjectManager()->removeGameObject(obj);
+	//Remove the level objects. Their bodies leave the physics in one batch
+	AnnGetGameObjectManager()->removeGameObjects(levelContent);
 	levelContent.clear();
 
 	//Remove volumetric event triggers
-	for(auto obj : levelTrigger)
-		AnnGetGameObjectManager()->removeTriggerObject(obj);
+	AnnGetGameObjectManager()->removeTriggerObjects(levelTrigger);
 	levelTrigger.clear();
 
 	levelMovable.clear();
+}
 
-	AnnGetPlayer()->_hintRoomscaleUpdateTranslationReference();
+void AnnLevel::preload()
+{
+}
+
+bool AnnLevel::isPreloaded() const
+{
+	return true;
+}
+
+void AnnLevel::beginLoad()
+{
+}
+
+AnnLevel::LoadProgress AnnLevel::loadStep()
+{
+	return LoadProgress::Done;
+}
+
+void AnnLevel::finishLoad()
+{
+	load();
+}
+
+void AnnLevel::abandonLoad()
+{
+	AnnDebug() << "Abandoning the loading of level " << this;
+	removeContent();
 }
 
 AnnTriggerObjectList& AnnLevel::getTriggers()
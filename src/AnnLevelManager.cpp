@@ -6,19 +6,26 @@
 #include "AnnLogger.hpp"
 #include "AnnGetter.hpp"
 
+#include <algorithm>
+#include <chrono>
+
 using namespace Annwvyn;
 
 AnnLevelManager::AnnLevelManager() :
  AnnSubSystem("LevelManager"),
  current(nullptr),
  jumpRequested(false),
- jumpTo(0)
+ jumpTo(0),
+ loading(nullptr),
+ incrementalLoading(false),
+ loadingBudget(4)
 {
 }
 
 AnnLevelManager::~AnnLevelManager()
 {
 	AnnDebug() << "Deleting the Level Manager. Unloading current level and releasing all level pointers";
+	if(loading) loading->abandonLoad();
 	unloadCurrentLevel();
 }
 
@@ -37,6 +44,10 @@ void AnnLevelManager::switchToLevel(AnnLevelID levelId)
 	AnnDebug() << "LevelManager jumping to levelId : " << levelId;
 	jumpRequested = false;
 	jumpTo		  = 0;
+	if(incrementalLoading) return startLoading(loadedLevels[levelId]);
+
+	if(loading) loading->abandonLoad();
+	loading = nullptr;
 	unloadCurrentLevel();
 	current = loadedLevels[levelId];
 	current->load();
@@ -52,6 +63,22 @@ void AnnLevelManager::switchToLevel(std::shared_ptr<AnnLevel> level)
 		}
 }
 
+void AnnLevelManager::preloadLevel(AnnLevelPtr level)
+{
+	if(!level) return;
+	if(std::find(begin(loadedLevels), end(loadedLevels), level) == end(loadedLevels))
+		addLevel(level);
+
+	AnnDebug() << "Preloading level " << level;
+	level->preload();
+}
+
+void AnnLevelManager::preloadLevel(AnnLevelID levelId)
+{
+	if(levelId < loadedLevels.size())
+		preloadLevel(loadedLevels[levelId]);
+}
+
 void AnnLevelManager::addLevel(std::shared_ptr<AnnLevel> level)
 {
 	AnnDebug() << "Adding level " << level << " to LevelManager";
@@ -73,6 +100,49 @@ void AnnLevelManager::update()
 	if(jumpRequested)
 		return switchToLevel(jumpTo);
 	if(current) current->runLogic();
+	if(loading) continueLoading();
+}
+
+void AnnLevelManager::startLoading(AnnLevelPtr level)
+{
+	if(level == loading) return;
+
+	//A level that was half loaded is abandoned, the current level keeps running
+	if(loading) loading->abandonLoad();
+	loading = nullptr;
+
+	//The current level would be built again in its own content, it's unloaded first
+	if(level == current) unloadCurrentLevel();
+
+	AnnDebug() << "LevelManager loading level " << level << " incrementally";
+	loading = level;
+	loading->beginLoad();
+}
+
+void AnnLevelManager::continueLoading()
+{
+	using clock		  = std::chrono::steady_clock;
+	const auto start  = clock::now();
+	const auto budget = std::chrono::duration<double, std::milli>(loadingBudget);
+
+	//Always do at least one step, or nothing will ever progress with a too small budget
+	do
+	{
+		const auto progress = loading->loadStep();
+
+		//Don't spend the budget checking on the workers, they will be further along next frame
+		if(progress == AnnLevel::LoadProgress::Waiting) return;
+
+		if(progress == AnnLevel::LoadProgress::Done)
+		{
+			AnnDebug() << "Level " << loading << " loaded, switching to it";
+			unloadCurrentLevel();
+			current = loading;
+			loading = nullptr;
+			current->finishLoad();
+			return;
+		}
+	} while(clock::now() - start < budget);
 }
 
 void AnnLevelManager::unloadCurrentLevel()
@@ -81,6 +151,36 @@ void AnnLevelManager::unloadCurrentLevel()
 	current = nullptr;
 }
 
+void AnnLevelManager::setIncrementalLoading(bool state)
+{
+	incrementalLoading = state;
+}
+
+bool AnnLevelManager::isIncrementalLoading() const
+{
+	return incrementalLoading;
+}
+
+void AnnLevelManager::setLoadingBudget(double milliseconds)
+{
+	loadingBudget = std::max(0.0, milliseconds);
+}
+
+double AnnLevelManager::getLoadingBudget() const
+{
+	return loadingBudget;
+}
+
+bool AnnLevelManager::isLoading() const
+{
+	return loading != nullptr;
+}
+
+AnnLevelPtr AnnLevelManager::getLoadingLevel() const
+{
+	return loading;
+}
+
 std::shared_ptr<AnnLevel> AnnLevelManager::getLastLoadedLevel()
 {
 	return loadedLevels.back();
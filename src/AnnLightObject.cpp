@@ -10,7 +10,8 @@ using namespace Annwvyn;
 
 AnnLightObject::AnnLightObject(Ogre::Light* light, const std::string& name) :
  light(light),
- name(name)
+ name(name),
+ nameID(AnnInvalidStringID)
 {
 	AnnDebug() << "Light constructor called";
 	if(light)
@@ -105,6 +106,11 @@ std::string AnnLightObject::getName() const
 	return name;
 }
 
+AnnStringID AnnLightObject::getNameID() const
+{
+	return nameID;
+}
+
 void AnnLightObject::setPower(float lumens) const
 {
 	light->setPowerScale(lumens);
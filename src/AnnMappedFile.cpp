@@ -0,0 +1,158 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include "AnnMappedFile.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Annwvyn;
+
+AnnMappedFile::AnnMappedFile() :
+ data(nullptr),
+ size(0)
+#ifdef _WIN32
+ ,
+ fileHandle(nullptr),
+ mappingHandle(nullptr)
+#endif
+{
+}
+
+AnnMappedFile::AnnMappedFile(const std::string& path) :
+ AnnMappedFile()
+{
+	open(path);
+}
+
+AnnMappedFile::~AnnMappedFile()
+{
+	close();
+}
+
+AnnMappedFile::AnnMappedFile(AnnMappedFile&& other) noexcept :
+ AnnMappedFile()
+{
+	moveFrom(other);
+}
+
+AnnMappedFile& AnnMappedFile::operator=(AnnMappedFile&& other) noexcept
+{
+	if(this != &other)
+	{
+		close();
+		moveFrom(other);
+	}
+	return *this;
+}
+
+void AnnMappedFile::moveFrom(AnnMappedFile& other)
+{
+	data	   = other.data;
+	size	   = other.size;
+	other.data = nullptr;
+	other.size = 0;
+#ifdef _WIN32
+	fileHandle			= other.fileHandle;
+	mappingHandle		= other.mappingHandle;
+	other.fileHandle	= nullptr;
+	other.mappingHandle = nullptr;
+#endif
+}
+
+bool AnnMappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle	= file;
+	mappingHandle = mapping;
+	data		  = static_cast<const byte*>(view);
+	size		  = size_t(fileSize.QuadPart);
+#else
+	const auto file = ::open(path.c_str(), O_RDONLY);
+	if(file < 0) return false;
+
+	struct stat fileStat;
+	if(fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	const auto view = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	//The mapping stays valid after the descriptor is closed
+	::close(file);
+	if(view == MAP_FAILED) return false;
+
+	data = static_cast<const byte*>(view);
+	size = size_t(fileStat.st_size);
+#endif
+
+	return true;
+}
+
+void AnnMappedFile::close()
+{
+	if(!data) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+	fileHandle	= nullptr;
+	mappingHandle = nullptr;
+#else
+	munmap(const_cast<byte*>(data), size);
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+bool AnnMappedFile::isOpen() const
+{
+	return data != nullptr;
+}
+
+const byte* AnnMappedFile::getData() const
+{
+	return data;
+}
+
+size_t AnnMappedFile::getSize() const
+{
+	return size;
+}
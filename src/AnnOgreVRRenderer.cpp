@@ -587,6 +587,13 @@ bool AnnOgreVRRenderer::isHlmsLibLoaded() const
 	return hlmsLoaded;
 }
 
+bool AnnOgreVRRenderer::isInViewFrustum(const Ogre::Sphere& bound) const
+{
+	for(const auto camera : eyeCameras)
+		if(camera && camera->isVisible(bound)) return true;
+	return monoCam && monoCam->isVisible(bound);
+}
+
 std::string AnnOgreVRRenderer::getAudioDeviceNameFromGUID(GUID guid)
 {
 #ifdef _WIN32
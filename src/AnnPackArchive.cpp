@@ -0,0 +1,223 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include "AnnPackArchive.hpp"
+#include "AnnLogger.hpp"
+
+#include <OgreException.h>
+#include <OgreStringConverter.h>
+
+#include <algorithm>
+#include <sys/stat.h>
+
+#ifdef ANNWVYN_PACK_LZ4
+#include <lz4.h>
+#endif
+
+using namespace Annwvyn;
+
+AnnPackArchive::AnnPackArchive(const Ogre::String& name, const Ogre::String& archiveType) :
+ Archive(name, archiveType),
+ header(nullptr),
+ entries(nullptr),
+ names(nullptr),
+ modifiedTime(0)
+{
+}
+
+AnnPackArchive::~AnnPackArchive()
+{
+	AnnPackArchive::unload();
+}
+
+bool AnnPackArchive::isCaseSensitive() const
+{
+	return true;
+}
+
+void AnnPackArchive::load()
+{
+	if(pack.isOpen()) return;
+
+	if(!pack.open(mName))
+		OGRE_EXCEPT(Ogre::Exception::ERR_FILE_NOT_FOUND, "Cannot map resource pack " + mName, "AnnPackArchive::load");
+
+	header = AnnPackHeader::find(pack.getData(), pack.getSize());
+	if(!header)
+	{
+		pack.close();
+		OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, mName + " is not a valid resource pack", "AnnPackArchive::load");
+	}
+
+	entries = reinterpret_cast<const AnnPackEntry*>(pack.getData() + header->indexOffset);
+	names	= reinterpret_cast<const char*>(pack.getData() + header->nameTableOffset);
+
+	//Don't trust the index, a broken pack must not make us read outside of the mapping
+	for(uint32_t i { 0 }; i < header->entryCount; ++i)
+	{
+		const auto& entry = entries[i];
+		if(entry.offset > pack.getSize() || entry.storedSize > pack.getSize() - entry.offset
+		   || uint64_t(entry.nameOffset) + entry.nameLength > header->nameTableSize
+		   || (entry.compression == AnnPackEntry::None && entry.storedSize != entry.size))
+		{
+			unload();
+			OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, mName + " has a corrupted index", "AnnPackArchive::load");
+		}
+	}
+
+	struct stat packStat;
+	modifiedTime = stat(mName.c_str(), &packStat) == 0 ? packStat.st_mtime : 0;
+
+	AnnDebug() << "Mapped resource pack " << mName << " : " << header->entryCount << " files";
+}
+
+void AnnPackArchive::unload()
+{
+	pack.close();
+	header  = nullptr;
+	entries = nullptr;
+	names   = nullptr;
+}
+
+const AnnPackEntry* AnnPackArchive::findEntry(const Ogre::String& filename) const
+{
+	if(!header) return nullptr;
+
+	const auto hash = AnnPackEntry::hash(filename);
+	const auto last = entries + header->entryCount;
+
+	//Entries are sorted by hash, then name
+	for(auto entry = std::lower_bound(entries, last, hash, [](const AnnPackEntry& e, uint64_t h) { return e.nameHash < h; });
+		entry != last && entry->nameHash == hash;
+		++entry)
+		if(filename.compare(0, Ogre::String::npos, names + entry->nameOffset, entry->nameLength) == 0)
+			return entry;
+
+	return nullptr;
+}
+
+Ogre::DataStreamPtr AnnPackArchive::open(const Ogre::String& filename, bool readOnly)
+{
+	const auto entry = findEntry(filename);
+	if(!entry)
+	{
+		AnnDebug() << filename << " is not in resource pack " << mName;
+		return Ogre::DataStreamPtr();
+	}
+
+	const auto data = pack.getData() + entry->offset;
+
+	//A view on the mapping, the OS reads the pages when the stream is read
+	if(entry->compression == AnnPackEntry::None)
+		return Ogre::DataStreamPtr(OGRE_NEW Ogre::MemoryDataStream(filename, const_cast<byte*>(data), size_t(entry->size), false, true));
+
+#ifdef ANNWVYN_PACK_LZ4
+	if(entry->compression == AnnPackEntry::LZ4)
+	{
+		auto stream			 = OGRE_NEW Ogre::MemoryDataStream(filename, size_t(entry->size), true, true);
+		const auto unpacked = LZ4_decompress_safe(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(stream->getPtr()), int(entry->storedSize), int(entry->size));
+		if(unpacked < 0 || uint64_t(unpacked) != entry->size)
+		{
+			OGRE_DELETE stream;
+			OGRE_EXCEPT(Ogre::Exception::ERR_INVALIDPARAMS, "Cannot decompress " + filename + " from resource pack " + mName, "AnnPackArchive::open");
+		}
+		return Ogre::DataStreamPtr(stream);
+	}
+#endif
+
+	OGRE_EXCEPT(Ogre::Exception::ERR_NOT_IMPLEMENTED,
+				filename + " from resource pack " + mName + " uses an unsupported compression (" + Ogre::StringConverter::toString(entry->compression) + ")",
+				"AnnPackArchive::open");
+}
+
+Ogre::FileInfo AnnPackArchive::getFileInfo(const AnnPackEntry& entry) const
+{
+	Ogre::FileInfo info;
+	info.archive		  = this;
+	info.filename		  = Ogre::String(names + entry.nameOffset, entry.nameLength);
+	info.compressedSize   = size_t(entry.storedSize);
+	info.uncompressedSize = size_t(entry.size);
+
+	const auto separator = info.filename.find_last_of('/');
+	if(separator == Ogre::String::npos)
+	{
+		info.basename = info.filename;
+	}
+	else
+	{
+		info.path	 = info.filename.substr(0, separator + 1);
+		info.basename = info.filename.substr(separator + 1);
+	}
+
+	return info;
+}
+
+Ogre::FileInfoListPtr AnnPackArchive::getMatchingFileInfo(const Ogre::String& pattern, bool recursive, bool dirs) const
+{
+	Ogre::FileInfoListPtr content(OGRE_NEW_T(Ogre::FileInfoList, Ogre::MEMCATEGORY_GENERAL)(), Ogre::SPFM_DELETE_T);
+
+	//Packs only store files
+	if(dirs || !header) return content;
+
+	//Like Ogre's archives, a pattern with a path is matched against the full name
+	const auto fullMatch = pattern.find_first_of("/\\") != Ogre::String::npos;
+	for(uint32_t i { 0 }; i < header->entryCount; ++i)
+	{
+		auto info = getFileInfo(entries[i]);
+		if(!recursive && !info.path.empty()) continue;
+		if(!pattern.empty() && !Ogre::StringUtil::match(fullMatch ? info.filename : info.basename, pattern, true)) continue;
+		content->push_back(std::move(info));
+	}
+
+	return content;
+}
+
+Ogre::StringVectorPtr AnnPackArchive::list(bool recursive, bool dirs)
+{
+	return find("", recursive, dirs);
+}
+
+Ogre::FileInfoListPtr AnnPackArchive::listFileInfo(bool recursive, bool dirs)
+{
+	return getMatchingFileInfo("", recursive, dirs);
+}
+
+Ogre::StringVectorPtr AnnPackArchive::find(const Ogre::String& pattern, bool recursive, bool dirs)
+{
+	Ogre::StringVectorPtr content(OGRE_NEW_T(Ogre::StringVector, Ogre::MEMCATEGORY_GENERAL)(), Ogre::SPFM_DELETE_T);
+	for(const auto& info : *getMatchingFileInfo(pattern, recursive, dirs))
+		content->push_back(info.filename);
+	return content;
+}
+
+Ogre::FileInfoListPtr AnnPackArchive::findFileInfo(const Ogre::String& pattern, bool recursive, bool dirs)
+{
+	return getMatchingFileInfo(pattern, recursive, dirs);
+}
+
+bool AnnPackArchive::exists(const Ogre::String& filename)
+{
+	return findEntry(filename) != nullptr;
+}
+
+time_t AnnPackArchive::getModifiedTime(const Ogre::String& filename)
+{
+	return modifiedTime;
+}
+
+const Ogre::String& AnnPackArchiveFactory::getType() const
+{
+	static const Ogre::String name { AnnPackArchive::type };
+	return name;
+}
+
+Ogre::Archive* AnnPackArchiveFactory::createInstance(const Ogre::String& name, bool readOnly)
+{
+	if(!readOnly) return nullptr;
+	return OGRE_NEW AnnPackArchive(name, getType());
+}
+
+void AnnPackArchiveFactory::destroyInstance(Ogre::Archive* archive)
+{
+	OGRE_DELETE archive;
+}
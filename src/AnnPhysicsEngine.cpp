@@ -6,10 +6,79 @@
 #include "AnnLogger.hpp"
 #include "AnnGetter.hpp"
 #include "AnnException.hpp"
+#include "AnnTaskManager.hpp"
+
+#include <unordered_set>
 
 using namespace Annwvyn;
 using std::make_unique;
 
+namespace
+{
+	//Bullet removes bodies one by one, with a linear search in the world arrays each time
+	class BatchRemovalWorld : public btDiscreteDynamicsWorld
+	{
+	public:
+		using btDiscreteDynamicsWorld::btDiscreteDynamicsWorld;
+
+		void removeRigidBodies(const std::vector<btRigidBody*>& bodies)
+		{
+			std::unordered_set<const btCollisionObject*> removed;
+			removed.reserve(bodies.size());
+
+			const auto broadphase = getBroadphase();
+			for(auto body : bodies)
+			{
+				const auto proxy = body ? body->getBroadphaseHandle() : nullptr;
+				if(!proxy) continue;
+				broadphase->getOverlappingPairCache()->cleanProxyFromPairs(proxy, m_dispatcher1);
+				broadphase->destroyProxy(proxy, m_dispatcher1);
+				body->setBroadphaseHandle(nullptr);
+#if BT_BULLET_VERSION >= 287
+				//addCollisionObject() asserts that the body isn't in a world anymore
+				body->setWorldArrayIndex(-1);
+#endif
+				removed.insert(body);
+			}
+			if(removed.empty()) return;
+
+			const auto isRemoved = [&](const btCollisionObject* object) { return removed.count(object) > 0; };
+			compact(m_nonStaticRigidBodies, isRemoved);
+			compact(m_collisionObjects, isRemoved);
+
+#if BT_BULLET_VERSION >= 287
+			for(int i { 0 }; i < m_collisionObjects.size(); ++i)
+				m_collisionObjects[i]->setWorldArrayIndex(i);
+#endif
+		}
+
+	private:
+		template <class T, class Predicate>
+		static void compact(btAlignedObjectArray<T>& array, Predicate isRemoved)
+		{
+			int kept { 0 };
+			for(int i { 0 }; i < array.size(); ++i)
+				if(!isRemoved(array[i])) array[kept++] = array[i];
+			array.resize(kept);
+		}
+	};
+
+	//Only reads the vertices copied by the converter, can run on any thread
+	btCollisionShape* createShape(BtOgre::StaticMeshToShapeConverter& converter, phyShapeType type)
+	{
+		switch(type)
+		{
+			case boxShape: return converter.createBox();
+			case cylinderShape: return converter.createCylinder();
+			case capsuleShape: return converter.createCapsule();
+			case convexShape: return converter.createConvex();
+			case staticShape: return converter.createTrimesh();
+			case sphereShape: return converter.createSphere();
+			default: return nullptr;
+		}
+	}
+}
+
 AnnPhysicsEngine::AnnPhysicsEngine(Ogre::SceneNode* rootNode,
 								   AnnPlayerBodyPtr player) :
  AnnSubSystem("PhysicsEngie"),
@@ -29,7 +98,7 @@ AnnPhysicsEngine::AnnPhysicsEngine(Ogre::SceneNode* rootNode,
 	CollisionConfiguration = make_unique<btDefaultCollisionConfiguration>();
 	Dispatcher			   = make_unique<btCollisionDispatcher>(CollisionConfiguration.get());
 	Solver				   = make_unique<btSequentialImpulseConstraintSolver>();
-	DynamicsWorld		   = make_unique<btDiscreteDynamicsWorld>(Dispatcher.get(), Broadphase.get(), Solver.get(), CollisionConfiguration.get());
+	DynamicsWorld		   = make_unique<BatchRemovalWorld>(Dispatcher.get(), Broadphase.get(), Solver.get(), CollisionConfiguration.get());
 	AnnDebug() << "btDiscreteDynamicsWorld instantiated";
 
 	//Set gravity vector
@@ -115,9 +184,16 @@ void AnnPhysicsEngine::processCollisionTesting() const
 
 void AnnPhysicsEngine::removeRigidBody(btRigidBody* body) const
 {
+	//Bodies removed by removeRigidBodies() don't have a broadphase handle anymore
+	if(!body || !body->getBroadphaseHandle()) return;
 	AnnDebug() << "Removing " << body << " Form physics simulation";
-	if(body)
-		DynamicsWorld->removeRigidBody(body);
+	DynamicsWorld->removeRigidBody(body);
+}
+
+void AnnPhysicsEngine::removeRigidBodies(const std::vector<btRigidBody*>& bodies) const
+{
+	AnnDebug() << "Removing " << bodies.size() << " bodies from physics simulation";
+	static_cast<BatchRemovalWorld*>(DynamicsWorld.get())->removeRigidBodies(bodies);
 }
 
 void AnnPhysicsEngine::setDebugPhysics(bool state)
@@ -192,32 +268,33 @@ btCollisionShape* AnnPhysicsEngine::_getGameObjectShape(AnnGameObject* obj, phyS
 {
 	BtOgre::StaticMeshToShapeConverter converter(obj->getItem());
 
-	btCollisionShape* Shape;
-
-	switch(type)
+	const auto Shape = createShape(converter, type);
+	if(!Shape)
 	{
-		case boxShape:
-			Shape = converter.createBox();
-			break;
-		case cylinderShape:
-			Shape = converter.createCylinder();
-			break;
-		case capsuleShape:
-			Shape = converter.createCapsule();
-			break;
-		case convexShape:
-			Shape = converter.createConvex();
-			break;
-		case staticShape:
-			Shape = converter.createTrimesh();
-			break;
-		case sphereShape:
-			Shape = converter.createSphere();
-			break;
-		default:
-			//non valid;
-			AnnDebug(Log::Important) << "Error: Requested shape is invalid";
-			throw AnnInvalidPhysicalShapeError(obj->getName());
+		//non valid;
+		AnnDebug(Log::Important) << "Error: Requested shape is invalid";
+		throw AnnInvalidPhysicalShapeError(obj->getName());
 	}
 	return Shape;
 }
+
+std::future<btCollisionShape*> AnnPhysicsEngine::_getGameObjectShapeAsync(AnnGameObject* obj, phyShapeType type)
+{
+	if(type < staticShape || type > sphereShape)
+	{
+		AnnDebug(Log::Important) << "Error: Requested shape is invalid";
+		throw AnnInvalidPhysicalShapeError(obj->getName());
+	}
+
+	//The converter copies the vertices of the item, the Item itself is never touched by the worker
+	auto converter = std::make_shared<BtOgre::StaticMeshToShapeConverter>(obj->getItem());
+	return AnnGetTaskManager()->submit([converter, type] { return createShape(*converter, type); });
+}
+
+void AnnPhysicsEngine::_destroyShape(btCollisionShape* shape)
+{
+	if(!shape) return;
+	if(shape->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE)
+		delete static_cast<btBvhTriangleMeshShape*>(shape)->getMeshInterface();
+	delete shape;
+}
@@ -3,15 +3,33 @@
 
 #include "AnnResourceManager.hpp"
 #include "AnnLogger.hpp"
+#include "AnnGetter.hpp"
+#include "AnnPackArchive.hpp"
 #include <OgreConfigFile.h>
+#include <OgreResourceManager.h>
+#include <OgreArchiveManager.h>
+
+#include <algorithm>
+#include <fstream>
 
 using namespace Annwvyn;
 
+namespace
+{
+	//Ogre locks its archives and resource groups with full thread support, or for background resource preparation
+#if OGRE_THREAD_SUPPORT == 1 || OGRE_THREAD_SUPPORT == 2
+	constexpr bool ogreLocksResources { true };
+#else
+	constexpr bool ogreLocksResources { false };
+#endif
+}
+
 AnnResourceManager::AnnResourceManager() :
  AnnSubSystem("ResourceManager"),
  ResourceGroupManager { Ogre::ResourceGroupManager::getSingletonPtr() }
 {
 	ResourceGroupManager->createResourceGroup(getDefaultResourceGroupName());
+	registerPackArchiveFactory();
 	addDefaultResourceLocation();
 }
 
@@ -23,6 +41,21 @@ void AnnResourceManager::addZipLocation(const std::string& path, const std::stri
 	ResourceGroupManager->addResourceLocation(path, "Zip", resourceGroupName);
 }
 
+void AnnResourceManager::addPackLocation(const std::string& path, const std::string& resourceGroupName) const
+{
+	if(resourceGroupName == getReservedResourceGroupName()) return refuseResource(path, resourceGroupName);
+	AnnDebug("Will load resources from resource pack :");
+	AnnDebug() << path;
+	ResourceGroupManager->addResourceLocation(path, AnnPackArchive::type, resourceGroupName);
+}
+
+void AnnResourceManager::registerPackArchiveFactory()
+{
+	//Ogre keeps using the factory until its ArchiveManager is destroyed with Root, after this subsystem
+	static AnnPackArchiveFactory packArchiveFactory;
+	Ogre::ArchiveManager::getSingleton().addArchiveFactory(&packArchiveFactory);
+}
+
 void AnnResourceManager::addFileLocation(const std::string& path, const std::string& resourceGroupName) const
 {
 	if(resourceGroupName == getReservedResourceGroupName()) return refuseResource(path, resourceGroupName);
@@ -34,7 +67,10 @@ void AnnResourceManager::addFileLocation(const std::string& path, const std::str
 void AnnResourceManager::addDefaultResourceLocation() const
 {
 	AnnDebug("Adding Annwvyn CORE resource locations");
-	ResourceGroupManager->addResourceLocation("media/CORE.zip", "Zip", getReservedResourceGroupName());
+	if(std::ifstream("media/CORE.annpak"))
+		ResourceGroupManager->addResourceLocation("media/CORE.annpak", AnnPackArchive::type, getReservedResourceGroupName());
+	else
+		ResourceGroupManager->addResourceLocation("media/CORE.zip", "Zip", getReservedResourceGroupName());
 	ResourceGroupManager->addResourceLocation("media", "FileSystem", getReservedResourceGroupName(), true);
 	ResourceGroupManager->initialiseResourceGroup(getReservedResourceGroupName(), true);
 }
@@ -79,6 +115,280 @@ void AnnResourceManager::loadGroup(const std::string& groupName) const
 		ResourceGroupManager->loadResourceGroup(groupName);
 }
 
+std::shared_future<void> AnnResourceManager::loadGroupAsync(const std::string& groupName)
+{
+	//Already on its way
+	const auto existing = asyncLoads.find(groupName);
+	if(existing != asyncLoads.end()) return existing->second->future;
+
+	//Parsing the scripts of the group has to be done here, loading them is what takes time
+	if(!ResourceGroupManager->isResourceGroupInitialised(groupName))
+		ResourceGroupManager->initialiseResourceGroup(groupName, true);
+
+	//Everything declared in the group that is not loaded yet, in the order Ogre would load them (textures before materials before meshes...)
+	std::vector<std::pair<Ogre::Real, Ogre::ResourcePtr>> resources;
+	forEachResource(groupName, [&](Ogre::ResourceManager* manager, const Ogre::ResourcePtr& resource) {
+		if(!resource->isLoaded()) resources.emplace_back(manager->getLoadingOrder(), resource);
+	});
+	std::stable_sort(resources.begin(), resources.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	auto load	= std::make_shared<AsyncGroupLoad>();
+	load->loaded = 0;
+	load->future = load->done.get_future().share();
+	for(auto& resource : resources) load->resources.push_back(resource.second);
+	load->prepared.resize(resources.size(), false);
+	AnnGetEventManager()->resourceLoadProgress(groupName, 0, resources.size());
+
+	if(resources.empty())
+	{
+		load->done.set_value();
+		return load->future;
+	}
+
+	AnnDebug() << "Loading " << resources.size() << " resources of group " << groupName << " in the background";
+	asyncLoads[groupName] = load;
+
+	//Prepare on a worker reads and decodes the file, load on the main thread creates what the render system needs
+	auto taskManager = AnnGetTaskManager().get();
+	for(size_t i { 0 }; i < load->resources.size(); ++i)
+		prepareInBackground(load->resources[i], [=](std::exception_ptr) {
+			//An error will be raised again by load() on the main thread, where it can be logged
+			taskManager->runOnMainThread([=] { finishAsyncResource(groupName, i); });
+		});
+
+	return load->future;
+}
+
+void AnnResourceManager::finishAsyncResource(const std::string& groupName, size_t index)
+{
+	auto load			   = asyncLoads.at(groupName);
+	load->prepared[index] = true;
+
+	//Preparations finish in any order. A material loaded before its textures would load them right here, synchronously
+	while(load->loaded < load->resources.size() && load->prepared[load->loaded])
+	{
+		const auto& resource = load->resources[load->loaded];
+		try
+		{
+			resource->load();
+		}
+		catch(const Ogre::Exception& e)
+		{
+			AnnDebug(Log::Important) << "Could not load " << resource->getName() << " from group " << groupName << " : " << e.getDescription();
+		}
+
+		AnnGetEventManager()->resourceLoadProgress(groupName, ++load->loaded, load->resources.size());
+	}
+
+	if(load->loaded < load->resources.size()) return;
+
+	AnnDebug() << "Resource group " << groupName << " loaded";
+	load->done.set_value();
+	asyncLoads.erase(groupName);
+}
+
+bool AnnResourceManager::prepareInBackground(Ogre::ResourcePtr resource, std::function<void(std::exception_ptr)> onPrepared)
+{
+	auto taskManager = AnnGetTaskManager().get();
+	auto prepare	 = [resource, onPrepared]() mutable {
+		std::exception_ptr error;
+		try
+		{
+			resource->prepare(true);
+		}
+		catch(...)
+		{
+			error = std::current_exception();
+		}
+
+		//Only the caller holds the resource now, it can unload it as soon as it's done with it
+		resource.setNull();
+		if(onPrepared) onPrepared(error);
+	};
+
+	//Found here, as it may move the resource to another group
+	if(ogreLocksResources || isConcurrentlyReadable(findArchive(resource)))
+	{
+		taskManager->submit(prepare);
+		return true;
+	}
+
+	//The main thread keeps reading from the same archives, a worker would share their read cursor with it
+	taskManager->runOnMainThread(prepare);
+	return false;
+}
+
+Ogre::Archive* AnnResourceManager::findArchive(const Ogre::ResourcePtr& resource) const
+{
+	try
+	{
+		//The worker would otherwise search for the group and change the ownership, modifying the group manager
+		if(resource->getGroup() == Ogre::ResourceGroupManager::AUTODETECT_RESOURCE_GROUP_NAME)
+			resource->changeGroupOwnership(ResourceGroupManager->findGroupContainingResource(resource->getName()));
+
+		for(const auto location : ResourceGroupManager->getResourceLocationList(resource->getGroup()))
+			if(location->archive->exists(resource->getName()))
+				return location->archive;
+	}
+	catch(const Ogre::Exception&)
+	{
+		//Not found anywhere, prepare() will raise the error again
+	}
+
+	return nullptr;
+}
+
+bool AnnResourceManager::isConcurrentlyReadable(const Ogre::Archive* archive)
+{
+	//Each file opened from the disk has its own stream, and packs are mapped in memory
+	return archive && (archive->getType() == "FileSystem" || archive->getType() == AnnPackArchive::type);
+}
+
+bool AnnResourceManager::isGroupLoading(const std::string& groupName) const
+{
+	return asyncLoads.find(groupName) != asyncLoads.end();
+}
+
+void AnnResourceManager::forEachResource(const std::string& groupName, const std::function<void(Ogre::ResourceManager*, const Ogre::ResourcePtr&)>& function) const
+{
+	auto managers = ResourceGroupManager->getResourceManagerIterator();
+	while(managers.hasMoreElements())
+	{
+		const auto manager	= managers.getNext();
+		auto managedResources = manager->getResourceIterator();
+		while(managedResources.hasMoreElements())
+		{
+			const auto resource = managedResources.getNext();
+			if(resource->getGroup() == groupName) function(manager, resource);
+		}
+	}
+}
+
+bool AnnResourceManager::isGpuResourceType(const Ogre::String& resourceType)
+{
+	static const std::vector<Ogre::String> gpuResourceTypes { "Texture", "Mesh", "Mesh2", "GpuProgram", "HighLevelGpuProgram" };
+	return std::find(gpuResourceTypes.begin(), gpuResourceTypes.end(), resourceType) != gpuResourceTypes.end();
+}
+
+AnnResourceMemoryUsage AnnResourceManager::getGroupMemoryUsage(const std::string& groupName) const
+{
+	AnnResourceMemoryUsage usage {};
+	for(const auto& typeUsage : getGroupMemoryUsageByType(groupName))
+	{
+		usage.cpuBytes += typeUsage.second.cpuBytes;
+		usage.gpuBytes += typeUsage.second.gpuBytes;
+		usage.resourceCount += typeUsage.second.resourceCount;
+	}
+	return usage;
+}
+
+std::map<std::string, AnnResourceMemoryUsage> AnnResourceManager::getGroupMemoryUsageByType(const std::string& groupName) const
+{
+	std::map<std::string, AnnResourceMemoryUsage> usage;
+	forEachResource(groupName, [&](Ogre::ResourceManager* manager, const Ogre::ResourcePtr& resource) {
+		if(!resource->isLoaded()) return;
+
+		auto& typeUsage = usage[manager->getResourceType()];
+		(isGpuResourceType(manager->getResourceType()) ? typeUsage.gpuBytes : typeUsage.cpuBytes) += resource->getSize();
+		++typeUsage.resourceCount;
+	});
+	return usage;
+}
+
+void AnnResourceManager::logMemoryUsage() const
+{
+	for(const auto& groupName : ResourceGroupManager->getResourceGroups())
+	{
+		const auto usage = getGroupMemoryUsage(groupName);
+		AnnDebug() << "Resource group " << groupName << " : " << usage.resourceCount << " resources, " << usage.cpuBytes << " CPU bytes, " << usage.gpuBytes << " GPU bytes";
+		for(const auto& typeUsage : getGroupMemoryUsageByType(groupName))
+			AnnDebug() << "    " << typeUsage.first << " : " << typeUsage.second.resourceCount << " resources, " << typeUsage.second.getTotalBytes() << " bytes";
+	}
+}
+
+void AnnResourceManager::setGroupMemoryBudget(const std::string& groupName, size_t bytes)
+{
+	if(bytes == 0)
+	{
+		groupMemoryBudgets.erase(groupName);
+		resourceLastUse.erase(groupName);
+	}
+	else
+		groupMemoryBudgets[groupName] = bytes;
+
+	//Check it on the next frame
+	nextBudgetCheck = std::chrono::steady_clock::now();
+}
+
+size_t AnnResourceManager::getGroupMemoryBudget(const std::string& groupName) const
+{
+	const auto budget = groupMemoryBudgets.find(groupName);
+	return budget != groupMemoryBudgets.end() ? budget->second : 0;
+}
+
+bool AnnResourceManager::needUpdate()
+{
+	return !groupMemoryBudgets.empty();
+}
+
+void AnnResourceManager::update()
+{
+	//Walking through every resource is too much to do each frame
+	const auto now = std::chrono::steady_clock::now();
+	if(now < nextBudgetCheck) return;
+	nextBudgetCheck = now + std::chrono::milliseconds(500);
+
+	for(const auto& groupBudget : groupMemoryBudgets)
+		enforceMemoryBudget(groupBudget.first, groupBudget.second);
+}
+
+void AnnResourceManager::enforceMemoryBudget(const std::string& groupName, size_t budget)
+{
+	const auto now = std::chrono::steady_clock::now();
+	size_t used	= 0;
+	std::vector<std::pair<std::chrono::steady_clock::time_point, Ogre::ResourcePtr>> unreferenced;
+
+	//Only keep the resources still loaded in the group, removed ones would stay in there forever
+	auto& lastUse = resourceLastUse[groupName];
+	std::unordered_map<Ogre::ResourceHandle, std::chrono::steady_clock::time_point> stillLoaded;
+
+	forEachResource(groupName, [&](Ogre::ResourceManager*, const Ogre::ResourcePtr& resource) {
+		if(!resource->isLoaded()) return;
+		used += resource->getSize();
+
+		//Ogre's own references, plus the copy given to us
+		const auto previous = lastUse.find(resource->getHandle());
+		auto& time			= stillLoaded[resource->getHandle()];
+		if(resource.useCount() > Ogre::ResourceGroupManager::RESOURCE_SYSTEM_NUM_REFERENCE_COUNTS + 1)
+		{
+			time = now;
+			return;
+		}
+
+		time = previous != lastUse.end() ? previous->second : now;
+		unreferenced.emplace_back(time, resource);
+	});
+
+	lastUse.swap(stillLoaded);
+
+	if(used <= budget) return;
+
+	std::sort(unreferenced.begin(), unreferenced.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	size_t unloaded = 0;
+	for(auto& resource : unreferenced)
+	{
+		if(used <= budget) break;
+		used -= std::min(used, resource.second->getSize());
+		lastUse.erase(resource.second->getHandle());
+		resource.second->unload();
+		++unloaded;
+	}
+
+	if(unloaded > 0)
+		AnnDebug() << "Unloaded " << unloaded << " resources of group " << groupName << " for its " << budget << " bytes budget, " << used << " bytes left loaded";
+}
+
 const char* AnnResourceManager::getDefaultResourceGroupName()
 {
 	return "b";
@@ -9,13 +9,76 @@
 #include "AnnGetter.hpp"
 #include "Annwvyn.h"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
 using namespace Annwvyn;
 
+namespace
+{
+	//Names of the hooks in the profiler reports, by hook index. update() comes last
+	const std::array<const char*, HookCount + 1> hookNames { { "KeyEvent",
+															   "MouseEvent",
+															   "ControllerEvent",
+															   "TimeEvent",
+															   "TriggerEvent",
+															   "HandControllerEvent",
+															   "CollisionEvent",
+															   "PlayerCollisionEvent",
+															   "update" } };
+
+	//Get the entry of a profile for a hook index, HookCount being update()
+	const AnnScriptProfileEntry& profileEntry(const AnnScriptProfile& profile, size_t hook)
+	{
+		return hook == HookCount ? profile.update : profile.hooks[hook];
+	}
+
+	using profilerClock = std::chrono::steady_clock;
+
+	double millisecondsSince(profilerClock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(profilerClock::now() - start).count();
+	}
+
+	//Get a method of a script class, or nullptr if the class doesn't define it. Functions with that name that belong to other classes are ignored. Doesn't throw when the name is unknown
+	template <class Functions, class Event>
+	std::function<void(chaiscript::Boxed_Value&, Event)> getMethodIfDefined(chaiscript::ChaiScript& chai, const Functions& functions, const std::string& className, const std::string& methodName, const Event& probe)
+	{
+		const auto overloads = std::find_if(std::begin(functions), std::end(functions), [&](const auto& function) { return function.first == methodName; });
+		if(overloads == std::end(functions)) return nullptr;
+
+		//Each overload is matched like ChaiScript dispatches a call, with a blank instance of the class. Methods only accept instances of their own class
+		chaiscript::Type_Conversions conversions;
+		const chaiscript::Type_Conversions_State conversionState(conversions, conversions.conversion_saves());
+		const std::vector<chaiscript::Boxed_Value> arguments { chaiscript::Boxed_Value(chaiscript::dispatch::Dynamic_Object(className)), chaiscript::Boxed_Value(probe) };
+		const auto defined = std::any_of(std::begin(*overloads->second), std::end(*overloads->second), [&](const chaiscript::Proxy_Function& overload) {
+			try
+			{
+				return overload->call_match(arguments, conversionState);
+			}
+			catch(const chaiscript::exception::eval_error& ee)
+			{
+				//The guard of a method is only evaluated once the class matched. Any other function is not a method of this class
+				if(!std::dynamic_pointer_cast<chaiscript::dispatch::detail::Dynamic_Object_Function>(overload)) return false;
+				AnnDebug() << "Guard of " << className << "::" << methodName << " can't be evaluated on a blank instance, the method is used anyway - " << ee.pretty_print();
+				return true;
+			}
+		});
+
+		if(!defined) return nullptr;
+		return chai.eval<std::function<void(chaiscript::Boxed_Value&, Event)>>(methodName);
+	}
+}
+
 constexpr const char* const AnnScriptManager::fileErrorPrefix;
 constexpr const char* const AnnScriptManager::logFromScript;
 
 AnnScriptManager::AnnScriptManager() :
  AnnSubSystem("ScriptManager"),
+ dispatcher(std::make_shared<AnnBehaviorScriptDispatcher>()),
+ profiling(false),
  scriptFileManager(nullptr)
 {
 	registerApi();
@@ -187,6 +250,7 @@ void AnnScriptManager::registerApi()
 		chai.add(fun([](AnnGameObject* o, const string& s) { o->playSound(s); }), "playSound");
 		chai.add(fun([](AnnGameObject* o, const string& s) { o->playSound(s, true); }), "playSoundLoop");
 		chai.add(fun([](AnnGameObject* o) { return o->getName(); }), "getName");
+		chai.add(fun([](AnnGameObject* o) { return o->getUpdateDeltaTime(); }), "getUpdateDeltaTime");
 		chai.add(fun([](AnnGameObject* o, const string& animName) { o->setAnimation(animName); }), "setAnimation");
 		chai.add(fun([](AnnGameObject* o) { o->playAnimation(); }), "playAnimation");
 		chai.add(fun([](AnnGameObject* o, bool play) { o->playAnimation(play); }), "playAnimation");
@@ -248,6 +312,16 @@ void AnnScriptManager::registerApi()
 		//Restore the default gravity vector
 		chai.add(fun([]() { AnnGetPhysicsEngine()->resetGravity(); }), "AnnRestoreGravity");
 
+		//Script profiler
+		chai.add(fun([](bool state) { AnnGetScriptManager()->setProfilingEnabled(state); }), "AnnScriptProfilerEnable");
+		chai.add(fun([]() { AnnGetScriptManager()->resetProfile(); }), "AnnScriptProfilerReset");
+		chai.add(fun([](const string& path) { return AnnGetScriptManager()->dumpProfile(path); }), "AnnScriptProfilerDump");
+		chai.add(fun([]() {
+					 for(const auto& line : AnnGetScriptManager()->getProfileReport())
+						 AnnDebug(Log::Important) << line;
+				 }),
+				 "AnnScriptProfilerReport");
+
 		//Add the types of the event representation object
 		chai.add(user_type<AnnKeyEvent>(), "AnnKeyEvent");
 		chai.add(user_type<AnnMouseEvent>(), "AnnMouseEvent");
@@ -376,85 +450,6 @@ void AnnScriptManager::registerApi()
 	}
 }
 
-void AnnScriptManager::tryAndGetEventHooks()
-{
-	//Forgive me.
-	try
-	{
-		callKeyEventOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnKeyEvent)>>("KeyEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callKeyEventOnScriptInstance = nullptr;
-	}
-
-	//Yes. I'm doing this.
-	try
-	{
-		callMouseEventOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnMouseEvent)>>("MouseEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callMouseEventOnScriptInstance = nullptr;
-	}
-
-	//Yes, there's 6 of them
-	try
-	{
-		callStickEventOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnControllerEvent)>>("ControllerEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callStickEventOnScriptInstance = nullptr;
-	}
-
-	//And yes, it's probable that something will be thrown, unless a script already have this function
-	try
-	{
-		callTimeEventOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnTimeEvent)>>("TimeEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callTimeEventOnScriptInstance = nullptr;
-	}
-
-	//And it's also possible than the result is not usable with this script and will throw later at eval time
-	try
-	{
-		callTriggerEventOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnTriggerEvent)>>("TriggerEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callTriggerEventOnScriptInstance = nullptr;
-	}
-
-	//Like I said. Please forgive me.
-	try
-	{
-		callHandControllertOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnHandControllerEvent)>>("HandControllerEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callHandControllertOnScriptInstance = nullptr;
-	}
-	try
-	{
-		callCollisionEventOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnCollisionEvent)>>("CollisionEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callCollisionEventOnScriptInstance = nullptr;
-	}
-	try
-	{
-		callPlayerCollisionEventOnScriptInstance = chai.eval<std::function<void(chaiscript::Boxed_Value&, AnnPlayerCollisionEvent)>>("PlayerCollisionEvent");
-	}
-	catch(const chaiscript::exception::eval_error&)
-	{
-		callPlayerCollisionEventOnScriptInstance = nullptr;
-	}
-}
-
 bool AnnScriptManager::evalFile(const std::string& file)
 {
 	try
@@ -474,78 +469,71 @@ bool AnnScriptManager::evalFile(const std::string& file)
 	return true;
 }
 
-AnnScriptManager::AnnScriptID AnnScriptManager::ID { 0 };
-
-std::shared_ptr<AnnBehaviorScript> AnnScriptManager::getBehaviorScript(const std::string& scriptName, AnnGameObject* owner)
+const AnnScriptManager::ScriptClass& AnnScriptManager::getScriptClass(const std::string& scriptName)
 {
-	auto file { scriptName + scriptExtension };
+	const auto known = scriptClasses.find(scriptName);
+	if(known != std::end(scriptClasses)) return known->second;
 
-	try
+	//Evaluate the file containing the script class if unknown to ChaiScript yet
+	const auto file { scriptName + scriptExtension };
+	auto rawScript = scriptFileManager->getResourceByName(file).staticCast<AnnScriptFile>();
+	if(!rawScript)
 	{
-		//Evaluate the file containing the script class if unknown to ChaiScript yet
-
-		auto rawScript = scriptFileManager->getResourceByName(file).staticCast<AnnScriptFile>();
+		rawScript = scriptFileManager->load(file, AnnResourceManager::getDefaultResourceGroupName());
 		if(!rawScript)
-		{
-			rawScript = scriptFileManager->load(file, AnnResourceManager::getDefaultResourceGroupName());
-			if(!rawScript)
-				throw chaiscript::exception::file_not_found_error(file);
-		}
+			throw chaiscript::exception::file_not_found_error(file);
+	}
 
-		if(!rawScript->loadedInChaiscriptInterpretor())
-		{
-			AnnDebug() << "now loading " << file << " into the script manager";
-			rawScript->signalLoadedInChaiscript();
-			chai.eval(rawScript->getSourceCode());
-		}
+	if(!rawScript->loadedInChaiscriptInterpretor())
+	{
+		AnnDebug() << "now loading " << file << " into the script manager";
+		rawScript->signalLoadedInChaiscript();
+		chai.eval(rawScript->getSourceCode());
+	}
+
+	//Event methods are optional. Look at what this class defines instead of evaluating names that may not exist, and catching what is thrown
+	const auto state      = chai.get_state();
+	const auto& functions = state.engine_state.m_functions;
 
-		//Increment ID
-		ID++;
+	ScriptClass scriptClass;
+	//The class name is its constructor. Update is mandatory
+	scriptClass.constructor = chai.eval<std::function<chaiscript::Boxed_Value(std::string)>>(scriptName);
+	scriptClass.update		= chai.eval<std::function<void(chaiscript::Boxed_Value&)>>("update");
+	scriptClass.hooks		= std::make_tuple(
+		  getMethodIfDefined(chai, functions, scriptName, "KeyEvent", AnnKeyEvent()),
+		  getMethodIfDefined(chai, functions, scriptName, "MouseEvent", AnnMouseEvent()),
+		  getMethodIfDefined(chai, functions, scriptName, "ControllerEvent", AnnControllerEvent()),
+		  getMethodIfDefined(chai, functions, scriptName, "TimeEvent", AnnTimeEvent()),
+		  getMethodIfDefined(chai, functions, scriptName, "TriggerEvent", AnnTriggerEvent()),
+		  getMethodIfDefined(chai, functions, scriptName, "HandControllerEvent", AnnHandControllerEvent()),
+		  getMethodIfDefined(chai, functions, scriptName, "CollisionEvent", AnnCollisionEvent(nullptr, nullptr, {}, {})),
+		  getMethodIfDefined(chai, functions, scriptName, "PlayerCollisionEvent", AnnPlayerCollisionEvent(nullptr)));
+
+	AnnDebug() << "Compiled script class " << scriptName;
+	return scriptClasses.emplace(scriptName, std::move(scriptClass)).first->second;
+}
+
+std::shared_ptr<AnnBehaviorScript> AnnScriptManager::getBehaviorScript(const std::string& scriptName, AnnGameObject* owner)
+{
+	const auto file { scriptName + scriptExtension };
+
+	try
+	{
+		const auto& scriptClass = getScriptClass(scriptName);
 
 		//Get the name of the owner of this script, if relevant;
-		std::string ownerTag = owner ? owner->getName() : "";
-
-		//This may looks odd but it's good enough for what we're doing:
-		//Copy the template of the init code to a string
-		std::string ChaiCode { scriptTemplate };
-
-		//To "boot" the script, there's a little sniped of ChaiScript that is run from the C++ side. This code is generated from a string,
-		//And contains a few fixed tags to be replaced with the script name and an unique ID
-		ChaiCode.replace(ChaiCode.find(std::string(scriptNameMarker)), nameMarkerLen, scriptName);
-		ChaiCode.replace(ChaiCode.find(std::string(scriptNameMarker)), nameMarkerLen, scriptName);
-		ChaiCode.replace(ChaiCode.find(std::string(scriptObjectID)), scriptIDMarkerLen, std::to_string(ID));
-		ChaiCode.replace(ChaiCode.find(std::string(scriptObjectID)), scriptIDMarkerLen, std::to_string(ID));
-		ChaiCode.replace(ChaiCode.find(std::string(scriptObjectID)), scriptIDMarkerLen, std::to_string(ID));
-
-		//This is the ugly bit, this will try to see if the methods functions have been declared somewhere. Note that this doesn't tell if a script has a specific method implemented.
-		//It just permit to know if "a function" with that name exist. Script themselve will deal with knowing if they own theses functions, by attempting to call them, and setting flags
-		//if exception occurs.
-		tryAndGetEventHooks();
-
-		//This will add a global function in ChaiScript, that will create and return the script instance
-		chai.eval(ChaiCode);
-		//Get a way to call this function
-		auto creatorFunction = chai.eval<std::function<chaiscript::Boxed_Value(std::string)>>("create" + scriptName + std::to_string(ID));
-
-		//Now we need to get some hook to call the update on the file
-		return std::make_shared<AnnBehaviorScript>(
+		const std::string ownerTag = owner ? owner->getName() : "";
+
+		auto script = std::make_shared<AnnBehaviorScript>(
 			scriptName,
-			//Function to call to update the script. Update is mandatory
-			chai.eval<std::function<void(chaiscript::Boxed_Value&)>>("update"),
-
-			//Eventual event hooks
-			tie(
-				callKeyEventOnScriptInstance,
-				callMouseEventOnScriptInstance,
-				callStickEventOnScriptInstance,
-				callTimeEventOnScriptInstance,
-				callTriggerEventOnScriptInstance,
-				callHandControllertOnScriptInstance,
-				callCollisionEventOnScriptInstance,
-				callPlayerCollisionEventOnScriptInstance),
+			scriptClass.update,
+			scriptClass.hooks,
 			//This return the ScriptInstance, as a Boxed_Value. We're only interested at calling something on
 			//this object, so don't need to try to unbox it. It's literally a black box for us
-			creatorFunction(ownerTag));
+			scriptClass.constructor(ownerTag));
+		script->manager	= this;
+		script->ownerName = ownerTag;
+		return script;
 	}
 
 	catch(const chaiscript::exception::file_not_found_error& fnfe)
@@ -565,53 +553,41 @@ std::shared_ptr<AnnBehaviorScript> AnnScriptManager::getBehaviorScript(const std
 
 AnnBehaviorScript::AnnBehaviorScript() :
  valid(false),
- cannotKey(false),
- cannotMouse(false),
- cannotStick(false),
- cannotTime(false),
- cannotTrigger(false),
- cannotHand(false),
- cannotCollision { false },
- cannotPlayerCollision { false }
+ registered(false),
+ manager(nullptr),
+ profile(nullptr)
 {
 	AnnDebug() << "Invalid script object created";
 }
 
 AnnBehaviorScript::AnnBehaviorScript(const std::string& scriptName,
 									 std::function<void(chaiscript::Boxed_Value&)> updateHook,
-									 AnnBehaviorScriptHooks hooks,
+									 AnnBehaviorScriptHooks scriptHooks,
 									 chaiscript::Boxed_Value scriptObjectInstance) :
- constructListener(),
  valid { true },
  name { scriptName },
  ScriptObjectInstance { scriptObjectInstance },
  callUpdateOnScriptInstance { updateHook },
- callKeyEventOnScriptInstance { std::get<KeyHook>(hooks) },
- callMouseEventOnScriptInstance { std::get<MouseHook>(hooks) },
- callStickEventOnScriptInstance { std::get<ControllerHook>(hooks) },
- callTimeEventOnScriptInstance { std::get<TimeHook>(hooks) },
- callTriggerEventOnScriptInstance { std::get<TriggerHook>(hooks) },
- callHandControllertOnScriptInstance { std::get<HandHook>(hooks) },
- callCollisionEventOnScriptInstance { std::get<CollisionHook>(hooks) },
- callPlayerCollisionEventOnScriptInstance { std::get<PlayerCollisionHook>(hooks) },
- cannotKey { false },
- cannotMouse { false },
- cannotStick { false },
- cannotTime { false },
- cannotTrigger { false },
- cannotHand { false },
- cannotCollision { false },
- cannotPlayerCollision { false }
+ hooks { std::move(scriptHooks) },
+ registered { false },
+ manager { nullptr },
+ profile { nullptr }
 {
 }
 
 AnnBehaviorScript::~AnnBehaviorScript()
 {
 	AnnDebug() << "Destructing " << name << "Script";
+	if(registered)
+		if(const auto scriptManager = AnnGetScriptManager())
+			scriptManager->unregisterBehaviorScript(this);
 }
 
 void AnnBehaviorScript::update()
 {
+	const auto profileEntry = getProfileEntry(HookCount);
+	const auto start		= profileEntry ? profilerClock::now() : profilerClock::time_point {};
+
 	try
 	{
 		callUpdateOnScript();
@@ -624,6 +600,15 @@ void AnnBehaviorScript::update()
 				   << ee.pretty_print();
 		//will not crash here.
 	}
+
+	if(profileEntry) profileEntry->add(millisecondsSince(start));
+}
+
+AnnScriptProfileEntry* AnnBehaviorScript::getProfileEntry(size_t hook)
+{
+	if(!manager || !manager->profiling) return nullptr;
+	if(!profile) profile = &manager->getProfile(name, ownerName);
+	return hook == HookCount ? &profile->update : &profile->hooks[hook];
 }
 
 bool AnnBehaviorScript::isValid() const
@@ -633,149 +618,285 @@ bool AnnBehaviorScript::isValid() const
 
 void AnnBehaviorScript::registerAsListener()
 {
-	AnnGetEventManager()->addListener(getSharedListener());
+	if(registered || !valid) return;
+	AnnGetScriptManager()->registerBehaviorScript(this);
+	registered = true;
 }
 
 void AnnBehaviorScript::unregisterAsListener()
 {
+	if(!registered) return;
 	AnnDebug() << "Unregistering ourself has event listener";
-	AnnGetEventManager()->removeListener(getSharedListener());
+	if(const auto scriptManager = AnnGetScriptManager())
+		scriptManager->unregisterBehaviorScript(this);
+	registered = false;
 }
 
-void AnnBehaviorScript::KeyEvent(AnnKeyEvent e)
+template <size_t Hook, class Event>
+void AnnBehaviorScript::callHook(const Event& e)
 {
+	const auto& hook = std::get<Hook>(hooks);
+	if(!hook) return;
+
+	const auto profileEntry = getProfileEntry(Hook);
+	const auto start		= profileEntry ? profilerClock::now() : profilerClock::time_point {};
+
 	try
 	{
-		if(callKeyEventOnScriptInstance && !cannotKey)
-			callKeyEventOnScriptInstance(ScriptObjectInstance, e);
+		hook(ScriptObjectInstance, e);
+		if(profileEntry) profileEntry->add(millisecondsSince(start));
 	}
-	catch(const chaiscript::exception::dispatch_error&)
+	catch(const chaiscript::exception::dispatch_error& de)
 	{
-		cannotKey = true;
+		AnnDebug(Log::Important) << "Event script error " << de.what();
+		if(profileEntry) profileEntry->add(millisecondsSince(start));
 	}
 	catch(const chaiscript::exception::eval_error& ee)
 	{
 		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
+		if(profileEntry) profileEntry->add(millisecondsSince(start));
 	}
 }
 
-void AnnBehaviorScript::MouseEvent(AnnMouseEvent e)
+AnnBehaviorScriptDispatcher::AnnBehaviorScriptDispatcher() :
+ constructListener(),
+ scriptCount(0),
+ dispatching(false),
+ needCompaction(false)
 {
-	try
-	{
-		if(callMouseEventOnScriptInstance && !cannotMouse)
-			callMouseEventOnScriptInstance(ScriptObjectInstance, e);
-	}
-	catch(const chaiscript::exception::dispatch_error&)
-	{
-		cannotMouse = true;
-	}
-	catch(const chaiscript::exception::eval_error& ee)
-	{
-		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
-	}
 }
 
-void AnnBehaviorScript::ControllerEvent(AnnControllerEvent e)
+void AnnBehaviorScriptDispatcher::add(AnnBehaviorScript* script)
 {
-	try
-	{
-		if(callStickEventOnScriptInstance && !cannotStick)
-			callStickEventOnScriptInstance(ScriptObjectInstance, e);
-	}
-	catch(const chaiscript::exception::dispatch_error&)
-	{
-		cannotStick = true;
-	}
-	catch(const chaiscript::exception::eval_error& ee)
-	{
-		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
-	}
+	++scriptCount;
+
+	//Tables are built from the hooks of the class, events the script can't handle never reach it
+	const auto addIfImplemented = [&](size_t hook, bool implemented) {
+		if(implemented) tables[hook].push_back(script);
+	};
+	addIfImplemented(KeyHook, bool(std::get<KeyHook>(script->hooks)));
+	addIfImplemented(MouseHook, bool(std::get<MouseHook>(script->hooks)));
+	addIfImplemented(ControllerHook, bool(std::get<ControllerHook>(script->hooks)));
+	addIfImplemented(TimeHook, bool(std::get<TimeHook>(script->hooks)));
+	addIfImplemented(TriggerHook, bool(std::get<TriggerHook>(script->hooks)));
+	addIfImplemented(HandHook, bool(std::get<HandHook>(script->hooks)));
+	addIfImplemented(CollisionHook, bool(std::get<CollisionHook>(script->hooks)));
+	addIfImplemented(PlayerCollisionHook, bool(std::get<PlayerCollisionHook>(script->hooks)));
 }
 
-void AnnBehaviorScript::TimeEvent(AnnTimeEvent e)
+void AnnBehaviorScriptDispatcher::remove(AnnBehaviorScript* script)
 {
-	try
-	{
-		if(callTimeEventOnScriptInstance && !cannotTime)
-			callTimeEventOnScriptInstance(ScriptObjectInstance, e);
-	}
-	catch(const chaiscript::exception::dispatch_error&)
-	{
-		cannotTime = true;
-	}
-	catch(const chaiscript::exception::eval_error& ee)
+	--scriptCount;
+
+	for(auto& table : tables)
 	{
-		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
+		const auto entry = std::find(std::begin(table), std::end(table), script);
+		if(entry == std::end(table)) continue;
+
+		//Don't move the entries under the loop that is dispatching
+		if(dispatching)
+		{
+			*entry		   = nullptr;
+			needCompaction = true;
+		}
+		else
+		{
+			*entry = table.back();
+			table.pop_back();
+		}
 	}
 }
 
-void AnnBehaviorScript::TriggerEvent(AnnTriggerEvent e)
+bool AnnBehaviorScriptDispatcher::empty() const
 {
-	try
-	{
-		if(callTriggerEventOnScriptInstance && !cannotTrigger)
-			callTriggerEventOnScriptInstance(ScriptObjectInstance, e);
-	}
-	catch(const chaiscript::exception::dispatch_error&)
-	{
-		cannotTrigger = true;
-	}
-	catch(const chaiscript::exception::eval_error& ee)
-	{
-		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
-	}
+	return scriptCount == 0;
 }
 
-void AnnBehaviorScript::HandControllerEvent(AnnHandControllerEvent e)
+size_t AnnBehaviorScriptDispatcher::getScriptCount(size_t hook) const
 {
-	try
-	{
-		if(callHandControllertOnScriptInstance && !cannotHand)
-			callHandControllertOnScriptInstance(ScriptObjectInstance, e);
-	}
-	catch(const chaiscript::exception::dispatch_error&)
-	{
-		cannotHand = true;
-	}
-	catch(const chaiscript::exception::eval_error& ee)
-	{
-		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
-	}
+	const auto& table = tables[hook];
+	return size_t(std::count_if(std::begin(table), std::end(table), [](AnnBehaviorScript* script) { return script != nullptr; }));
 }
 
-void AnnBehaviorScript::CollisionEvent(AnnCollisionEvent e)
+template <size_t Hook, class Event>
+void AnnBehaviorScriptDispatcher::dispatch(const Event& e)
 {
-	try
-	{
-		if(callCollisionEventOnScriptInstance && !cannotCollision)
-			callCollisionEventOnScriptInstance(ScriptObjectInstance, e);
-	}
-	catch(const chaiscript::exception::dispatch_error&)
-	{
-		cannotCollision = true;
-	}
-	catch(const chaiscript::exception::eval_error& ee)
-	{
-		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
-	}
+	auto& table = tables[Hook];
+	if(table.empty()) return;
+
+	//A hook can create or destroy scripts. New ones are at the end of the table and wait for the next event
+	const auto wasDispatching = dispatching;
+	dispatching				  = true;
+	const auto count		  = table.size();
+	for(size_t i { 0 }; i < count; ++i)
+		if(const auto script = table[i]) script->callHook<Hook>(e);
+	dispatching = wasDispatching;
+
+	if(dispatching || !needCompaction) return;
+	for(auto& compacted : tables)
+		compacted.erase(std::remove(std::begin(compacted), std::end(compacted), nullptr), std::end(compacted));
+	needCompaction = false;
 }
-void AnnBehaviorScript::PlayerCollisionEvent(AnnPlayerCollisionEvent e)
+
+void AnnBehaviorScriptDispatcher::KeyEvent(AnnKeyEvent e)
 {
-	//AnnDebug() << "player collision on script...";
-	try
+	dispatch<KeyHook>(e);
+}
+
+void AnnBehaviorScriptDispatcher::MouseEvent(AnnMouseEvent e)
+{
+	dispatch<MouseHook>(e);
+}
+
+void AnnBehaviorScriptDispatcher::ControllerEvent(AnnControllerEvent e)
+{
+	dispatch<ControllerHook>(e);
+}
+
+void AnnBehaviorScriptDispatcher::TimeEvent(AnnTimeEvent e)
+{
+	dispatch<TimeHook>(e);
+}
+
+void AnnBehaviorScriptDispatcher::TriggerEvent(AnnTriggerEvent e)
+{
+	dispatch<TriggerHook>(e);
+}
+
+void AnnBehaviorScriptDispatcher::HandControllerEvent(AnnHandControllerEvent e)
+{
+	dispatch<HandHook>(e);
+}
+
+void AnnBehaviorScriptDispatcher::CollisionEvent(AnnCollisionEvent e)
+{
+	dispatch<CollisionHook>(e);
+}
+
+void AnnBehaviorScriptDispatcher::PlayerCollisionEvent(AnnPlayerCollisionEvent e)
+{
+	dispatch<PlayerCollisionHook>(e);
+}
+
+void AnnScriptManager::registerBehaviorScript(AnnBehaviorScript* script)
+{
+	if(dispatcher->empty())
+		AnnGetEventManager()->addListener(dispatcher);
+	dispatcher->add(script);
+}
+
+void AnnScriptManager::unregisterBehaviorScript(AnnBehaviorScript* script)
+{
+	dispatcher->remove(script);
+	if(dispatcher->empty())
+		if(const auto eventManager = AnnGetEventManager())
+			eventManager->removeListener(dispatcher);
+}
+
+void AnnScriptProfileEntry::add(double milliseconds)
+{
+	++calls;
+	totalMilliseconds += milliseconds;
+	maxMilliseconds = std::max(maxMilliseconds, milliseconds);
+}
+
+void AnnScriptProfileEntry::merge(const AnnScriptProfileEntry& other)
+{
+	calls += other.calls;
+	totalMilliseconds += other.totalMilliseconds;
+	maxMilliseconds = std::max(maxMilliseconds, other.maxMilliseconds);
+}
+
+AnnScriptProfile& AnnScriptManager::getProfile(const std::string& scriptName, const std::string& owner)
+{
+	return profiles[scriptName][owner];
+}
+
+void AnnScriptManager::setProfilingEnabled(bool state)
+{
+	profiling = state;
+	AnnDebug() << "Script profiler " << (profiling ? "enabled" : "disabled");
+}
+
+bool AnnScriptManager::isProfilingEnabled() const
+{
+	return profiling;
+}
+
+void AnnScriptManager::resetProfile()
+{
+	for(auto& scriptProfiles : profiles)
+		for(auto& ownerProfile : scriptProfiles.second)
+			ownerProfile.second = {};
+}
+
+std::vector<std::string> AnnScriptManager::getProfileReport(size_t maxLines) const
+{
+	struct reportLine
 	{
-		if(callPlayerCollisionEventOnScriptInstance && !cannotPlayerCollision)
-			callPlayerCollisionEventOnScriptInstance(ScriptObjectInstance, e);
-	}
-	catch(const chaiscript::exception::dispatch_error&)
+		std::string scriptName;
+		size_t hook;
+		AnnScriptProfileEntry entry;
+	};
+
+	//Sum the game objects of each class
+	std::vector<reportLine> lines;
+	for(const auto& scriptProfiles : profiles)
+		for(size_t hook { 0 }; hook <= HookCount; ++hook)
+		{
+			reportLine line { scriptProfiles.first, hook, {} };
+			for(const auto& ownerProfile : scriptProfiles.second)
+				line.entry.merge(profileEntry(ownerProfile.second, hook));
+			if(line.entry.calls > 0) lines.push_back(std::move(line));
+		}
+
+	std::sort(std::begin(lines), std::end(lines), [](const reportLine& a, const reportLine& b) {
+		return a.entry.totalMilliseconds > b.entry.totalMilliseconds;
+	});
+	if(lines.size() > maxLines) lines.resize(maxLines);
+
+	std::vector<std::string> report;
+	for(const auto& line : lines)
 	{
-		cannotPlayerCollision = true;
+		std::stringstream text;
+		text.precision(3);
+		text << std::fixed << line.scriptName << "::" << hookNames[line.hook]
+			 << " calls: " << line.entry.calls
+			 << " total: " << line.entry.totalMilliseconds << "ms"
+			 << " avg: " << line.entry.totalMilliseconds / double(line.entry.calls) << "ms"
+			 << " max: " << line.entry.maxMilliseconds << "ms";
+		report.push_back(text.str());
 	}
-	catch(const chaiscript::exception::eval_error& ee)
+	return report;
+}
+
+bool AnnScriptManager::dumpProfile(const std::string& path) const
+{
+	std::ofstream dump(path);
+	if(!dump)
 	{
-		AnnDebug(Log::Important) << "Event script error " << ee.pretty_print();
+		AnnDebug(Log::Important) << "Cannot write script profile to " << path;
+		return false;
 	}
+
+	dump << "script,owner,hook,calls,total_ms,average_ms,max_ms\n";
+	for(const auto& scriptProfiles : profiles)
+		for(const auto& ownerProfile : scriptProfiles.second)
+			for(size_t hook { 0 }; hook <= HookCount; ++hook)
+			{
+				const auto& entry = profileEntry(ownerProfile.second, hook);
+				if(entry.calls == 0) continue;
+				dump << scriptProfiles.first << ','
+					 << ownerProfile.first << ','
+					 << hookNames[hook] << ','
+					 << entry.calls << ','
+					 << entry.totalMilliseconds << ','
+					 << entry.totalMilliseconds / double(entry.calls) << ','
+					 << entry.maxMilliseconds << '\n';
+			}
+
+	AnnDebug() << "Script profile written to " << path;
+	return bool(dump);
 }
 
 void AnnScriptManager::evalString(const std::string& chaiCode)
@@ -38,3 +38,43 @@ std::string AnnStringUility::getRandomString(size_t length)
 
 	return output;
 }
+
+AnnStringID AnnStringUility::intern(const std::string& string)
+{
+	if(const auto id = find(string); id != AnnInvalidStringID)
+		return id;
+
+	std::unique_lock<std::shared_mutex> lock(internMutex);
+
+	//Another thread may have interned it between the two locks
+	const auto insertion = internedIDs.emplace(string, AnnStringID(internedStrings.size() + 1));
+	if(insertion.second)
+		internedStrings.push_back(string);
+
+	return insertion.first->second;
+}
+
+AnnStringID AnnStringUility::find(const std::string& string) const
+{
+	std::shared_lock<std::shared_mutex> lock(internMutex);
+	const auto result = internedIDs.find(string);
+	if(result != std::end(internedIDs))
+		return result->second;
+	return AnnInvalidStringID;
+}
+
+const std::string& AnnStringUility::getString(AnnStringID id) const
+{
+	static const std::string empty;
+
+	std::shared_lock<std::shared_mutex> lock(internMutex);
+	if(id == AnnInvalidStringID || id > internedStrings.size())
+		return empty;
+	return internedStrings[id - 1];
+}
+
+size_t AnnStringUility::getInternedCount() const
+{
+	std::shared_lock<std::shared_mutex> lock(internMutex);
+	return internedStrings.size();
+}
@@ -3,12 +3,18 @@
 
 #include "AnnSubsystem.hpp"
 #include "AnnLogger.hpp"
+#include "AnnEngine.hpp"
 
 using namespace Annwvyn;
 
 AnnSubSystem::AnnSubSystem(const std::string& systemName) :
- name(systemName)
+ name(systemName),
+ nameID(AnnInvalidStringID)
 {
+	//Subsystems are created after the string utility, but don't crash if one is made outside of an engine
+	if(const auto engine = AnnEngine::Instance(); engine && engine->getStringUtility())
+		nameID = engine->getStringUtility()->intern(name);
+
 	AnnDebug(Log::Important) << "*-*-*-* Starting " << name << " SubSystem";
 }
 
@@ -17,6 +23,11 @@ AnnSubSystem::~AnnSubSystem()
 	AnnDebug(Log::Important) << "*-*-*-* Stopping " << name << " SubSystem";
 }
 
+AnnStringID AnnSubSystem::getNameID() const
+{
+	return nameID;
+}
+
 bool AnnSubSystem::needUpdate()
 {
 	return true;
@@ -0,0 +1,138 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+#include "AnnTaskManager.hpp"
+#include "AnnLogger.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace Annwvyn;
+
+AnnTaskManager::AnnTaskManager(size_t workerCount) :
+ AnnSubSystem("TaskManager"),
+ stopping(false),
+ pendingWorkerTasks(0),
+ mainThreadBudget(2),
+ mainThreadId(std::this_thread::get_id())
+{
+	//Keep one hardware thread for the frame loop
+	if(workerCount == 0)
+		workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	workerCount = std::max<size_t>(1, workerCount);
+
+	AnnDebug() << "Starting " << workerCount << " worker threads";
+	workers.reserve(workerCount);
+	for(size_t i { 0 }; i < workerCount; ++i)
+		workers.emplace_back([this] { workerLoop(); });
+}
+
+AnnTaskManager::~AnnTaskManager()
+{
+	{
+		std::lock_guard<std::mutex> lock(workerMutex);
+		stopping = true;
+		workerQueue.clear();
+	}
+
+	workerCondition.notify_all();
+	for(auto& worker : workers)
+		if(worker.joinable()) worker.join();
+}
+
+void AnnTaskManager::pushWorkerTask(Task task)
+{
+	{
+		std::lock_guard<std::mutex> lock(workerMutex);
+		workerQueue.push_back(std::move(task));
+		++pendingWorkerTasks;
+	}
+	workerCondition.notify_one();
+}
+
+void AnnTaskManager::workerLoop()
+{
+	for(;;)
+	{
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(workerMutex);
+			workerCondition.wait(lock, [this] { return stopping || !workerQueue.empty(); });
+			if(stopping) return;
+			task = std::move(workerQueue.front());
+			workerQueue.pop_front();
+		}
+
+		//Tasks given by submit() are packaged, exceptions end up in their future
+		task();
+		--pendingWorkerTasks;
+	}
+}
+
+void AnnTaskManager::runOnMainThread(Task work)
+{
+	std::lock_guard<std::mutex> lock(mainThreadMutex);
+	mainThreadQueue.push_back(std::move(work));
+}
+
+bool AnnTaskManager::needUpdate()
+{
+	std::lock_guard<std::mutex> lock(mainThreadMutex);
+	return !mainThreadQueue.empty();
+}
+
+void AnnTaskManager::update()
+{
+	using clock		= std::chrono::steady_clock;
+	const auto start = clock::now();
+	const auto budget = std::chrono::duration<double, std::milli>(mainThreadBudget);
+
+	//Always do at least one task, or nothing will ever progress with a too small budget
+	while(runMainThreadTask() && clock::now() - start < budget)
+		;
+}
+
+bool AnnTaskManager::runMainThreadTask()
+{
+	Task task;
+	{
+		std::lock_guard<std::mutex> lock(mainThreadMutex);
+		if(mainThreadQueue.empty()) return false;
+		task = std::move(mainThreadQueue.front());
+		mainThreadQueue.pop_front();
+	}
+
+	task();
+	return true;
+}
+
+void AnnTaskManager::setMainThreadBudget(double milliseconds)
+{
+	mainThreadBudget = std::max(0.0, milliseconds);
+}
+
+double AnnTaskManager::getMainThreadBudget() const
+{
+	return mainThreadBudget;
+}
+
+size_t AnnTaskManager::getWorkerCount() const
+{
+	return workers.size();
+}
+
+size_t AnnTaskManager::getPendingWorkerTaskCount() const
+{
+	return pendingWorkerTasks;
+}
+
+size_t AnnTaskManager::getPendingMainThreadTaskCount() const
+{
+	std::lock_guard<std::mutex> lock(mainThreadMutex);
+	return mainThreadQueue.size();
+}
+
+bool AnnTaskManager::isMainThread() const
+{
+	return std::this_thread::get_id() == mainThreadId;
+}
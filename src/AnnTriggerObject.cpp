@@ -20,6 +20,7 @@ btCollisionShape* AnnTriggerObjectShapeGenerator::sphere(const float& r)
 
 AnnTriggerObject::AnnTriggerObject(const std::string& name) :
  name(name),
+ nameID(AnnInvalidStringID),
  contactWithPlayer(false),
  lastFrameContactWithPlayer(false),
  body(nullptr),
@@ -32,6 +33,11 @@ std::string AnnTriggerObject::getName() const
 	return name;
 }
 
+AnnStringID AnnTriggerObject::getNameID() const
+{
+	return nameID;
+}
+
 AnnTriggerObject::~AnnTriggerObject()
 {
 	AnnDebug() << "AnnTriggerObject destructor called";
@@ -0,0 +1,153 @@
+#include "engineBootstrap.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace Annwvyn
+{
+	//Play a sound on the left of the listener and render it in memory. The sound can be played while a worker is still decoding it
+	inline std::vector<int16_t> renderTestSound(size_t frameCount, bool preloading = false)
+	{
+		AnnAudioEngine::setLoopbackRendering(48000);
+		auto GameEngine = bootstrapEmptyEngine("TestAudioLoopback");
+		AnnAudioEngine::setLoopbackRendering(0);
+
+		auto audioEngine = AnnGetAudioEngine();
+		REQUIRE(audioEngine->isLoopback());
+		REQUIRE(audioEngine->getLoopbackSampleRate() == 48000);
+
+		size_t readyCalls { 0 };
+		AnnAudioPreloadProgressPtr progress;
+		if(preloading)
+			progress = audioEngine->preLoadBufferAsync("monster.wav", [&](const std::string&, ALuint buffer) {
+				REQUIRE(buffer == audioEngine->isBufferLoader("monster.wav"));
+				++readyCalls;
+			});
+
+		auto source = audioEngine->createSource("monster.wav");
+		REQUIRE(audioEngine->getBufferCacheStats().bufferCount == 1);
+		source->setPositon(AnnGetPlayer()->getPosition() + AnnVect3 { -2, 0, 0 });
+		source->play();
+		REQUIRE(source->isPlaying());
+		REQUIRE_FALSE(source->isVirtual());
+
+		audioEngine->renderLoopback(frameCount);
+		REQUIRE(audioEngine->getRenderedFrameCount() == frameCount);
+		auto samples = audioEngine->takeLoopbackSamples();
+
+		//The preload is finished once, by the source or by the main thread
+		if(preloading)
+		{
+			for(auto i { 0 }; i < 5; ++i) GameEngine->refresh();
+			REQUIRE(progress->isFinished());
+			REQUIRE(progress->getLoadedCount() == 1);
+			REQUIRE(readyCalls == 1);
+			REQUIRE(audioEngine->getBufferCacheStats().bufferCount == 1);
+		}
+
+		return samples;
+	}
+
+	TEST_CASE("Audio loopback rendering")
+	{
+		const size_t frameCount = 4800;
+		const auto samples		= renderTestSound(frameCount);
+		REQUIRE(samples.size() == 2 * frameCount);
+
+		//Something was mixed, louder in the left channel
+		double left = 0, right = 0;
+		for(size_t i { 0 }; i < samples.size(); i += 2)
+		{
+			left += std::abs(samples[i]);
+			right += std::abs(samples[i + 1]);
+		}
+		REQUIRE(left > 0);
+		REQUIRE(left > right);
+	}
+
+	TEST_CASE("Audio loopback rendering is deterministic")
+	{
+		const auto first  = renderTestSound(4800);
+		const auto second = renderTestSound(4800);
+		REQUIRE(first == second);
+	}
+
+	TEST_CASE("Audio buffer loaded while it is preloaded")
+	{
+		REQUIRE(renderTestSound(4800, true) == renderTestSound(4800));
+	}
+
+	TEST_CASE("Audio stream plays a file queued with another sample-rate")
+	{
+		//Half a second of a flat sound, that can't be queued on the same source as the other one
+		for(const auto sampleRate : { 44100u, 48000u })
+		{
+			std::ofstream file("StreamTest" + std::to_string(sampleRate) + AnnCookedAudioHeader::extension, std::ios::binary);
+			REQUIRE(AnnCookedAudioHeader::write(file, 1, sampleRate, std::vector<int16_t>(sampleRate / 2, 8000)));
+		}
+
+		AnnAudioEngine::setLoopbackRendering(48000);
+		auto GameEngine = bootstrapEmptyEngine("TestAudioStream");
+		AnnAudioEngine::setLoopbackRendering(0);
+
+		auto ResourceManager = AnnGetResourceManager();
+		ResourceManager->addFileLocation(".", "StreamTestGroup");
+		ResourceManager->initResources();
+
+		auto audioEngine = AnnGetAudioEngine();
+		auto stream		 = audioEngine->createStream();
+		stream->play("StreamTest44100.annpcm");
+		stream->queueNext("StreamTest48000.annpcm");
+		REQUIRE(stream->isPlaying());
+
+		//The streaming thread refills the source in real time, render at the same pace
+		const size_t chunkFrames { 480 }, chunkCount { 150 };
+		for(size_t i { 0 }; i < chunkCount; ++i)
+		{
+			audioEngine->renderLoopback(chunkFrames);
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		const auto samples = audioEngine->takeLoopbackSamples();
+		REQUIRE(samples.size() == 2 * chunkFrames * chunkCount);
+
+		//The first file is over, the second one plays instead of being rejected by OpenAL
+		const auto secondFile = std::begin(samples) + 2 * 48000 * 3 / 4;
+		REQUIRE(std::any_of(secondFile, secondFile + 2 * 4800, [](int16_t sample) { return sample != 0; }));
+	}
+
+	TEST_CASE("Audio buffer cache budget")
+	{
+		auto GameEngine  = bootstrapEmptyEngine("TestAudioBufferCache");
+		auto audioEngine = AnnGetAudioEngine();
+
+		//Smaller than any sound, a buffer that was just loaded is still given to its source
+		audioEngine->setBufferCacheBudget(1);
+		auto source = audioEngine->createSource("monster.wav");
+		REQUIRE(audioEngine->isBufferLoader("monster.wav"));
+		REQUIRE(audioEngine->getBufferCacheStats().bufferCount == 1);
+		source->play();
+		REQUIRE(source->isPlaying());
+
+		//Unloading waits for the source to let go of it
+		audioEngine->unloadBuffer("monster.wav");
+		REQUIRE(audioEngine->isBufferLoader("monster.wav"));
+
+		audioEngine->removeSource(source);
+		source.reset();
+		REQUIRE_FALSE(audioEngine->isBufferLoader("monster.wav"));
+		REQUIRE(audioEngine->getBufferCacheStats().residentBytes == 0);
+	}
+
+	TEST_CASE("Cooked audio header validation")
+	{
+		const auto size = sizeof(AnnCookedAudioHeader) + 20 * 2 * sizeof(int16_t);
+		REQUIRE(AnnCookedAudioHeader::make(2, 48000, 20).isValid(size));
+		REQUIRE_FALSE(AnnCookedAudioHeader::make(2, 48000, 21).isValid(size));
+
+		//A frame count that overflows the size computation must not pass
+		REQUIRE_FALSE(AnnCookedAudioHeader::make(2, 48000, uint64_t(1) << 62).isValid(size));
+		REQUIRE_FALSE(AnnCookedAudioHeader::make(0, 48000, 0).isValid(size));
+	}
+}
@@ -0,0 +1,146 @@
+#include <engineBootstrap.hpp>
+#include <AnnCompiledLevel.hpp>
+#include <AnnLevelCompiler.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace Annwvyn
+{
+	//Compile a JSON level with the AnnLevelCompiler code, return the content of the file
+	inline std::string compileTestLevel(const std::string& path, const std::string& jsonLevel)
+	{
+		std::stringstream file(std::ios::in | std::ios::out | std::ios::binary);
+		auto compiled = AnnLevelCompiler::compile(AnnLevelCompiler::json_t::parse(jsonLevel));
+		compiled.write(file);
+
+		const auto data = file.str();
+		std::ofstream(path, std::ios::binary).write(data.data(), std::streamsize(data.size()));
+		return data;
+	}
+
+	const char* const compiledTestLevel = R"JSON(
+{
+	"name":"CompiledTestLevel",
+	"resources": [{
+		"group":"TestLevel",
+		"path":"./TestLevel.zip",
+		"type":"Zip"
+	}],
+	"player":{
+		"startPosition":[0.0, 0.0, 10.0],
+		"startOrientation":[0.0, 0.0, 0.0, 1.0]
+	},
+	"content" : [{
+		"name":"CompiledSinbad",
+		"mesh":"Sinbad.mesh",
+		"position":[0.0, 1.0, 0.0],
+		"orientation":[0.0, 0.0, 0.0, 1.0],
+		"scale":[0.5, 0.5, 0.5],
+		"hasPhysics":true,
+		"physics" : {
+			"shape":"box",
+			"mass":120.0,
+			"playerColide":true
+		},
+		"scripts":null
+	},
+	{
+		"name":"CompiledPenguin",
+		"mesh":"penguin.mesh",
+		"position":[3,1.5,0],
+		"orientation":[0,0,0,1],
+		"scale":[0.1,0.1,0.1],
+		"hasPhysics":false,
+		"scripts":["penguinMove"]
+	}],
+	"lighting":[{
+		"name":"CompiledSun",
+		"type":"directional",
+		"power":97,
+		"direction":[-1.0, -1.5, -1.0]
+	}]
+}
+)JSON";
+
+	TEST_CASE("Compiled level file format")
+	{
+		const std::string path { "CompiledTestLevel.annlvl" };
+		const auto data = compileTestLevel(path, compiledTestLevel);
+
+		//Everything the compiler writes passes the checks
+		AnnMappedFile file;
+		REQUIRE(file.open(path));
+		const auto header = AnnCompiledLevelHeader::find(file.getData(), file.getSize());
+		REQUIRE(header);
+		REQUIRE(header->getString(header->name) == "CompiledTestLevel");
+		REQUIRE(header->resourceCount == 1);
+		REQUIRE(header->objectCount == 2);
+		REQUIRE(header->lightCount == 1);
+		REQUIRE(header->scriptCount == 1);
+
+		const auto& sinbad = header->getObjects()[0];
+		REQUIRE(header->getString(sinbad.mesh) == "Sinbad.mesh");
+		REQUIRE(sinbad.hasPhysics);
+		REQUIRE(sinbad.shape == AnnCompiledLevelObject::BoxShape);
+		REQUIRE(sinbad.mass == 120);
+		REQUIRE(sinbad.scriptCount == 0);
+
+		const auto& penguin = header->getObjects()[1];
+		REQUIRE_FALSE(penguin.hasPhysics);
+		REQUIRE(penguin.scriptCount == 1);
+		REQUIRE(header->getString(header->getScripts()[penguin.firstScript]) == "penguinMove");
+		REQUIRE(header->getLights()[0].hasDirection);
+		REQUIRE_FALSE(header->getLights()[0].hasPosition);
+		file.close();
+
+		//Truncated, or with an index out of the string table
+		std::ofstream("TruncatedLevel.annlvl", std::ios::binary).write(data.data(), std::streamsize(data.size() - 1));
+		REQUIRE(file.open("TruncatedLevel.annlvl"));
+		REQUIRE_FALSE(AnnCompiledLevelHeader::find(file.getData(), file.getSize()));
+		file.close();
+
+		auto corrupted = data;
+		AnnCompiledLevelHeader corruptedHeader;
+		std::copy_n(corrupted.data(), sizeof corruptedHeader, reinterpret_cast<char*>(&corruptedHeader));
+		corruptedHeader.name = corruptedHeader.stringCount;
+		std::copy_n(reinterpret_cast<const char*>(&corruptedHeader), sizeof corruptedHeader, corrupted.begin());
+		std::ofstream("CorruptedLevel.annlvl", std::ios::binary).write(corrupted.data(), std::streamsize(corrupted.size()));
+		REQUIRE(file.open("CorruptedLevel.annlvl"));
+		REQUIRE_FALSE(AnnCompiledLevelHeader::find(file.getData(), file.getSize()));
+
+		//Invalid JSON levels are not compiled
+		REQUIRE_THROWS_AS(AnnLevelCompiler::compile(AnnLevelCompiler::json_t::parse(R"JSON({ "name":"NoPlayer" })JSON")), AnnLevelCompiler::LevelError);
+	}
+
+	TEST_CASE("Loading of compiled level")
+	{
+		auto GameEngine = bootstrapEmptyEngine("CompiledLevel");
+
+		const std::string path { "CompiledTestLevel.annlvl" };
+		compileTestLevel(path, compiledTestLevel);
+		REQUIRE_THROWS_AS(AnnCompiledLevel("MissingLevel.annlvl"), AnnInitializationError);
+
+		auto levelManager = AnnGetLevelManager();
+		auto level		  = std::make_shared<AnnCompiledLevel>(path);
+		levelManager->addLevel(level);
+		levelManager->switchToLevel(level);
+
+		for(auto i { 0 }; i < 60; ++i)
+			GameEngine->refresh();
+
+		REQUIRE(levelManager->getCurrentLevel() == level);
+		REQUIRE(level->getContent().size() == 2);
+		REQUIRE(level->getLights().size() == 1);
+
+		const auto sinbad = AnnGetGameObjectManager()->getGameObject("CompiledSinbad");
+		REQUIRE(sinbad);
+		REQUIRE(sinbad->getBody());
+		REQUIRE(sinbad->getScale() == AnnVect3(0.5f, 0.5f, 0.5f));
+
+		const auto penguin = AnnGetGameObjectManager()->getGameObject("CompiledPenguin");
+		REQUIRE(penguin);
+		REQUIRE_FALSE(penguin->getBody());
+	}
+}
@@ -168,4 +168,40 @@ namespace Annwvyn
 		REQUIRE(counter == refCounter);
 		REQUIRE(counter == nbFrames);
 	}
+
+	TEST_CASE("Test resource group background loading event")
+	{
+		class ResourceLoadTest : LISTENER
+		{
+		public:
+			ResourceLoadTest(bool& finished) :
+			 constructListener(),
+			 finished(finished) {}
+
+			void ResourceLoadEvent(AnnResourceLoadEvent e) override
+			{
+				REQUIRE(e.getLoadedCount() <= e.getTotalCount());
+				if(e.getGroup() == AnnResourceManager::getReservedResourceGroupName() && e.isFinished())
+					finished = true;
+			}
+
+		private:
+			bool& finished;
+		};
+
+		auto GameEngine = bootstrapTestEngine("TestResourceLoadEvent");
+
+		auto finished{ false };
+		auto resourceListener = std::make_shared<ResourceLoadTest>(finished);
+		AnnGetEventManager()->addListener(resourceListener);
+
+		//The group is loaded while frames are rendered
+		auto future = AnnGetResourceManager()->loadGroupAsync(AnnResourceManager::getReservedResourceGroupName());
+		for(auto i = 0; i < 6000 && !finished; ++i)
+			GameEngine->refresh();
+
+		REQUIRE(finished);
+		REQUIRE(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+		REQUIRE_FALSE(AnnGetResourceManager()->isGroupLoading(AnnResourceManager::getReservedResourceGroupName()));
+	}
 }
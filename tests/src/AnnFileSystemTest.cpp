@@ -1,5 +1,6 @@
 
 #include "engineBootstrap.hpp"
+#include <fstream>
 
 namespace Annwvyn
 {
@@ -65,4 +66,163 @@ namespace Annwvyn
 			AnnGetFileSystemManager()->releaseSaveFileDataObject(fileData);
 		}
 	}
+
+	TEST_CASE("FileSystem typed values in binary and text save files")
+	{
+		auto GameEngine = bootstrapTestEngine("TestFileSystem");
+		auto fsManager  = AnnGetFileSystemManager();
+
+		const AnnVect3 position { 1.5f, -2, 42 };
+		const AnnQuaternion orientation { 0.7071068f, 0, 0.7071068f, 0 };
+
+		for(auto format : { AnnSaveFileFormat::Binary, AnnSaveFileFormat::Text })
+		{
+			fsManager->setSaveFileFormat(format);
+
+			//Write
+			{
+				auto fileData = fsManager->crateSaveFileDataObject("TestTypedSave");
+				fileData->setValue("name", "Annwvyn");
+				fileData->setValue("lives", 3);
+				fileData->setValue("health", 0.75f);
+				fileData->setValue("position", position);
+				fileData->setValue("orientation", orientation);
+				fsManager->getFileWriter()->write(fileData);
+				REQUIRE_FALSE(fileData->hasUnsavedChanges());
+				fsManager->releaseSaveFileDataObject(fileData);
+			}
+
+			//Read
+			{
+				auto fileData = fsManager->getFileReader()->read("TestTypedSave");
+				REQUIRE(fileData);
+				REQUIRE(fileData->getValue("name") == "Annwvyn");
+				REQUIRE(fileData->getInt("lives") == 3);
+				REQUIRE(fileData->getFloat("health") == 0.75f);
+				REQUIRE(fileData->getVect3("position") == position);
+				REQUIRE(fileData->getQuaternion("orientation") == orientation);
+				REQUIRE_FALSE(fileData->hasValue("doNotExist"));
+
+				//Components are still reachable the way text files stored them
+				REQUIRE(std::stof(fileData->getValue("position.z")) == 42);
+				fsManager->releaseSaveFileDataObject(fileData);
+			}
+		}
+
+		fsManager->setSaveFileFormat(AnnSaveFileFormat::Binary);
+	}
+
+	TEST_CASE("FileSystem background saves are coalesced")
+	{
+		auto GameEngine = bootstrapTestEngine("TestFileSystem");
+		auto fsManager  = AnnGetFileSystemManager();
+		auto writer		= fsManager->getFileWriter();
+		writer->setCoalesceDelay(std::chrono::milliseconds(500));
+
+		auto fileData = fsManager->crateSaveFileDataObject("TestAsyncSave");
+		fileData->setValue("counter", 1);
+		auto first = writer->writeAsync(fileData);
+		fileData->setValue("counter", 2);
+		auto second = writer->writeAsync(fileData);
+		fsManager->releaseSaveFileDataObject(fileData);
+
+		//Both saves are the same write, with the last snapshot
+		REQUIRE(first == second);
+		REQUIRE(writer->isWriting("TestAsyncSave"));
+		writer->waitForPendingWrites();
+		REQUIRE_FALSE(writer->hasPendingWrites());
+		REQUIRE(first.get());
+
+		auto readData = fsManager->getFileReader()->read("TestAsyncSave");
+		REQUIRE(readData);
+		REQUIRE(readData->getInt("counter") == 2);
+		fsManager->releaseSaveFileDataObject(readData);
+	}
+
+	TEST_CASE("FileSystem synchronous save replaces a pending background save")
+	{
+		auto GameEngine = bootstrapTestEngine("TestFileSystem");
+		auto fsManager  = AnnGetFileSystemManager();
+		auto writer		= fsManager->getFileWriter();
+		writer->setCoalesceDelay(std::chrono::milliseconds(500));
+
+		auto fileData = fsManager->crateSaveFileDataObject("TestSyncAfterAsync");
+		fileData->setValue("counter", 1);
+		auto background = writer->writeAsync(fileData);
+		fileData->setValue("counter", 2);
+		writer->write(fileData);
+		fsManager->releaseSaveFileDataObject(fileData);
+
+		//The older snapshot is never written over the newer one
+		REQUIRE_FALSE(writer->isWriting("TestSyncAfterAsync"));
+		REQUIRE(background.get());
+		writer->waitForPendingWrites();
+
+		auto readData = fsManager->getFileReader()->read("TestSyncAfterAsync");
+		REQUIRE(readData);
+		REQUIRE(readData->getInt("counter") == 2);
+		fsManager->releaseSaveFileDataObject(readData);
+	}
+
+	TEST_CASE("FileSystem journaled saves")
+	{
+		auto GameEngine = bootstrapTestEngine("TestFileSystem");
+		auto fsManager  = AnnGetFileSystemManager();
+		auto writer		= fsManager->getFileWriter();
+
+		const auto readFile = [](const std::string& path) {
+			std::ifstream file(path, std::ios::binary);
+			return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		};
+		const auto path		   = fsManager->getPathForFileName("TestJournal");
+		const auto journalPath = path + ".journal";
+		writer->setJournalCompactionThreshold(64 * 1024);
+
+		//First save of the session writes the whole file, and an empty journal
+		auto fileData = fsManager->crateSaveFileDataObject("TestJournal");
+		fileData->setValue("name", "Annwvyn");
+		fileData->setValue("level", 1);
+		fileData->setValue("position", AnnVect3 { 1, 2, 3 });
+		REQUIRE(writer->writeJournaled(fileData));
+		REQUIRE_FALSE(fileData->hasUnsavedChanges());
+		const auto snapshot		 = readFile(path);
+		const auto emptyJournal = readFile(journalPath);
+		REQUIRE_FALSE(snapshot.empty());
+		REQUIRE_FALSE(emptyJournal.empty());
+
+		//Next ones only append the changes
+		fileData->setValue("level", 2);
+		fileData->clearValue("name");
+		REQUIRE(writer->writeJournaled(fileData));
+		const auto journalSize = readFile(journalPath).size();
+		REQUIRE(journalSize > emptyJournal.size());
+		fileData->setValue("score", 42.5f);
+		REQUIRE(writer->writeJournaled(fileData));
+		REQUIRE(readFile(journalPath).size() > journalSize);
+		REQUIRE(readFile(path) == snapshot);
+
+		auto readData = fsManager->getFileReader()->read("TestJournal");
+		REQUIRE(readData);
+		REQUIRE(readData->getInt("level") == 2);
+		REQUIRE(readData->getFloat("score") == 42.5f);
+		REQUIRE(readData->getVect3("position") == AnnVect3 { 1, 2, 3 });
+		REQUIRE_FALSE(readData->hasValue("name"));
+		REQUIRE_FALSE(readData->hasUnsavedChanges());
+		fsManager->releaseSaveFileDataObject(readData);
+
+		//Over the threshold, the file is compacted : written in full, with an empty journal again
+		writer->setJournalCompactionThreshold(readFile(journalPath).size());
+		fileData->setValue("level", 3);
+		REQUIRE(writer->writeJournaled(fileData));
+		fsManager->releaseSaveFileDataObject(fileData);
+		REQUIRE(readFile(path) != snapshot);
+		REQUIRE(readFile(journalPath).size() == emptyJournal.size());
+		writer->setJournalCompactionThreshold(64 * 1024);
+
+		readData = fsManager->getFileReader()->read("TestJournal");
+		REQUIRE(readData);
+		REQUIRE(readData->getInt("level") == 3);
+		REQUIRE(readData->getFloat("score") == 42.5f);
+		fsManager->releaseSaveFileDataObject(readData);
+	}
 }
@@ -17,6 +17,15 @@ namespace Annwvyn
 		REQUIRE(object->getName() == name);
 		REQUIRE(AnnGetGameObjectManager()->getGameObject(name) == object);
 		REQUIRE(AnnGetGameObjectManager()->getGameObject(name)->getName() == name);
+
+		//Same lookup through the interned string ID
+		const auto id = AnnGetStringUtility()->find(name);
+		REQUIRE(id != AnnInvalidStringID);
+		REQUIRE(object->getNameID() == id);
+		REQUIRE(AnnGetStringUtility()->intern(name) == id);
+		REQUIRE(AnnGetStringUtility()->getString(id) == name);
+		REQUIRE(AnnGetGameObjectManager()->getGameObject(id) == object);
+		REQUIRE(AnnGetEngine()->getSubSystemByName(AnnGetStringUtility()->find("GameObjectManager")) == AnnGetGameObjectManager());
 	}
 
 	TEST_CASE("Game object add remove")
@@ -35,6 +44,126 @@ namespace Annwvyn
 		for(auto i = 0; i < 60; ++i) GameEngine->refresh();
 	}
 
+	TEST_CASE("Game object bulk remove")
+	{
+		auto GameEngine = bootstrapTestEngine("GameObjectManagerTest");
+
+		auto manager	= AnnGetGameObjectManager();
+		auto physics	= AnnGetPhysicsEngine();
+		const auto bodyCount = physics->getWorld()->getNumCollisionObjects();
+		{
+			AnnGameObjectList objects;
+			for(auto i = 0; i < 16; ++i)
+			{
+				auto object = manager->createGameObject("Sinbad.mesh", "BulkSinbad" + std::to_string(i));
+				object->setupPhysics(10, boxShape);
+				objects.push_back(object);
+			}
+			auto kept = manager->createGameObject("Sinbad.mesh", "KeptSinbad");
+			kept->setupPhysics(10, boxShape);
+			REQUIRE(physics->getWorld()->getNumCollisionObjects() == bodyCount + 17);
+
+			for(auto i = 0; i < 10; ++i) GameEngine->refresh();
+
+			manager->removeGameObjects(objects);
+			REQUIRE(physics->getWorld()->getNumCollisionObjects() == bodyCount + 1);
+			REQUIRE_FALSE(manager->getGameObject("BulkSinbad0"));
+			REQUIRE(manager->getGameObject("KeptSinbad") == kept);
+		}
+
+		for(auto i = 0; i < 10; ++i) GameEngine->refresh();
+	}
+
+	TEST_CASE("Game object physics with a prebuilt shape")
+	{
+		auto GameEngine = bootstrapTestEngine("GameObjectManagerTest");
+
+		auto manager = AnnGetGameObjectManager();
+		auto physics = AnnGetPhysicsEngine();
+		auto parent  = manager->createGameObject("Sinbad.mesh", "ParentSinbad");
+		auto child   = manager->createGameObject("Sinbad.mesh", "ChildSinbad");
+		parent->attachChildObject(child);
+
+		child->_setupPhysics(10, physics->_getGameObjectShapeAsync(child.get(), boxShape).get());
+		REQUIRE(child->getBody());
+
+		//Same hierarchy checks as setupPhysics()
+		REQUIRE_THROWS_AS(parent->_setupPhysics(10, physics->_getGameObjectShapeAsync(parent.get(), boxShape).get()), AnnPhysicsSetupChildError);
+		REQUIRE_FALSE(parent->getBody());
+	}
+
+	TEST_CASE("Game object async creation")
+	{
+		auto GameEngine = bootstrapTestEngine("GameObjectManagerTest");
+
+		auto manager = AnnGetGameObjectManager();
+		auto callbackCalled{ false };
+		auto future = manager->createGameObjectAsync("Sinbad.mesh", "AsyncSinbad", std::make_shared<AnnGameObject>(),
+			[&](std::shared_ptr<AnnGameObject> object) { callbackCalled = object != nullptr; });
+
+		//The object is finished on the main thread, by the engine refresh
+		for(auto i = 0; i < 600 && future.wait_for(std::chrono::seconds(0)) != std::future_status::ready; ++i)
+			GameEngine->refresh();
+
+		REQUIRE(future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+		auto object = future.get();
+		REQUIRE(object);
+		REQUIRE(callbackCalled);
+		REQUIRE(object->getName() == "AsyncSinbad");
+		REQUIRE(manager->getGameObject("AsyncSinbad") == object);
+	}
+
+	//Count the update() calls the manager makes, and the time they cover
+	class UpdateCounter : public AnnGameObject
+	{
+	public:
+		void update() override
+		{
+			++calls;
+			coveredTime += getUpdateDeltaTime();
+		}
+
+		unsigned calls { 0 };
+		double coveredTime { 0 };
+	};
+
+	TEST_CASE("Game object update LOD")
+	{
+		auto GameEngine = bootstrapTestEngine("GameObjectManagerTest");
+
+		const AnnGameObjectManager::UpdateLodTier nearTier { 10, 1, 1, 1 }, farTier { 1000, 4, 4, 4 };
+		auto manager = AnnGetGameObjectManager();
+		manager->setUpdateLodTiers({ nearTier, farTier });
+		manager->setUpdateLodInvisiblePenalty(0);
+		manager->setUpdateLodEnabled(true);
+		REQUIRE(manager->isUpdateLodEnabled());
+
+		auto nearObject = std::make_shared<UpdateCounter>();
+		auto farObject  = std::make_shared<UpdateCounter>();
+		manager->createGameObject("Sinbad.mesh", "NearSinbad", nearObject);
+		manager->createGameObject("Sinbad.mesh", "FarSinbad", farObject);
+		nearObject->setPosition({ 0, 0, -2 });
+		farObject->setPosition({ 0, 0, -500 });
+
+		//Over a multiple of the interval, an object is updated once per interval whatever the phase its name gives it
+		const unsigned frames = 15 * farTier.scriptInterval;
+		double elapsed { 0 }, longestFrame { 0 };
+		for(unsigned i { 0 }; i < frames; ++i)
+		{
+			GameEngine->refresh();
+			elapsed += GameEngine->getFrameTime();
+			longestFrame = std::max(longestFrame, GameEngine->getFrameTime());
+		}
+
+		REQUIRE(nearObject->calls == frames / nearTier.scriptInterval);
+		REQUIRE(farObject->calls == frames / farTier.scriptInterval);
+
+		//Skipped frames are given to the next update, at most interval - 1 frames are still waiting for it
+		REQUIRE(nearObject->coveredTime == Approx(elapsed));
+		REQUIRE(farObject->coveredTime <= Approx(elapsed));
+		REQUIRE(farObject->coveredTime >= Approx(elapsed - (farTier.scriptInterval - 1) * longestFrame));
+	}
+
 	TEST_CASE("Light Object name storage")
 	{
 		//Init
@@ -85,5 +85,117 @@ namespace Annwvyn
 		for(auto i{ 0 }; i < 3 * 60; ++i)
 			if(!GameEngine->refresh())
 				break;
+
+		//Shapes are built by the workers, bodies are added when the level is loaded
+		REQUIRE(AnnGetGameObjectManager()->getGameObject("Sinbad")->getBody());
+		REQUIRE(AnnGetGameObjectManager()->getGameObject("Floor")->getBody());
+		REQUIRE_FALSE(AnnGetGameObjectManager()->getGameObject("Penguin")->getBody());
+	}
+
+	TEST_CASE("Preloading of JSON level")
+	{
+		auto GameEngine   = bootstrapEmptyEngine("JSON");
+		auto LevelManager = AnnGetLevelManager();
+
+		auto level = std::make_shared<AnnJsonLevel>(false, R"JSON(
+{
+	"name":"JsonPreloadLevel",
+	"player":{
+		"startPosition":[0.0, 0.0, 10.0],
+		"startOrientation":[0.0, 0.0, 0.0, 1.0]
+	},
+	"content" : [{
+		"name":"PreloadedSinbad",
+		"mesh":"Sinbad.mesh",
+		"position":[0.0, 1.0, 0.0],
+		"orientation":[0.0, 0.0, 0.0, 1.0],
+		"scale":[0.5, 0.5, 0.5],
+		"hasPhysics":false,
+		"scripts":null
+	}],
+	"lighting":[]
+}
+)JSON");
+
+		//The mesh is prepared while frames are rendered
+		LevelManager->preloadLevel(level);
+		REQUIRE(LevelManager->getLastLoadedLevel() == level);
+		for(auto i{ 0 }; i < 600 && !level->isPreloaded(); ++i)
+			GameEngine->refresh();
+		REQUIRE(level->isPreloaded());
+
+		LevelManager->switchToLevel(level);
+		for(auto i{ 0 }; i < 3; ++i)
+			GameEngine->refresh();
+		REQUIRE(LevelManager->getCurrentLevel() == level);
+		REQUIRE(AnnGetGameObjectManager()->getGameObject("PreloadedSinbad"));
+	}
+
+	TEST_CASE("Incremental loading of JSON level")
+	{
+		auto GameEngine   = bootstrapEmptyEngine("JSON");
+		auto LevelManager = AnnGetLevelManager();
+		LevelManager->setIncrementalLoading(true);
+		LevelManager->setLoadingBudget(0);
+
+		auto level = std::make_shared<AnnJsonLevel>(false, R"JSON(
+{
+	"name":"JsonIncrementalLevel",
+	"player":{
+		"startPosition":[0.0, 0.0, 10.0],
+		"startOrientation":[0.0, 0.0, 0.0, 1.0]
+	},
+	"content" : [{
+		"name":"IncrementalSinbad",
+		"mesh":"Sinbad.mesh",
+		"position":[0.0, 1.0, 0.0],
+		"orientation":[0.0, 0.0, 0.0, 1.0],
+		"scale":[0.5, 0.5, 0.5],
+		"hasPhysics":true,
+		"physics" : {
+			"shape":"box",
+			"mass":120.0,
+			"playerColide":true
+		},
+		"scripts":null
+	},
+	{
+		"name":"IncrementalFloor",
+		"mesh":"floorplane.mesh",
+		"position":[0.0, 0.0, 0.0],
+		"orientation":[0.0, 0.0, 0.0, 1.0],
+		"scale":[1.0, 1.0, 1.0],
+		"hasPhysics":true,
+		"physics" : {
+			"shape":"static",
+			"mass":0,
+			"playerColide":true
+		},
+		"scripts":null
+	}],
+	"lighting":[]
+}
+)JSON");
+
+		LevelManager->addLevel(level);
+		LevelManager->switchToLevel(level);
+
+		//Objects created while loading stay out of the physics
+		auto createdWhileLoading{ false };
+		for(auto i{ 0 }; i < 600; ++i)
+		{
+			GameEngine->refresh();
+			if(!LevelManager->isLoading()) break;
+			if(auto sinbad = AnnGetGameObjectManager()->getGameObject("IncrementalSinbad"))
+			{
+				createdWhileLoading = true;
+				REQUIRE_FALSE(sinbad->getBody());
+			}
+		}
+
+		REQUIRE(createdWhileLoading);
+		REQUIRE(LevelManager->getCurrentLevel() == level);
+		REQUIRE(AnnGetGameObjectManager()->getGameObject("IncrementalSinbad")->getBody());
+		REQUIRE(AnnGetGameObjectManager()->getGameObject("IncrementalFloor")->getBody());
 	}
 }
@@ -173,4 +173,214 @@ namespace Annwvyn
 		REQUIRE(result != std::end(levelContent));
 		REQUIRE(*result == sinbad);
 	}
+
+	TEST_CASE("Level manager incremental loading")
+	{
+		class TestLevelSteps : public TestLevel
+		{
+		public:
+			TestLevelSteps(size_t& steps, bool& finished) :
+			 TestLevel(),
+			 steps(steps),
+			 finished(finished)
+			{}
+
+			void beginLoad() override { steps = 0; }
+
+			LoadProgress loadStep() override { return ++steps == 10 ? LoadProgress::Done : LoadProgress::Progress; }
+
+			void finishLoad() override { finished = true; }
+
+		private:
+			size_t& steps;
+			bool& finished;
+		};
+
+		auto GameEngine   = bootstrapEmptyEngine("TestLevel");
+		auto levelManager = AnnGetLevelManager();
+		levelManager->setIncrementalLoading(true);
+		levelManager->setLoadingBudget(0);
+
+		size_t steps{ 0 };
+		auto finished{ false };
+		AnnLevelPtr first, second;
+		levelManager->addLevel(first = std::make_shared<TestLevel>());
+		levelManager->addLevel(second = std::make_shared<TestLevelSteps>(steps, finished));
+
+		levelManager->switchToLevel(first);
+		for(auto i{ 0 }; i < 3; ++i)
+			GameEngine->refresh();
+		REQUIRE(levelManager->getCurrentLevel() == first);
+
+		//With no budget, one step per frame. The first level stays current until the second is loaded
+		levelManager->switchToLevel(second);
+		GameEngine->refresh();
+		REQUIRE(levelManager->getLoadingLevel() == second);
+		for(auto i{ 0 }; i < 5; ++i)
+			GameEngine->refresh();
+		REQUIRE(levelManager->isLoading());
+		REQUIRE(levelManager->getCurrentLevel() == first);
+		REQUIRE_FALSE(finished);
+
+		for(auto i{ 0 }; i < 10; ++i)
+			GameEngine->refresh();
+		REQUIRE(steps == 10);
+		REQUIRE(finished);
+		REQUIRE_FALSE(levelManager->isLoading());
+		REQUIRE(levelManager->getCurrentLevel() == second);
+	}
+
+	TEST_CASE("Level manager waits for the workers until the next frame")
+	{
+		//Always waiting for something, until it's done
+		class TestLevelWaiting : public TestLevel
+		{
+		public:
+			TestLevelWaiting(size_t& steps) :
+			 TestLevel(),
+			 steps(steps)
+			{}
+
+			void beginLoad() override { steps = 0; }
+
+			LoadProgress loadStep() override { return ++steps == 5 ? LoadProgress::Done : LoadProgress::Waiting; }
+
+		private:
+			size_t& steps;
+		};
+
+		auto GameEngine   = bootstrapEmptyEngine("TestLevel");
+		auto levelManager = AnnGetLevelManager();
+		levelManager->setIncrementalLoading(true);
+		levelManager->setLoadingBudget(1000);
+
+		size_t steps { 0 };
+		AnnLevelPtr level;
+		levelManager->addLevel(level = std::make_shared<TestLevelWaiting>(steps));
+
+		//A whole second of budget, but a waiting level only gets one step per frame
+		levelManager->switchToLevel(level);
+		GameEngine->refresh();
+		REQUIRE(levelManager->getLoadingLevel() == level);
+		GameEngine->refresh();
+		REQUIRE(steps == 1);
+		GameEngine->refresh();
+		REQUIRE(steps == 2);
+
+		for(auto i { 0 }; i < 5; ++i)
+			GameEngine->refresh();
+		REQUIRE(steps == 5);
+		REQUIRE(levelManager->getCurrentLevel() == level);
+	}
+
+	class TestLevelIncremental : public TestLevel
+	{
+	public:
+		struct Counters
+		{
+			size_t beginLoads { 0 }, steps { 0 }, finishes { 0 }, abandons { 0 }, unloads { 0 };
+		};
+
+		TestLevelIncremental(Counters& counters, size_t stepCount) :
+		 TestLevel(),
+		 counters(counters),
+		 stepCount(stepCount)
+		{}
+
+		void beginLoad() override
+		{
+			counters.beginLoads++;
+			counters.steps = 0;
+		}
+
+		LoadProgress loadStep() override { return ++counters.steps >= stepCount ? LoadProgress::Done : LoadProgress::Progress; }
+
+		void finishLoad() override { counters.finishes++; }
+
+		void abandonLoad() override
+		{
+			TestLevel::abandonLoad();
+			counters.abandons++;
+		}
+
+		void unload() override
+		{
+			TestLevel::unload();
+			counters.unloads++;
+		}
+
+	private:
+		Counters& counters;
+		size_t stepCount;
+	};
+
+	TEST_CASE("Level manager abandons a half loaded level")
+	{
+		auto GameEngine   = bootstrapEmptyEngine("TestLevel");
+		auto levelManager = AnnGetLevelManager();
+		levelManager->setIncrementalLoading(true);
+		levelManager->setLoadingBudget(0);
+
+		TestLevelIncremental::Counters running, abandoned, next;
+		AnnLevelPtr first, second, third;
+		levelManager->addLevel(first = std::make_shared<TestLevelIncremental>(running, 1));
+		levelManager->addLevel(second = std::make_shared<TestLevelIncremental>(abandoned, 1000));
+		levelManager->addLevel(third = std::make_shared<TestLevelIncremental>(next, 1000));
+
+		levelManager->switchToLevel(first);
+		for(auto i { 0 }; i < 3; ++i)
+			GameEngine->refresh();
+		REQUIRE(levelManager->getCurrentLevel() == first);
+
+		//The running level keeps its gravity, and isn't unloaded
+		const AnnVect3 gravity { 0, -1, 0 };
+		AnnGetPhysicsEngine()->changeGravity(gravity);
+
+		levelManager->switchToLevel(second);
+		for(auto i { 0 }; i < 3; ++i)
+			GameEngine->refresh();
+		REQUIRE(levelManager->getLoadingLevel() == second);
+
+		levelManager->switchToLevel(third);
+		for(auto i { 0 }; i < 3; ++i)
+			GameEngine->refresh();
+		REQUIRE(levelManager->getLoadingLevel() == third);
+		REQUIRE(abandoned.abandons == 1);
+		REQUIRE(abandoned.unloads == 0);
+		REQUIRE(abandoned.finishes == 0);
+		REQUIRE(running.unloads == 0);
+		REQUIRE(levelManager->getCurrentLevel() == first);
+		REQUIRE(AnnVect3(AnnGetPhysicsEngine()->getWorld()->getGravity()) == gravity);
+	}
+
+	TEST_CASE("Level manager reloads the current level incrementally")
+	{
+		auto GameEngine   = bootstrapEmptyEngine("TestLevel");
+		auto levelManager = AnnGetLevelManager();
+		levelManager->setIncrementalLoading(true);
+		levelManager->setLoadingBudget(0);
+
+		TestLevelIncremental::Counters counters;
+		AnnLevelPtr level;
+		levelManager->addLevel(level = std::make_shared<TestLevelIncremental>(counters, 5));
+
+		levelManager->switchToLevel(level);
+		for(auto i { 0 }; i < 10; ++i)
+			GameEngine->refresh();
+		REQUIRE(levelManager->getCurrentLevel() == level);
+		REQUIRE(counters.finishes == 1);
+
+		//Unloaded before being built again, never after its new content exists
+		levelManager->switchToLevel(level);
+		GameEngine->refresh();
+		REQUIRE(counters.unloads == 1);
+		REQUIRE(counters.beginLoads == 2);
+		REQUIRE(levelManager->getLoadingLevel() == level);
+
+		for(auto i { 0 }; i < 10; ++i)
+			GameEngine->refresh();
+		REQUIRE(levelManager->getCurrentLevel() == level);
+		REQUIRE(counters.finishes == 2);
+		REQUIRE(counters.unloads == 1);
+	}
 }
@@ -0,0 +1,136 @@
+#include "engineBootstrap.hpp"
+
+#include <AnnPackArchive.hpp>
+#include <OgreArchiveManager.h>
+
+#include <algorithm>
+#include <fstream>
+#include <tuple>
+
+namespace Annwvyn
+{
+	//Write an uncompressed pack, laid out like AnnPackBuilder does
+	inline void writeTestPack(const std::string& path, std::vector<std::pair<std::string, std::string>> files, bool corruptIndex = false)
+	{
+		std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+			return std::make_tuple(AnnPackEntry::hash(a.first), a.first) < std::make_tuple(AnnPackEntry::hash(b.first), b.first);
+		});
+
+		std::string content(sizeof(AnnPackHeader), '\0'), nameTable;
+		std::vector<AnnPackEntry> entries;
+		for(const auto& file : files)
+		{
+			content.resize(size_t(AnnPackHeader::align(content.size())), '\0');
+
+			AnnPackEntry entry {};
+			entry.nameHash   = AnnPackEntry::hash(file.first);
+			entry.offset	 = content.size();
+			entry.size		 = file.second.size();
+			entry.storedSize = file.second.size();
+			entry.nameOffset = uint32_t(nameTable.size());
+			entry.nameLength = uint16_t(file.first.size());
+			entries.push_back(entry);
+
+			content += file.second;
+			nameTable += file.first;
+		}
+
+		//Data that would go past the end of the pack
+		if(corruptIndex) entries.front().storedSize = entries.front().size = 1 << 20;
+
+		content.resize(size_t(AnnPackHeader::align(content.size())), '\0');
+		const auto header = AnnPackHeader::make(uint32_t(entries.size()), content.size(), content.size() + entries.size() * sizeof(AnnPackEntry), uint32_t(nameTable.size()));
+		content.append(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AnnPackEntry));
+		content += nameTable;
+		std::copy_n(reinterpret_cast<const char*>(&header), sizeof header, content.begin());
+
+		std::ofstream(path, std::ios::binary).write(content.data(), std::streamsize(content.size()));
+	}
+
+	TEST_CASE("Resource pack archive")
+	{
+		auto GameEngine = bootstrapEmptyEngine("TestResourcePack");
+
+		const std::string path { "TestPack.annpak" };
+		writeTestPack(path, { { "hello.txt", "Hello pack" }, { "textures/data.bin", std::string(100, 'x') } });
+		AnnGetResourceManager()->addPackLocation(path, "TestPackGroup");
+
+		auto archive = Ogre::ArchiveManager::getSingleton().load(path, AnnPackArchive::type, true);
+		REQUIRE(archive);
+		REQUIRE(archive->exists("hello.txt"));
+		REQUIRE(archive->exists("textures/data.bin"));
+		REQUIRE_FALSE(archive->exists("missing.txt"));
+		REQUIRE_FALSE(archive->exists("Hello.txt"));
+
+		auto stream = archive->open("hello.txt");
+		REQUIRE(stream);
+		REQUIRE(stream->getAsString() == "Hello pack");
+		REQUIRE(archive->open("textures/data.bin")->size() == 100);
+		REQUIRE_FALSE(archive->open("missing.txt"));
+
+		const auto found = archive->find("textures/*");
+		REQUIRE(found->size() == 1);
+		REQUIRE(found->front() == "textures/data.bin");
+		REQUIRE(archive->list()->size() == 2);
+
+		//Same files through the resource group
+		REQUIRE(Ogre::ResourceGroupManager::getSingleton().resourceExists("TestPackGroup", "hello.txt"));
+		REQUIRE(Ogre::ResourceGroupManager::getSingleton().openResource("hello.txt", "TestPackGroup")->getAsString() == "Hello pack");
+	}
+
+	TEST_CASE("Resource pack archive rejects broken packs")
+	{
+		auto GameEngine = bootstrapEmptyEngine("TestResourcePack");
+
+		writeTestPack("CorruptedPack.annpak", { { "hello.txt", "Hello pack" } }, true);
+		AnnPackArchive corrupted("CorruptedPack.annpak", AnnPackArchive::type);
+		REQUIRE_THROWS_AS(corrupted.load(), Ogre::Exception);
+		REQUIRE_FALSE(corrupted.exists("hello.txt"));
+
+		std::ofstream("NotAPack.annpak", std::ios::binary) << "This is not a resource pack, but it is long enough to hold a header";
+		AnnPackArchive notAPack("NotAPack.annpak", AnnPackArchive::type);
+		REQUIRE_THROWS_AS(notAPack.load(), Ogre::Exception);
+	}
+
+	TEST_CASE("Resource group memory budget")
+	{
+		auto GameEngine      = bootstrapEmptyEngine("TestResourceBudget");
+		auto resourceManager = AnnGetResourceManager();
+
+		const std::string group { "BudgetTestGroup" };
+		resourceManager->addZipLocation("./TestLevel.zip", group);
+		Ogre::ResourceGroupManager::getSingleton().initialiseResourceGroup(group, true);
+		resourceManager->loadGroup(group);
+
+		//The totals are the sum of the types
+		const auto loaded = resourceManager->getGroupMemoryUsage(group);
+		REQUIRE(loaded.resourceCount > 0);
+		REQUIRE(loaded.getTotalBytes() > 0);
+		AnnResourceMemoryUsage sum {};
+		for(const auto& typeUsage : resourceManager->getGroupMemoryUsageByType(group))
+		{
+			sum.cpuBytes += typeUsage.second.cpuBytes;
+			sum.gpuBytes += typeUsage.second.gpuBytes;
+			sum.resourceCount += typeUsage.second.resourceCount;
+		}
+		REQUIRE(sum.cpuBytes == loaded.cpuBytes);
+		REQUIRE(sum.gpuBytes == loaded.gpuBytes);
+		REQUIRE(sum.resourceCount == loaded.resourceCount);
+
+		//Within budget, nothing moves
+		resourceManager->setGroupMemoryBudget(group, loaded.getTotalBytes());
+		REQUIRE(resourceManager->getGroupMemoryBudget(group) == loaded.getTotalBytes());
+		for(auto i = 0; i < 5; ++i) GameEngine->refresh();
+		REQUIRE(resourceManager->getGroupMemoryUsage(group).getTotalBytes() == loaded.getTotalBytes());
+
+		//Over it, resources nothing references are unloaded
+		resourceManager->setGroupMemoryBudget(group, 1);
+		for(auto i = 0; i < 5; ++i) GameEngine->refresh();
+		const auto budgeted = resourceManager->getGroupMemoryUsage(group);
+		REQUIRE(budgeted.resourceCount < loaded.resourceCount);
+		REQUIRE(budgeted.getTotalBytes() < loaded.getTotalBytes());
+
+		resourceManager->setGroupMemoryBudget(group, 0);
+		REQUIRE(resourceManager->getGroupMemoryBudget(group) == 0);
+	}
+}
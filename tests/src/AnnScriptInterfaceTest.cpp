@@ -32,6 +32,120 @@ namespace Annwvyn
 		REQUIRE(ogre->getPosition().y >= 5);
 	}
 
+	TEST_CASE("Attach the same script class to many objects")
+	{
+		auto GameEngine = bootstrapEmptyEngine("TestScript");
+
+		auto ResourceManager = AnnGetResourceManager();
+		ResourceManager->addFileLocation("./unitTestScripts");
+		ResourceManager->initResources();
+
+		//The class is compiled by the first attach, the others only construct an instance
+		auto GameObjectManager = AnnGetGameObjectManager();
+		std::vector<std::shared_ptr<AnnGameObject>> ogres;
+		for(auto i{ 0 }; i < 32; ++i)
+		{
+			ogres.push_back(GameObjectManager->createGameObject("Sinbad.mesh", "Ogre" + std::to_string(i)));
+			ogres.back()->attachScript("GoUpBehavior");
+		}
+
+		for(auto counter{ 0 }; counter < 60 && GameEngine->refresh(); ++counter)
+			;
+
+		for(const auto& ogre : ogres)
+			REQUIRE(ogre->getPosition().y >= 1);
+	}
+
+	TEST_CASE("Behavior script event dispatch")
+	{
+		auto GameEngine = bootstrapEmptyEngine("TestScript");
+
+		auto ResourceManager = AnnGetResourceManager();
+		ResourceManager->addFileLocation("./unitTestScripts");
+		ResourceManager->initResources();
+
+		auto ScriptManager = AnnGetScriptManager();
+		auto chai		   = ScriptManager->_getEngine();
+
+		//TimeEvent is defined when MouseCounter is compiled, but only for TimeCounter
+		const auto timeCounter  = ScriptManager->getBehaviorScript("TimeCounter");
+		const auto mouseCounter = ScriptManager->getBehaviorScript("MouseCounter");
+		REQUIRE(timeCounter->isValid());
+		REQUIRE(mouseCounter->isValid());
+
+		AnnBehaviorScriptDispatcher dispatcher;
+		dispatcher.add(timeCounter.get());
+		dispatcher.add(mouseCounter.get());
+		REQUIRE(dispatcher.getScriptCount(TimeHook) == 1);
+		REQUIRE(dispatcher.getScriptCount(MouseHook) == 1);
+		REQUIRE(dispatcher.getScriptCount(KeyHook) == 0);
+
+		//Each event only reaches the class that implements it
+		dispatcher.TimeEvent(AnnTimeEvent());
+		dispatcher.TimeEvent(AnnTimeEvent());
+		dispatcher.MouseEvent(AnnMouseEvent());
+		REQUIRE(chai->eval<int>("timeEvents") == 2);
+		REQUIRE(chai->eval<int>("mouseEvents") == 1);
+
+		dispatcher.remove(mouseCounter.get());
+		REQUIRE(dispatcher.getScriptCount(MouseHook) == 0);
+		REQUIRE_FALSE(dispatcher.empty());
+		dispatcher.remove(timeCounter.get());
+		REQUIRE(dispatcher.empty());
+
+		//A hook removes its own script, and a script that is not called yet
+		const auto timeRemover = ScriptManager->getBehaviorScript("TimeRemover");
+		REQUIRE(timeRemover->isValid());
+		dispatcher.add(timeRemover.get());
+		dispatcher.add(timeCounter.get());
+		chai->add(chaiscript::fun([&] {
+					  dispatcher.remove(timeRemover.get());
+					  dispatcher.remove(timeCounter.get());
+				  }),
+				  "removeTimeScripts");
+
+		dispatcher.TimeEvent(AnnTimeEvent());
+		REQUIRE(chai->eval<int>("timeEvents") == 2);
+		REQUIRE(dispatcher.getScriptCount(TimeHook) == 0);
+		REQUIRE(dispatcher.empty());
+
+		//The table is usable after the removals
+		dispatcher.add(timeCounter.get());
+		dispatcher.TimeEvent(AnnTimeEvent());
+		REQUIRE(chai->eval<int>("timeEvents") == 3);
+	}
+
+	TEST_CASE("Script profiler")
+	{
+		auto GameEngine = bootstrapEmptyEngine("TestScript");
+
+		auto ResourceManager = AnnGetResourceManager();
+		ResourceManager->addFileLocation("./unitTestScripts");
+		ResourceManager->initResources();
+
+		auto ScriptManager = AnnGetScriptManager();
+		auto ogre		   = AnnGetGameObjectManager()->createGameObject("Sinbad.mesh", "ProfiledOgre");
+		ogre->attachScript("GoUpBehavior");
+
+		//Nothing is recorded until the profiler is enabled
+		for(auto counter{ 0 }; counter < 10 && GameEngine->refresh(); ++counter)
+			;
+		REQUIRE(ScriptManager->getProfileReport().empty());
+
+		ScriptManager->setProfilingEnabled(true);
+		for(auto counter{ 0 }; counter < 10 && GameEngine->refresh(); ++counter)
+			;
+		ScriptManager->setProfilingEnabled(false);
+
+		const auto report = ScriptManager->getProfileReport();
+		REQUIRE(report.size() == 1);
+		REQUIRE(report[0].find("GoUpBehavior::update calls: ") == 0);
+		REQUIRE(ScriptManager->dumpProfile("./script_profile.csv"));
+
+		ScriptManager->resetProfile();
+		REQUIRE(ScriptManager->getProfileReport().empty());
+	}
+
 	TEST_CASE("Object manipulation via scripting")
 	{
 		//Get the engine components
@@ -0,0 +1,103 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+//Convert every sound file of a directory into cooked PCM (.annpcm) files the audio engine uploads without decoding them.
+//Usage : AnnAudioCooker <input directory> [output directory]
+
+#include <AnnCookedAudio.hpp>
+
+#include <sndfile.h>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Annwvyn::AnnCookedAudioHeader;
+
+//Only try to open files that look like sound files
+bool isAudioFile(const fs::path& path)
+{
+	auto extension = path.extension().string();
+	std::transform(std::begin(extension), std::end(extension), std::begin(extension), [](unsigned char c) { return char(std::tolower(c)); });
+
+	static const std::vector<std::string> audioExtensions { ".wav", ".ogg", ".flac", ".aif", ".aiff" };
+	return std::find(std::begin(audioExtensions), std::end(audioExtensions), extension) != std::end(audioExtensions);
+}
+
+bool cook(const fs::path& input, const fs::path& output)
+{
+	SF_INFO info {};
+	const auto file = sf_open(input.string().c_str(), SFM_READ, &info);
+	if(!file)
+	{
+		std::cerr << "Cannot open " << input << " : " << sf_strerror(nullptr) << '\n';
+		return false;
+	}
+
+	if(info.channels != 1 && info.channels != 2)
+	{
+		std::cerr << input << " has " << info.channels << " channels, only mono and stereo are supported\n";
+		sf_close(file);
+		return false;
+	}
+
+	//Same conversion as the engine does at load time
+	sf_command(file, SFC_SET_CLIPPING, nullptr, SF_TRUE);
+	std::vector<int16_t> samples(size_t(info.frames * info.channels));
+	const auto frames = sf_readf_short(file, samples.data(), info.frames);
+	samples.resize(size_t(frames * info.channels));
+	sf_close(file);
+
+	fs::create_directories(output.parent_path());
+	std::ofstream cooked(output, std::ios::binary);
+	if(!AnnCookedAudioHeader::write(cooked, uint16_t(info.channels), uint32_t(info.samplerate), samples))
+	{
+		std::cerr << "Cannot write " << output << '\n';
+		return false;
+	}
+
+	std::cout << input << " -> " << output << " (" << frames << " frames, " << info.channels << " channels, " << info.samplerate << "Hz)\n";
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "Usage : " << argv[0] << " <input directory> [output directory]\n";
+		return 1;
+	}
+
+	const fs::path inputDirectory { argv[1] };
+	const fs::path outputDirectory { argc > 2 ? argv[2] : argv[1] };
+
+	std::error_code error;
+	if(!fs::is_directory(inputDirectory, error))
+	{
+		std::cerr << inputDirectory << " is not a directory\n";
+		return 1;
+	}
+
+	size_t cookedCount = 0, failedCount = 0;
+	for(const auto& entry : fs::recursive_directory_iterator(inputDirectory))
+	{
+		if(!entry.is_regular_file() || !isAudioFile(entry.path())) continue;
+
+		//Keep the directory layout, just change the extension
+		auto output = outputDirectory / fs::relative(entry.path(), inputDirectory);
+		output.replace_extension(AnnCookedAudioHeader::extension);
+
+		if(cook(entry.path(), output))
+			++cookedCount;
+		else
+			++failedCount;
+	}
+
+	std::cout << cookedCount << " files cooked, " << failedCount << " failed\n";
+	return failedCount == 0 ? 0 : 2;
+}
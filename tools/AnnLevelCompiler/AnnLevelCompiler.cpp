@@ -0,0 +1,63 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+//Validate a JSON level and compile it into a binary level (.annlvl) that AnnCompiledLevel reads without parsing.
+//Usage : AnnLevelCompiler <input json level> [output level]
+
+#include "AnnLevelCompiler.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+using namespace AnnLevelCompiler;
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "Usage : " << argv[0] << " <input json level> [output level]\n";
+		return 1;
+	}
+
+	const fs::path input { argv[1] };
+	auto output = argc > 2 ? fs::path { argv[2] } : fs::path { input }.replace_extension(AnnCompiledLevelHeader::extension);
+
+	std::ifstream inputFile(input);
+	if(!inputFile)
+	{
+		std::cerr << "Cannot open " << input << '\n';
+		return 1;
+	}
+
+	CompiledLevel compiled;
+	try
+	{
+		json_t level;
+		inputFile >> level;
+		compiled = compile(level);
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << input << " : " << e.what() << '\n';
+		return 2;
+	}
+
+	std::ofstream outputFile(output, std::ios::binary);
+	if(!outputFile)
+	{
+		std::cerr << "Cannot write " << output << '\n';
+		return 2;
+	}
+
+	compiled.write(outputFile);
+	if(!outputFile)
+	{
+		std::cerr << "Cannot write " << output << '\n';
+		return 2;
+	}
+
+	std::cout << input << " -> " << output << " (" << compiled.objects.size() << " objects, " << compiled.lights.size() << " lights, " << compiled.strings.strings.size() << " strings)\n";
+	return 0;
+}
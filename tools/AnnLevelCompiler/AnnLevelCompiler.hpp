@@ -0,0 +1,238 @@
+#pragma once
+
+//Core of the AnnLevelCompiler tool : validate a JSON level and write it as a binary level (.annlvl) that AnnCompiledLevel reads without parsing.
+//Header only, so the tests can compile levels the way the tool does
+
+#include <AnnCompiledLevelFormat.hpp>
+#include <json.hpp>
+
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace AnnLevelCompiler
+{
+	using json_t = nlohmann::json;
+	using namespace Annwvyn;
+
+	//Thrown with a message that says where the level is wrong
+	struct LevelError : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	//Each string is stored once
+	class StringTable
+	{
+	public:
+		uint32_t intern(const std::string& text)
+		{
+			const auto existing = indices.find(text);
+			if(existing != std::end(indices)) return existing->second;
+
+			const auto index = uint32_t(strings.size());
+			strings.push_back({ uint32_t(data.size()), uint32_t(text.size()) });
+			data += text;
+			indices.emplace(text, index);
+			return index;
+		}
+
+		std::vector<AnnCompiledLevelString> strings;
+		std::string data;
+
+	private:
+		std::unordered_map<std::string, uint32_t> indices;
+	};
+
+	inline const json_t& require(const json_t& j, const char* key, const std::string& context)
+	{
+		if(!j.is_object() || j.find(key) == std::end(j) || j[key].is_null())
+			throw LevelError(context + " has no \"" + key + "\"");
+		return j[key];
+	}
+
+	inline std::string requireString(const json_t& j, const char* key, const std::string& context)
+	{
+		const auto& value = require(j, key, context);
+		if(!value.is_string()) throw LevelError(context + "." + key + " must be a string");
+		return value.get<std::string>();
+	}
+
+	inline float requireNumber(const json_t& j, const char* key, const std::string& context)
+	{
+		const auto& value = require(j, key, context);
+		if(!value.is_number()) throw LevelError(context + "." + key + " must be a number");
+		return value.get<float>();
+	}
+
+	inline bool requireBool(const json_t& j, const char* key, const std::string& context)
+	{
+		const auto& value = require(j, key, context);
+		if(!value.is_boolean()) throw LevelError(context + "." + key + " must be true or false");
+		return value.get<bool>();
+	}
+
+	template <size_t Size>
+	void requireFloats(const json_t& j, const char* key, const std::string& context, float (&output)[Size])
+	{
+		const auto& value = require(j, key, context);
+		if(!value.is_array() || value.size() != Size) throw LevelError(context + "." + key + " must be an array of " + std::to_string(Size) + " numbers");
+		for(size_t i { 0 }; i < Size; ++i)
+		{
+			if(!value[i].is_number()) throw LevelError(context + "." + key + " must be an array of " + std::to_string(Size) + " numbers");
+			output[i] = value[i].get<float>();
+		}
+	}
+
+	inline uint8_t shapeFromString(const std::string& shape, const std::string& context)
+	{
+		if(shape == "static") return AnnCompiledLevelObject::StaticShape;
+		if(shape == "convex") return AnnCompiledLevelObject::ConvexShape;
+		if(shape == "box") return AnnCompiledLevelObject::BoxShape;
+		if(shape == "cylinder") return AnnCompiledLevelObject::CylinderShape;
+		if(shape == "capsule") return AnnCompiledLevelObject::CapsuleShape;
+		if(shape == "sphere") return AnnCompiledLevelObject::SphereShape;
+		throw LevelError(context + " has an unknown physics shape \"" + shape + "\"");
+	}
+
+	inline uint8_t lightTypeFromString(const std::string& type, const std::string& context)
+	{
+		if(type == "point") return AnnCompiledLevelLight::Point;
+		if(type == "directional") return AnnCompiledLevelLight::Directional;
+		if(type == "spot") return AnnCompiledLevelLight::Spotlight;
+		throw LevelError(context + " has an unknown light type \"" + type + "\"");
+	}
+
+	template <class T>
+	void writeTable(std::ostream& output, uint64_t& offset, const std::vector<T>& table)
+	{
+		static const char zeros[8] {};
+		const auto aligned = AnnCompiledLevelHeader::align(offset);
+		output.write(zeros, std::streamsize(aligned - offset));
+		output.write(reinterpret_cast<const char*>(table.data()), std::streamsize(table.size() * sizeof(T)));
+		offset = aligned + table.size() * sizeof(T);
+	}
+
+	//Tables of a level, ready to be written
+	struct CompiledLevel
+	{
+		StringTable strings;
+		std::vector<AnnCompiledLevelResource> resources;
+		std::vector<AnnCompiledLevelObject> objects;
+		std::vector<AnnCompiledLevelLight> lights;
+		std::vector<uint32_t> scripts;
+		AnnCompiledLevelHeader header {};
+
+		//Write the level file. The offsets of the header are set here
+		void write(std::ostream& output)
+		{
+			//Header is written again when the offsets are known
+			output.write(reinterpret_cast<const char*>(&header), sizeof header);
+			uint64_t offset = sizeof header;
+
+			header.stringsOffset = AnnCompiledLevelHeader::align(offset);
+			writeTable(output, offset, strings.strings);
+			header.stringDataOffset = AnnCompiledLevelHeader::align(offset);
+			header.stringDataSize   = strings.data.size();
+			writeTable(output, offset, std::vector<char>(std::begin(strings.data), std::end(strings.data)));
+			header.resourcesOffset = AnnCompiledLevelHeader::align(offset);
+			writeTable(output, offset, resources);
+			header.objectsOffset = AnnCompiledLevelHeader::align(offset);
+			writeTable(output, offset, objects);
+			header.lightsOffset = AnnCompiledLevelHeader::align(offset);
+			writeTable(output, offset, lights);
+			header.scriptsOffset = AnnCompiledLevelHeader::align(offset);
+			writeTable(output, offset, scripts);
+
+			output.seekp(0);
+			output.write(reinterpret_cast<const char*>(&header), sizeof header);
+		}
+	};
+
+	//Validate a JSON level and build its tables. Throw LevelError when something is missing or has the wrong type
+	inline CompiledLevel compile(const json_t& level)
+	{
+		CompiledLevel compiled;
+		auto& strings = compiled.strings;
+		auto& header  = compiled.header;
+
+		header.name = strings.intern(requireString(level, "name", "level"));
+
+		const auto& player = require(level, "player", "level");
+		requireFloats(player, "startPosition", "player", header.playerPosition);
+		requireFloats(player, "startOrientation", "player", header.playerOrientation);
+
+		if(level.find("resources") != std::end(level) && !level["resources"].is_null())
+			for(const auto& jsonResource : level["resources"])
+			{
+				//No group means the default one, the engine knows its name
+				AnnCompiledLevelResource resource {};
+				resource.group = strings.intern(jsonResource.find("group") != std::end(jsonResource) && !jsonResource["group"].is_null() ? requireString(jsonResource, "group", "resource") : "");
+				resource.path  = strings.intern(requireString(jsonResource, "path", "resource"));
+				resource.type  = strings.intern(requireString(jsonResource, "type", "resource"));
+				compiled.resources.push_back(resource);
+			}
+
+		if(level.find("content") != std::end(level))
+			for(const auto& jsonObject : level["content"])
+			{
+				const auto context = "object \"" + requireString(jsonObject, "name", "object " + std::to_string(compiled.objects.size())) + "\"";
+
+				AnnCompiledLevelObject object {};
+				object.name = strings.intern(requireString(jsonObject, "name", context));
+				object.mesh = strings.intern(requireString(jsonObject, "mesh", context));
+				requireFloats(jsonObject, "position", context, object.position);
+				requireFloats(jsonObject, "orientation", context, object.orientation);
+				requireFloats(jsonObject, "scale", context, object.scale);
+
+				object.hasPhysics = requireBool(jsonObject, "hasPhysics", context);
+				if(object.hasPhysics)
+				{
+					const auto& physics  = require(jsonObject, "physics", context);
+					object.mass			 = requireNumber(physics, "mass", context + ".physics");
+					object.shape		 = shapeFromString(requireString(physics, "shape", context + ".physics"), context);
+					object.playerCollide = requireBool(physics, "playerColide", context + ".physics");
+				}
+
+				object.firstScript = uint32_t(compiled.scripts.size());
+				if(jsonObject.find("scripts") != std::end(jsonObject) && !jsonObject["scripts"].is_null())
+					for(const auto& script : jsonObject["scripts"])
+					{
+						if(!script.is_string()) throw LevelError(context + " has a script name that is not a string");
+						compiled.scripts.push_back(strings.intern(script.get<std::string>()));
+					}
+				object.scriptCount = uint32_t(compiled.scripts.size()) - object.firstScript;
+
+				compiled.objects.push_back(object);
+			}
+
+		if(level.find("lighting") != std::end(level))
+			for(const auto& jsonLight : level["lighting"])
+			{
+				const auto context = "light \"" + requireString(jsonLight, "name", "light " + std::to_string(compiled.lights.size())) + "\"";
+
+				AnnCompiledLevelLight light {};
+				light.name  = strings.intern(requireString(jsonLight, "name", context));
+				light.type  = lightTypeFromString(requireString(jsonLight, "type", context), context);
+				light.power = requireNumber(jsonLight, "power", context);
+				if((light.hasPosition = jsonLight.find("position") != std::end(jsonLight)))
+					requireFloats(jsonLight, "position", context, light.position);
+				if((light.hasDirection = jsonLight.find("direction") != std::end(jsonLight)))
+					requireFloats(jsonLight, "direction", context, light.direction);
+
+				compiled.lights.push_back(light);
+			}
+
+		header.magic		 = AnnCompiledLevelHeader::expectedMagic;
+		header.version		 = AnnCompiledLevelHeader::currentVersion;
+		header.stringCount	= uint32_t(strings.strings.size());
+		header.resourceCount = uint32_t(compiled.resources.size());
+		header.objectCount   = uint32_t(compiled.objects.size());
+		header.lightCount	= uint32_t(compiled.lights.size());
+		header.scriptCount   = uint32_t(compiled.scripts.size());
+
+		return compiled;
+	}
+}
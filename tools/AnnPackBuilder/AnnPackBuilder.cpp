@@ -0,0 +1,172 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++ and C#: http://www.viva64.com
+
+//Put every file of a directory in an Annwvyn resource pack (.annpak), to be mounted with AnnResourceManager::addPackLocation.
+//Usage : AnnPackBuilder <input directory> <output pack> [--lz4]
+
+#include <AnnPackFormat.hpp>
+
+#ifdef ANNWVYN_PACK_LZ4
+#include <lz4hc.h>
+#endif
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Annwvyn::AnnPackEntry;
+using Annwvyn::AnnPackHeader;
+
+//A file to put in the pack
+struct PackedFile
+{
+	std::string name;
+	std::vector<char> data;
+	AnnPackEntry entry;
+};
+
+bool readFile(const fs::path& path, std::vector<char>& data)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if(!file) return false;
+	data.resize(size_t(file.tellg()));
+	file.seekg(0);
+	return bool(file.read(data.data(), std::streamsize(data.size())));
+}
+
+#ifdef ANNWVYN_PACK_LZ4
+//Only keep the compressed data if it saves at least an eighth of the file, uncompressed entries are memory mapped
+void compress(PackedFile& file)
+{
+	std::vector<char> compressed(size_t(LZ4_compressBound(int(file.data.size()))));
+	const auto compressedSize = LZ4_compress_HC(file.data.data(), compressed.data(), int(file.data.size()), int(compressed.size()), LZ4HC_CLEVEL_MAX);
+	if(compressedSize <= 0 || size_t(compressedSize) > file.data.size() - file.data.size() / 8) return;
+
+	compressed.resize(size_t(compressedSize));
+	file.data				= std::move(compressed);
+	file.entry.storedSize  = file.data.size();
+	file.entry.compression = AnnPackEntry::LZ4;
+}
+#endif
+
+void pad(std::ofstream& pack, uint64_t offset)
+{
+	static const char zeros[AnnPackHeader::entryAlignment] {};
+	const auto padding = AnnPackHeader::align(offset) - offset;
+	pack.write(zeros, std::streamsize(padding));
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		std::cerr << "Usage : " << argv[0] << " <input directory> <output pack> [--lz4]\n";
+		return 1;
+	}
+
+	const fs::path inputDirectory { argv[1] };
+	const fs::path outputPack { argv[2] };
+	const auto useLZ4 = argc > 3 && std::string(argv[3]) == "--lz4";
+
+#ifndef ANNWVYN_PACK_LZ4
+	if(useLZ4)
+	{
+		std::cerr << "This AnnPackBuilder was built without LZ4 support (Annwvyn_Pack_LZ4)\n";
+		return 1;
+	}
+#endif
+
+	std::error_code error;
+	if(!fs::is_directory(inputDirectory, error))
+	{
+		std::cerr << inputDirectory << " is not a directory\n";
+		return 1;
+	}
+
+	std::vector<PackedFile> files;
+	for(const auto& directoryEntry : fs::recursive_directory_iterator(inputDirectory))
+	{
+		if(!directoryEntry.is_regular_file() || fs::equivalent(directoryEntry.path(), outputPack, error)) continue;
+
+		//Names always use '/', whatever the platform the pack is built on
+		PackedFile file;
+		file.name = fs::relative(directoryEntry.path(), inputDirectory).generic_string();
+		if(file.name.size() > UINT16_MAX || !readFile(directoryEntry.path(), file.data))
+		{
+			std::cerr << "Cannot pack " << directoryEntry.path() << '\n';
+			return 2;
+		}
+
+		file.entry			   = {};
+		file.entry.nameHash	= AnnPackEntry::hash(file.name);
+		file.entry.size		   = file.data.size();
+		file.entry.storedSize  = file.data.size();
+		file.entry.compression = AnnPackEntry::None;
+#ifdef ANNWVYN_PACK_LZ4
+		if(useLZ4) compress(file);
+#endif
+
+		files.push_back(std::move(file));
+	}
+
+	//Index order, the archive does a binary search on it
+	std::sort(std::begin(files), std::end(files), [](const PackedFile& a, const PackedFile& b) {
+		return std::tie(a.entry.nameHash, a.name) < std::tie(b.entry.nameHash, b.name);
+	});
+
+	std::ofstream pack(outputPack, std::ios::binary);
+	if(!pack)
+	{
+		std::cerr << "Cannot write " << outputPack << '\n';
+		return 2;
+	}
+
+	//Header is written again when the offsets are known
+	auto header = AnnPackHeader::make(uint32_t(files.size()), 0, 0, 0);
+	pack.write(reinterpret_cast<const char*>(&header), sizeof header);
+	uint64_t offset = sizeof header;
+
+	std::string nameTable;
+	uint64_t packedSize = 0, totalSize = 0;
+	for(auto& file : files)
+	{
+		pad(pack, offset);
+		offset = AnnPackHeader::align(offset);
+
+		file.entry.offset	 = offset;
+		file.entry.nameOffset = uint32_t(nameTable.size());
+		file.entry.nameLength = uint16_t(file.name.size());
+		nameTable += file.name;
+
+		pack.write(file.data.data(), std::streamsize(file.data.size()));
+		offset += file.data.size();
+		packedSize += file.entry.storedSize;
+		totalSize += file.entry.size;
+	}
+
+	pad(pack, offset);
+	header.indexOffset = offset = AnnPackHeader::align(offset);
+	for(const auto& file : files)
+		pack.write(reinterpret_cast<const char*>(&file.entry), sizeof file.entry);
+	offset += files.size() * sizeof(AnnPackEntry);
+
+	header.nameTableOffset = offset;
+	header.nameTableSize   = uint32_t(nameTable.size());
+	pack.write(nameTable.data(), std::streamsize(nameTable.size()));
+
+	pack.seekp(0);
+	pack.write(reinterpret_cast<const char*>(&header), sizeof header);
+	if(!pack)
+	{
+		std::cerr << "Cannot write " << outputPack << '\n';
+		return 2;
+	}
+
+	std::cout << files.size() << " files packed in " << outputPack << " (" << packedSize << " bytes stored for " << totalSize << " bytes of content)\n";
+	return 0;
+}